@@ -199,6 +199,52 @@
 //                       - Changed to "FFT windowed" rather that "Nuttall Fig 12 Window" for filter name.
 //
 //                   => github release of 4v2
+// 4v3 17/10/2026 3a - When a comma seperated list of y columns is given all the traces are now read in a single pass through the csv file
+//                      (previously the file was read once for every trace). Compression for multiple traces is now always done by compress_y().
+//                3b - csv file is now memory mapped when adding traces (if possible) which avoids copying every line (see csv-reader.c)
+//                3c - big csv files are read by multiple threads (when y values are column numbers and x values are not times/dates)
+//                3d - faster conversion of "simple" numbers by fast_strtof(), all y values on a line are converted in one call when reading with multiple threads
+//                3e - values read from big csv files are saved in a "sidecar" file (filename.csvgraph-cache) so they can be loaded much faster next time (see csv-cache.c)
+//                3f - count_lines() also creates an index of the offset of every 65536th line. This is used to split big files between threads on line boundaries,
+//                      to skip lines quickly and to show progress in lines.
+//                3g - arrays for traces now grow as points are added, so the number of lines in the file is only needed as an estimate.
+//                      Lines in big files on network drives are no longer counted when the file is opened.
+//                3h - when y is an expression only the columns up to the highest $n used in the expression are split up when reading the file (was all columns).
+//                3i - File/Follow file option. When ticked lines appended to a file (eg a log file that is still being written) are added to the traces read from it.
+//                      The file is checked every second and only the new lines are read.
+//                3j - gzip (.gz) and zstd (.zst) compressed csv files can be read directly, they are decompressed in another thread while the lines are being read (see csv-decompress.c).
+//                      Lines in compressed files are not counted when the file is opened (the number of lines is estimated from the 1st part of the file).
+//                3k - when y values are column numbers and x values are not times/dates the file is read by worker thread(s) even if its not big, the main thread just adds
+//                      the values read to the traces. Traces are redrawn regularly while the file is being read so they can be seen (and zoomed) before all of the file has been read.
+//                3l - the date/time format for x values is compiled once (see ya_strptime_compile() in strptime.c) rather than being interpreted for every line,
+//                      and the seconds at the start of a day are only calculated when the date changes.
+//                3m - for x values that are times the layout of the 1st line (hh:mm:ss or yyyy-mm-dd hh:mm:ss) is remembered, lines with the same layout are then read
+//                      without looking for a date and the time is converted by gethms_days_fast().
+//                3n - File/Preview (sample of file) option. When ticked add trace only reads lines from evenly spaced blocks of a big file so a preview is shown in a few seconds.
+//                      Adding the same traces from the same file with preview unticked then replaces the preview with all of the file.
+//                3o - when a file is opened rows from across the file are sampled to profile each column (integer/decimal/time/text, quotes and range of values).
+//                      The profile is shown in the column lists, warns if a text column is used for y and sets the layout of times before the file is read.
+//                      If no quotes were found lines are split by parsecsv_noquotes(), and y columns that only held integers are read with fast_strtof_int().
+//                3p - data can be read from stdin (filename "-", eg decoder | csvgraph -) or a pipe. These cannot be seeked so lines are not counted,
+//                      traces grow as lines are read and progress is shown as lines and bytes read. All the traces wanted must be added at once as a stream can only be read once.
+//                3q - x values in a column (x types value, value/60 etc) are converted to a double by fast_strtod() (correctly rounded), and are divided and offset (if "start time from 0" is ticked)
+//                      before they are converted to a float. So big values (eg secs since 1970 or nanosecond counters) keep their resolution.
+//                3r - count_lines() and reading files that cannot be memory mapped use a separate thread to read the file in big blocks, so reading the disk overlaps
+//                      counting/parsing the lines.
+//                3s - a set of files (eg rotated log files) can be read as one file: drag and drop several files, give several filenames on the command line,
+//                      or a filename with wildcards (eg run_*.csv). The header line must be the same in all the files. Files are read in order of their names
+//                      (numbers in names are compared as numbers), or if the x values are in a column in order of the 1st x value in each file.
+//                3t - traces added together from a csv file share one array of x values (a trace gets its own copy if its x values are different, or are changed eg by sorting or an FFT).
+//                      This nearly halves the RAM needed when several traces are added from a big file.
+//                3u - x values that are exactly evenly spaced (eg line numbers, or a fixed sample rate) are not stored, but calculated from the index when needed.
+//                      Filters, derivatives etc calculate them as they go (or use a temporary copy), so the x values stay implicit.
+//                3v - traces that use a large part of the RAM in the PC are compressed in RAM (in blocks of 4096 values, see float-compress.c). The graph is drawn directly from the
+//                      compressed values, using the min/max values held for each block to skip blocks that are all in one pixel column. Filters etc uncompress a trace first.
+//                3w - blocks of y values that are (possibly scaled) 12 or 16 bit ADC readings are compressed to 16 bits per value. File/Compress traces in RAM compresses all
+//                      traces added, optionally allowing y values to change by up to a given max error (so more blocks can be stored in 16 bits).
+//                3x - File/Keep traces in scratch files moves the values of traces just read into memory mapped scratch files in a directory chosen by the user (see scratch-file.c),
+//                      so traces much bigger than the RAM in the PC can be loaded without the pagefile thrashing. The least recently drawn traces are removed from RAM first.
+//                      Big traces are moved while the file is read (so RAM is not needed for all of a trace), and lines added to a followed file are added to the scratch files.
 // TO DO:
 //
 // WARNING : in builder 11 with 64 bit code generation long double is only 8 bytes (the same as double!).
@@ -269,6 +315,13 @@
 #include "multiple-lin-reg-fn.h"
 #include "time_local.h"
 #include "getfloat.h"
+#include "csv-reader.h"
+#include "csv-cache.h"
+#include "csv-decompress.h" /* for csv_read_ahead_open() */
+#include "scratch-file.h"
+#include <io.h> /* for _open_osfhandle() */
+#include <fcntl.h> /* for _O_RDONLY etc */
+#include <process.h> /* for _beginthreadex() */
 #include <psapi.h> /* for PROCESS_MEMORY_COUNTERS_EX2 */
 
 
@@ -292,12 +345,24 @@ const char * Prog_Name="CSVgraph (Github) 4v3 (32 bit)";   // needs to be global
 #if 1 /* if 1 then use fast_strtof() rather than atof() for floating point conversion. Note in this application this is only slightly faster (1-5%) */
 extern "C" float fast_strtof(const char *s,char **endptr); // if endptr != NULL returns 1st character thats not in the number
 #define strtof fast_strtof  /* set so we use it in place of strtof() */
+extern "C" void fast_strtof_array(char * const s[],float f[],char *endptr[],size_t n); // f[i]=fast_strtof(s[i],&endptr[i]) for i=0..n-1 (endptr may be NULL)
+extern "C" double fast_strtod(const char *s,char **endptr); // as strtod() (so correctly rounded) but faster for "simple" numbers
+extern "C" float fast_strtof_int(const char *s,char **endptr); // as fast_strtof() but faster for integers (used for columns that the profile found only hold integers)
+#else
+#define fast_strtod strtod
+#define fast_strtof_int strtof
+static void fast_strtof_array(char * const s[],float f[],char *endptr[],size_t n) // f[i]=strtof(s[i],&endptr[i]) for i=0..n-1
+{for(size_t i=0;i<n;++i)
+	f[i]=strtof(s[i],&endptr[i]);
+}
 #endif
 #define WHITE_BACKGROUND /* if defined then use a white background, otherwise use a black background*/
 #define UseVCLdialogs /* if defined used VCL dialogs, otherwise use "raw" windows ones */
-#define BIG_BUF_SIZE (128*1024) /* Should be a power of 2. 1024*1024=1MB . Testing showed 4K is the min for moderate performance, and after 256k performance gets slightly worse */
-  /* times to read 2 columns from a 2BG file are no buf 126secs, 4k 78s, 8k 72s, 16k 71s, 32k 70s, 64k 69s, 128k 68s, 256k 68s, 512k 69s, 1024k 69s, 4096k 71s */
 #define CL_BLOCK_SIZE (1024*1024) /* must be a bigish power of 2 , used for count_lines() function to quickly count lines in file 1M seems to be best on my PC */
+#define ESTIMATE_LINES_MIN_BYTES (64*1024*1024) /* if defined, lines in files on network drives at least this big are not counted when the file is opened (the number of lines is estimated instead) */
+#define COMPRESSED_SAMPLE_LINES 10000 /* number of lines read when a compressed file is opened to estimate the number of lines in it */
+#define PROFILE_BLOCKS 20 /* when a file is opened this many evenly spaced blocks of it are read to profile the columns ... */
+#define PROFILE_BLOCK_LINES 100 /* ... with this many lines read from each block */
 
 #define P_UNUSED(x) (void)x; /* a way to avoid warning unused parameter messages from the compiler */
 
@@ -424,9 +489,33 @@ float yval,xval; // current values being added to graph, xval is set before yval
 
 // dynamic number of columns
 static char **col_ptrs=NULL,**hdr_col_ptrs=NULL; // pointers to strings for each field
+static unsigned int nos_col_ptrs=MAX_COLS; // number of entries in col_ptrs[] set by the last call to parsecsv()
+// profile of the columns in the current file, found from a sample of lines when the file is opened
+#define COL_EMPTY 0 /* no values found */
+#define COL_INT 1 /* integers */
+#define COL_DECIMAL 2 /* numbers, at least one of which is not an integer */
+#define COL_TIME 3 /* times (hh:mm:ss) possibly with a date */
+#define COL_TEXT 4 /* anything else (or a mixture of the above) */
+struct col_profile
+	{int type;          // COL_xxx
+	 int time_layout;   // TIME_LAYOUT_xxx if type is COL_TIME
+	 bool quoted;       // true if any value is in double quotes
+	 size_t nos_values; // number of (non empty) values sampled
+	 size_t nos_numbers;// number of values that are numbers
+	 float min,max;     // range of numbers found
+	};
+static struct col_profile *col_profiles=NULL; // malloc'ed, nos_col_profiles entries
+static unsigned int nos_col_profiles=0;
+static csv_reader *stream_fin=NULL; // stdin or a pipe opened by proces_open_filename(). This is kept open till its read to add traces as it cannot be opened again
 static char *col_names=NULL; // copy of input line, used to keep column heading strings
 static unsigned int MAX_COLS=0;
 static AnsiString filename;
+static void follow_stop(void); // stop adding lines appended to a file to its traces
+#define LINE_INDEX_STEP 65536 /* count_lines() saves the offset of the start of every LINE_INDEX_STEP'th line of the file in line_index[] */
+static int64_t *line_index=NULL; // line_index[i] is the offset in the file of the start of line i*LINE_INDEX_STEP (0 is the 1st line in the file)
+static size_t line_index_size=0; // number of entries in line_index[]
+static AnsiString line_index_filename; // file that line_index[] is for
+static int64_t line_index_filesize=0; // size of file when line_index[] was created (lines can be added to the file, but offsets of existing lines cannot change)
 const static char *default_x_label="Horizontal axis title";
 const static char *default_y_label="Vertical axis title";
 
@@ -545,9 +634,17 @@ char *getsaveCSVfilename()    // for saving files : displays getfilename dialog
          // process the file in 'buff'
          proces_open_filename(buff); // process file
         }
-   else
-        { ShowMessage("Error: you can only drag one file at a time onto CSVgraph");
-        }
+   else if(numFiles>1)
+		{// several files, read them as one file (a "set" of files, see csv-reader.c) - names are separated by |
+		 AnsiString names="";
+		 for(unsigned int i=0;i<numFiles;++i)
+			{wchar_t wbuff[MAX_PATH];
+			 DragQueryFileW(hDrop, i, wbuff, MAX_PATH);
+			 if(i>0) names+="|";
+			 names+=Utf8Of(wbuff);
+			}
+		 proces_open_filename(names.c_str());
+		}
 #else
    // accept multiple filenames - csvgraph cannot really deal with this and the code below effectively just loads the last one
    for (int i=0;i < numFiles;i++)
@@ -629,6 +726,8 @@ __fastcall TPlotWindow::TPlotWindow(TComponent* Owner) : TForm(Owner)
 //---------------------------------------------------------------------------
 void __fastcall TPlotWindow::FormDestroy(TObject *Sender)
 { P_UNUSED(Sender);
+  Timer_follow->Enabled=false;
+  follow_stop();
   delete pScientificGraph;                  //free memory
 }
 //---------------------------------------------------------------------------
@@ -1102,7 +1201,9 @@ void __fastcall TPlotWindow::Button_clear_all_traces1Click(TObject *Sender)
   rprintf("Clear all traces button pressed\n");
   StatusText->Caption="Clearing all traces ...";
   Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+  follow_stop(); // traces being followed are about to be deleted
   pScientificGraph->fnClearAll();  //clear all graphs
+  sample.filename=""; // no preview to replace
   line_colour=0; // always start with the same line colour
   Edit_x->Text=default_x_label;
   pScientificGraph->XLabel=default_x_label;
@@ -1146,7 +1247,7 @@ extern "C" double get_dollar_var_value(pnlist p) /* get value of $ variable */
 			}
 #endif
 		 // if not $Tn must just be $n
-         if(col_ptrs==NULL || i>= MAX_COLS || col_ptrs[i]==NULL || *(col_ptrs[i])==0 ) return NAN;
+         if(col_ptrs==NULL || i>= MAX_COLS || i>=nos_col_ptrs || col_ptrs[i]==NULL || *(col_ptrs[i])==0 ) return NAN;
          if(count<10)
                 {rprintf("call to get_dollar_var_value(), i=%u, $i=%s (%g)\n",i,(i<MAX_COLS)?col_ptrs[i]:"error",(i<MAX_COLS)?atof(col_ptrs[i]):0.0);
                  count++;
@@ -1208,6 +1309,7 @@ void TPlotWindow::gen_lin_reg(enum reg_types r,int N,bool write_y,int iGraph)
 	 if(A!=NULL) free(A);
 	 if(X!=NULL) free(X);
 	 if(U!=NULL) free(U);
+	 pScientificGraph->fnFreexarr(x_arr,iGraph);
 	 return;
 	}
   filter_callback(0,3);
@@ -1351,6 +1453,7 @@ void TPlotWindow::gen_lin_reg(enum reg_types r,int N,bool write_y,int iGraph)
   filter_callback(3,3);
   fr_matrix_ld(S);
   free(A);free(X);free(U); // free up dynamically allocated arrays   we know none are NULL as this is trapped much earlier
+  pScientificGraph->fnFreexarr(x_arr,iGraph); // x values may be a temporary copy
  }
 
 #if 1
@@ -1364,7 +1467,10 @@ void deriv_trace(int iGraph)
   double d,ld;
   size_t iCount=Form1->pPlotWindow->pScientificGraph->fnGetxyarr(&x_arr,&y_arr,iGraph); // allows access to x and y arrays of specified graph, returns nos points
   size_t i,j,k;
-  if(iCount<2) return;
+  if(iCount<2)
+	{Form1->pPlotWindow->pScientificGraph->fnFreexarr(x_arr,iGraph);
+	 return;
+	}
   // 1st point - can only look forward to next point
   if(x_arr[1]==x_arr[0]) ld=0;// avoid divide by zero when x value does not change
   else ld=(y_arr[1]-y_arr[0])/(x_arr[1]-x_arr[0]); // slope
@@ -1382,6 +1488,7 @@ void deriv_trace(int iGraph)
   else d=(y_arr[i]-y_arr[k])/(x_arr[i]-x_arr[k]); // slope
   y_arr[k]=(float)ld; // previous point
   y_arr[i]=(float)d; // last point
+  Form1->pPlotWindow->pScientificGraph->fnFreexarr(x_arr,iGraph); // x values may be a temporary copy
 }
 #endif
 
@@ -1391,7 +1498,10 @@ static void integral_trace(int iGraph)
   double integral=0;
   size_t iCount=Form1->pPlotWindow->pScientificGraph->fnGetxyarr(&x_arr,&y_arr,iGraph); // allows access to x and y arrays of specified graph, returns nos points
   size_t i,j;
-  if(iCount<2) return;
+  if(iCount<2)
+	{Form1->pPlotWindow->pScientificGraph->fnFreexarr(x_arr,iGraph);
+	 return;
+	}
   y_i=y_arr[0]; // need this before its overwritten
   y_arr[0]=0;         // 1st point has integral zero
   for(i=0; i<iCount-1;++i)  // for all the rest of the points add in extra area between adjacent points
@@ -1400,11 +1510,1008 @@ static void integral_trace(int iGraph)
 	 y_i=y_arr[j];// this y[j] will be y[i] in the next iteration  (its about to be overwritten).
 	 y_arr[j]=(float)integral;
 	}
+  Form1->pPlotWindow->pScientificGraph->fnFreexarr(x_arr,iGraph); // x values may be a temporary copy
+}
+
+#define MAX_ERRS 2 /* max errors that will be displayyed in full */
+/* defined below allow 1 example of each error type to be displayed to the user */
+#define ERR_TYPE1 0
+#define ERR_TYPE2 1
+#define ERR_TYPE3 2
+#define ERR_TYPE4 3
+#define ERR_TYPE5 4
+#define ERR_TYPE6 5
+#define ERR_TYPE7 6
+#define MAX_ERR_TYPES 7
+
+// information kept for each trace while a set of traces is being added (all traces are read in a single pass through the csv file)
+struct add_trace_item
+	{int ycol;             // column for y values (1..MAX_COLS), 1 if yexpr is true
+	 bool yexpr;           // true if y values are given by an expression rather than a column number
+	 char *se;             // expression (if yexpr is true) - malloc'ed
+	 saved_rpn *rpn;       // compiled version of se - malloc'ed
+	 int iGraph;           // graph number for this trace
+	 bool firstxvalue;     // true till 1st valid point added to trace
+	 bool gotyvalue;       // set to true when a valid number found for y value
+	 bool xmonotonic;      // true if trace is monotonic in x
+	 float previousxvalue;
+	 size_t nos_errs;      // count of lines skipped due to errors in y value for this trace
+	 const float *cached_y;// y values for this trace from sidecar file (NULL if values are read from the csv file)
+	 int cache_col;        // column in csv_cache_writer for y values (-1 if y values are not being saved)
+	 bool int_col;         // true if only integers were found in column ycol when the file was opened, so fast_strtof_int() is used for its values
+	 size_t preview_pts;   // number of points included in preview_xmin etc below
+	 float preview_xmin,preview_xmax,preview_ymin,preview_ymax; // range of points read so far (used to show traces while the file is being read)
+	 char cap_str[256];    // caption for trace   (used for error messages later as well as graph caption)
+	};
+
+static void free_add_trace_items(struct add_trace_item *items,int nos_items) // free items[] and all memory it points to
+{if(items==NULL) return;
+ for(int i=0;i<nos_items;++i)
+	{if(items[i].se!=NULL) free(items[i].se);
+	 if(items[i].rpn!=NULL) free(items[i].rpn);
+	}
+ free(items);
+}
+
+#define FOLLOW_MAX_READ (64*1024*1024) /* max bytes read from a file being followed in one update, so the user interface stays responsive */
+static struct follow_state // information needed to add lines appended to a file to the traces that were read from it
+	{bool active;         // true while following a file
+	 AnsiString filename; // file being followed
+	 int64_t offset;      // offset in file of the start of the next line to be read
+	 size_t lines_in_file;// lines read so far (x value when x=linenumber)
+	 int xtype,xcol;      // Xcol_type->ItemIndex and xcol when traces were added
+	 unsigned int max_col;// highest column that needs to be split by parsecsv()
+	 char *date_time_fmt; // malloc'ed (NULL if not used)
+	 strp_compiled *date_time_c; // date_time_fmt compiled (NULL if not used or it could not be compiled)
+	 double x_offset;
+	 bool firstxvalue;
+	 long double first_time;
+	 bool file_has_dates;
+	 bool any_yexpr;
+	 struct add_trace_item *traces; // traces being added to - malloc'ed
+	 int nos_traces,max_traces;
+	 size_t nos_errs,nos_xerrs;
+	 bool found_error_type[MAX_ERR_TYPES];
+	} follow;
+
+static void follow_stop(void) // stop following a file and free all memory used to do this
+{if(follow.traces!=NULL) free_add_trace_items(follow.traces,follow.max_traces);
+ follow.traces=NULL;
+ if(follow.date_time_fmt!=NULL) free(follow.date_time_fmt);
+ follow.date_time_fmt=NULL;
+ ya_strptime_free(follow.date_time_c);
+ follow.date_time_c=NULL;
+ follow.active=false;
+}
+
+static void close_csv(csv_reader *r) // close r, unless its a stream (stdin or a pipe) that has not been read yet, which is kept open as it cannot be opened again
+{if(r!=stream_fin) csv_close(r);
+}
+
+static bool add_point_to_trace(TScientificGraph *pGraph,struct add_trace_item *tp,float x,float x_plus_offset,float y) // add point to trace tp checking if x values are monotonic, returns false if out of RAM
+{if(tp->firstxvalue)
+	tp->firstxvalue=false;
+ else if(x<tp->previousxvalue)
+	tp->xmonotonic=false; // x value is NOT monotonically increasing  (equal values are OK)
+ tp->previousxvalue=x;
+ // rprintf("before addDatapoint: x=%g y=%g iGraph=%d\n",x_plus_offset,y,tp->iGraph);
+ return pGraph->fnAddDataPoint(x_plus_offset,y,tp->iGraph);
+}
+
+#define PREVIEW_INTERVAL ((clock_t)CLOCKS_PER_SEC) /* traces being read are redrawn this often (in clock() ticks) so they can be seen while the rest of the file is read */
+
+// File/Preview (sample of file) - only reads SAMPLE_BLOCK_LINES lines from each of SAMPLE_BLOCKS evenly spaced blocks of a big file
+#define SAMPLE_MIN_BYTES (64*1024*1024) /* smaller files are always read in full as this is quick */
+#define SAMPLE_BLOCKS 2000
+#define SAMPLE_BLOCK_LINES 100
+static struct sample_state // traces added as a preview, these are replaced when the same file is read again
+	{AnsiString filename; // file previewed ("" if none)
+	 int first_graph,nos_graphs; // graphs added for the preview
+	 int line_colour; // line_colour before the preview was added, so the traces that replace it have the same colours
+	} sample;
+
+static bool preview_scales(TScientificGraph *pGraph,struct add_trace_item *traces,int nos_traces,bool first_graph) // set scales so all points read so far are visible (unless zoomed), returns true if graph should be redrawn
+{double xmin=0,xmax=0,ymin=0,ymax=0;
+ bool got_pts=false;
+ for(int t=0;t<nos_traces;++t)
+	{struct add_trace_item *tp=&traces[t];
+	 size_t nos_points=pGraph->fnGetNumberOfDataPoints(tp->iGraph); // values are only read here, so they are left stored as they are
+	 if(nos_points==0) continue;
+	 if(tp->preview_pts==0)
+		{tp->preview_xmin=tp->preview_xmax=pGraph->fnGetXval(0,tp->iGraph);
+		 tp->preview_ymin=tp->preview_ymax=pGraph->fnGetYval(0,tp->iGraph);
+		}
+	 for(size_t i=tp->preview_pts;i<nos_points;++i) // only look at points added since the last call
+		{float x=pGraph->fnGetXval(i,tp->iGraph),y=pGraph->fnGetYval(i,tp->iGraph);
+		 if(x<tp->preview_xmin) tp->preview_xmin=x;
+		 if(x>tp->preview_xmax) tp->preview_xmax=x;
+		 if(y<tp->preview_ymin) tp->preview_ymin=y;
+		 if(y>tp->preview_ymax) tp->preview_ymax=y;
+		}
+	 tp->preview_pts=nos_points;
+	 if(!got_pts || tp->preview_xmin<xmin) xmin=tp->preview_xmin;
+	 if(!got_pts || tp->preview_xmax>xmax) xmax=tp->preview_xmax;
+	 if(!got_pts || tp->preview_ymin<ymin) ymin=tp->preview_ymin;
+	 if(!got_pts || tp->preview_ymax>ymax) ymax=tp->preview_ymax;
+	 got_pts=true;
+	}
+ if(!got_pts) return false; // nothing to show yet
+ if(zoomed) return true; // user has zoomed in, so leave scales alone
+ if(xmax<=xmin) return false; // wait till there is a range of x values
+ double dy=(ymax-ymin)*0.1; // leave space above & below traces as fnAutoScale() does
+ if(dy==0) dy= ymax!=0 ? fabs(ymax)*0.1 : 1.0;
+ ymin-=dy;
+ ymax+=dy;
+ if(!first_graph)
+	{// make sure traces already on the graph stay visible
+	 if(pGraph->fnGetScaleXMin()<xmin) xmin=pGraph->fnGetScaleXMin();
+	 if(pGraph->fnGetScaleXMax()>xmax) xmax=pGraph->fnGetScaleXMax();
+	 if(pGraph->fnGetScaleYMin()<ymin) ymin=pGraph->fnGetScaleYMin();
+	 if(pGraph->fnGetScaleYMax()>ymax) ymax=pGraph->fnGetScaleYMax();
+	}
+ pGraph->fnSetScales(xmin,xmax,ymin,ymax);
+ pGraph->fnOptimizeGrids();
+ return true;
+}
+
+static bool line_index_valid(int64_t filesize) // returns true if line_index[] can be used for the current file (filename) which is filesize bytes
+{return line_index!=NULL && line_index_size>0 && line_index_filename==filename && filesize>=line_index_filesize;
+}
+
+static bool line_index_lookup(size_t line,int64_t filesize,int64_t *offset,size_t *line_at_offset) // finds the indexed line at or before line (0=1st line in file), returns false if there is no valid index
+{size_t i=line/LINE_INDEX_STEP;
+ if(!line_index_valid(filesize)) return false;
+ if(i>=line_index_size) i=line_index_size-1;
+ *offset=line_index[i];
+ *line_at_offset=i*LINE_INDEX_STEP;
+ return true;
+}
+
+static int64_t line_start_after(int64_t offset,int64_t filesize) // returns offset of the start of the 1st indexed line at or after offset, or offset if there is no suitable line in the index
+{size_t lo=0,hi;
+ if(!line_index_valid(filesize)) return offset;
+ hi=line_index_size;
+ while(lo<hi)
+	{size_t mid=lo+(hi-lo)/2;
+	 if(line_index[mid]<offset) lo=mid+1;
+	 else hi=mid;
+	}
+ if(lo>=line_index_size || line_index[lo]>=filesize) return offset;
+ return line_index[lo];
+}
+
+/* Big files can be read by multiple threads, each thread reads part of the file (a "chunk") splitting lines into columns and converting numbers.
+   The results are then added to the traces (in file order) by the main thread, which also reports errors in the same way as when the file is read by a single thread.
+   This is only used when all y values are simple column numbers (expressions use global variables)
+   and x values do not depend on previous lines (so not for times/dates where days are counted and times are relative to the 1st time in the file).
+   Multiple threads need the file to be memory mapped, otherwise (or if the file is not big) one thread reads all of the file.
+   Each thread passes the values it reads to the main thread in batches of CHUNK_BATCH_PTS points, so the main thread can add them to the traces (and show them)
+   while the rest of the file is being read.
+*/
+#define PARALLEL_READ_MIN_BYTES (16*1024*1024) /* files smaller than this are read by a single thread, as its quick anyway */
+#define PARALLEL_READ_MIN_CHUNK (4*1024*1024) /* min number of bytes of the file for each thread to read */
+#define COMPRESS_TRACES_RAM_FRACTION 4 /* traces just read are compressed in RAM if they use more than 1/COMPRESS_TRACES_RAM_FRACTION of the physical RAM of the PC (0 => only when File/Compress traces is ticked) */
+static float compress_max_error=0; // max error allowed in y values when File/Compress traces in RAM is ticked (0 => y values are kept exactly)
+#define SCRATCH_RAM_FRACTION 2 /* when traces are kept in scratch files at most 1/SCRATCH_RAM_FRACTION of the physical RAM of the PC is used for their values, the least recently drawn traces are removed from RAM first */
+#define MAX_CHUNK_ERRS (MAX_ERRS+MAX_ERR_TYPES) /* enough to show the same error messages as when the file is read by a single thread */
+#define CHUNK_BATCH_PTS 65536 /* number of points in each batch passed from a thread reading a chunk to the main thread */
+
+#define USE_CSV_CACHE /* if defined, values read from big csv files are saved in a "sidecar" file (see csv-cache.c) so they can be loaded quickly if the same columns are read again */
+#define CSV_CACHE_MIN_BYTES (64*1024*1024) /* sidecar files are only used for csv files at least this big */
+
+struct chunk_err // an error found by a thread reading a chunk, so it can be reported later in the correct order
+	{size_t line;         // line number in chunk (1 for 1st line)
+	 size_t err_nos;      // this was the err_nos'th error found in this chunk
+	 int err_type;        // ERR_TYPEn
+	 char xy;             // 'x' or 'y'
+	 char *text;          // copy of field with the error - malloc'ed
+	};
+
+struct chunk_batch // values read by a thread, passed to the main thread when full (or at the end of the chunk)
+	{struct chunk_batch *next; // next batch in file order
+	 size_t nos_pts;      // number of lines with a valid x value
+	 float *x;            // x values (not used if xtype==0 as x is line number)
+	 size_t *line_nos;    // line number in chunk (only used if xtype==0 or keep_line_nos is true)
+	 float **y;           // y[nos_traces][CHUNK_BATCH_PTS]
+	 bool **valid;        // valid[nos_traces][CHUNK_BATCH_PTS], false if no number was found for y[t][i] (a number like "nan" or "inf" is valid here, as it is for the main thread)
+	};
+
+struct parse_chunk // one part of a csv file being read by a thread
+	{csv_reader *r;       // reader for this part of the file
+	 bool close_r;        // true if r was opened for this chunk (so it needs to be closed when the chunk is freed)
+	 int64_t start;       // offset in file of start of this chunk (used to show progress)
+	 int xtype;           // Xcol_type->ItemIndex
+	 int xcol;
+	 double x_origin;     // subtracted from x values before they are converted to floats (1st x value in file if start_time_from_0 is true)
+	 unsigned int max_col;// max column number needed
+	 struct add_trace_item *traces; // only ycol and int_col are used by thread
+	 int nos_traces;
+	 bool any_int_col;    // true if int_col is set for any of traces[]
+	 bool no_quotes;      // true if no quotes were found in the columns needed when the file was opened, so parsecsv_noquotes() is used
+	 bool keep_line_nos;  // if true line_nos[] is set for every point (needed to save values in a sidecar file)
+	 int64_t stop_at;     // if >0 stop before a line that ends after this offset (a file that will be followed may have an incomplete last line)
+	 volatile LONG64 bytes_read; // updated regularly by thread (via InterlockedExchange64() so its atomic even for 32 bit code) so progress can be shown
+	 volatile size_t lines_read;  // updated with bytes_read
+	 volatile bool stop;  // set by main thread to ask thread to stop (eg main thread has run out of RAM)
+	 size_t lines;        // number of lines read
+	 struct chunk_batch *batch; // batch being filled by thread
+	 CRITICAL_SECTION lock;      // protects first, last and finished
+	 bool lock_ok;        // true if lock has been initialised
+	 struct chunk_batch *first,*last; // batches passed to main thread that it has not yet taken
+	 bool finished;       // set by thread when it has finished reading the chunk (after passing its last batch)
+	 size_t nos_xerrs;    // count of lines skipped due to errors in x value
+	 size_t *nos_yerrs;   // count of errors in y value for each trace
+	 size_t nos_errs;     // total errors found
+	 struct chunk_err errs[MAX_CHUNK_ERRS];
+	 int nos_chunk_errs;  // number of entries in errs[]
+	 bool found_error_type[MAX_ERR_TYPES];
+	 bool out_of_ram;
+	};
+
+static int read_threads_to_use(int64_t bytes) // returns number of threads to use to read bytes of a csv file
+{SYSTEM_INFO si;
+ int n;
+ if(bytes<PARALLEL_READ_MIN_BYTES) return 1;
+ GetSystemInfo(&si);
+ n=(int)si.dwNumberOfProcessors;
+ if(n>MAXIMUM_WAIT_OBJECTS) n=MAXIMUM_WAIT_OBJECTS; // WaitForMultipleObjects() is used to wait for threads
+ if(bytes/PARALLEL_READ_MIN_CHUNK < n) n=(int)(bytes/PARALLEL_READ_MIN_CHUNK);
+ return n<1 ? 1 : n;
+}
+
+static void chunk_error(struct parse_chunk *cp,int err_type,char xy,const char *text) // remember error if it might need to be shown to the user
+{++cp->nos_errs;
+ if(cp->nos_chunk_errs<MAX_CHUNK_ERRS && (cp->nos_errs<=MAX_ERRS || !cp->found_error_type[err_type]))
+	{struct chunk_err *ep=&cp->errs[cp->nos_chunk_errs++];
+	 ep->line=cp->lines;
+	 ep->err_nos=cp->nos_errs;
+	 ep->err_type=err_type;
+	 ep->xy=xy;
+	 ep->text=strdup(text); // if this fails (NULL) then "(null)" will be printed
+	}
+ cp->found_error_type[err_type]=true;
+}
+
+static void print_chunk_error(struct chunk_err *ep,size_t line) // called by main thread to show an error found by a thread reading a chunk, line is the line number in the file (1 for the 1st line)
+// messages are the same as those given for each type of error when the file is read by the main thread (see get_xval() and Button_add_trace1Click() )
+{switch(ep->err_type)
+	{case ERR_TYPE3: // no number found for x
+	 case ERR_TYPE5: // x value is not finite
+		rprintf("Warning: x value on line %zu has an invalid number: %s\n",line,ep->text);
+		break;
+	 case ERR_TYPE4: // no number found for y (threads never read y expressions, so "expression generates NAN" cannot happen here)
+	 case ERR_TYPE6: // y value is not finite
+		rprintf("Warning: y value on line %zu has an invalid number: %s\n",line,ep->text);
+		break;
+	 default: // threads do not read times (x type 1), so ERR_TYPE1,2 and 7 are never found by them
+		rprintf("Warning: %c value on line %zu has an invalid number: %s\n",ep->xy,line,ep->text);
+		break;
+	}
+}
+
+static struct chunk_batch *new_chunk_batch(struct parse_chunk *cp) // returns a new (empty) batch for the thread reading chunk cp, or NULL if out of RAM
+{bool use_line_nos= cp->xtype==0 || cp->keep_line_nos;
+ bool use_x= cp->xtype!=0;
+ size_t size=sizeof(struct chunk_batch)+(size_t)cp->nos_traces*(sizeof(float *)+sizeof(bool *)+CHUNK_BATCH_PTS*(sizeof(float)+sizeof(bool)));
+ if(use_line_nos) size+=CHUNK_BATCH_PTS*sizeof(size_t);
+ if(use_x) size+=CHUNK_BATCH_PTS*sizeof(float);
+ struct chunk_batch *bp=(struct chunk_batch *)malloc(size); // one malloc() for the batch and all of its arrays
+ if(bp==NULL) return NULL;
+ char *p=(char *)(bp+1);
+ bp->next=NULL;
+ bp->nos_pts=0;
+ bp->y=(float **)p;
+ p+=(size_t)cp->nos_traces*sizeof(float *);
+ bp->valid=(bool **)p;
+ p+=(size_t)cp->nos_traces*sizeof(bool *);
+ bp->line_nos=NULL;
+ if(use_line_nos)
+	{bp->line_nos=(size_t *)p;
+	 p+=CHUNK_BATCH_PTS*sizeof(size_t);
+	}
+ bp->x=NULL;
+ if(use_x)
+	{bp->x=(float *)p;
+	 p+=CHUNK_BATCH_PTS*sizeof(float);
+	}
+ for(int t=0;t<cp->nos_traces;++t)
+	{bp->y[t]=(float *)p;
+	 p+=CHUNK_BATCH_PTS*sizeof(float);
+	}
+ for(int t=0;t<cp->nos_traces;++t)
+	{bp->valid[t]=(bool *)p; // bools go last so the floats above stay aligned
+	 p+=CHUNK_BATCH_PTS*sizeof(bool);
+	}
+ return bp;
+}
+
+static void free_chunk_batches(struct chunk_batch *bp) // free a list of batches
+{while(bp!=NULL)
+	{struct chunk_batch *next=bp->next;
+	 free(bp);
+	 bp=next;
+	}
+}
+
+static void pass_chunk_batch(struct parse_chunk *cp,bool finished) // called by thread to pass the batch it has filled to the main thread, finished is true when the thread has read all its chunk
+{EnterCriticalSection(&cp->lock);
+ if(cp->batch!=NULL && cp->batch->nos_pts>0)
+	{if(cp->last==NULL)
+		cp->first=cp->batch;
+	 else
+		cp->last->next=cp->batch;
+	 cp->last=cp->batch;
+	 cp->batch=NULL;
+	}
+ if(finished) cp->finished=true;
+ LeaveCriticalSection(&cp->lock);
+}
+
+static struct chunk_batch *take_chunk_batches(struct parse_chunk *cp,bool *finished) // called by main thread to take all batches passed to it by the thread reading chunk cp (in file order)
+// caller must free the batches (via free_chunk_batches() ). *finished is set to true if the thread has finished (so there will be no more batches)
+{struct chunk_batch *bp;
+ EnterCriticalSection(&cp->lock);
+ bp=cp->first;
+ cp->first=cp->last=NULL;
+ *finished=cp->finished;
+ LeaveCriticalSection(&cp->lock);
+ return bp;
+}
+
+static char *skip_csv_space(char *st) // skip leading whitespace and " in field st, returns pointer to where a number should start
+{while(isspace(*st)) ++st; // skip any leading whitespace
+ if(*st=='"')
+	{++st;// skip " if present
+	 while(isspace(*st)) ++st; // skip any more whitespace
+	}
+ return st;
+}
+
+static bool get_csv_float(char *st,float *v) // convert field st to a number in *v, skipping leading whitespace and " , returns false if no number found
+{char *end;
+ st=skip_csv_space(st);
+ *v=strtof(st,&end); // strtof() will terminate at the end of the number so any trailing whitespace or " will be ignored
+ return st!=end;
+}
+
+static bool get_csv_double(char *st,double *v) // as get_csv_float() but gives a double (used for x values)
+{char *end;
+ st=skip_csv_space(st);
+ *v=fast_strtod(st,&end);
+ return st!=end;
+}
+
+static double x_divisor(int xtype) // x values in a column are divided by this for x type xtype (2-5)
+{if(xtype==3) return 60.0; // sec->min
+ if(xtype==4) return 3600.0; // sec->hrs
+ if(xtype==5) return 86400.0; // sec->days
+ return 1.0;
+}
+
+static unsigned __stdcall parse_chunk_thread(void *param) // thread to read a chunk of a csv file, must not use any VCL functions or rprintf()
+{struct parse_chunk *cp=(struct parse_chunk *)param;
+ char **cols=(char **)malloc(cp->max_col*sizeof(char *)); // cannot use (global) col_ptrs as each thread needs its own
+ char **ystarts=(char **)malloc(cp->nos_traces*sizeof(char *)); // start of number for each trace on a line
+ char **yends=(char **)malloc(cp->nos_traces*sizeof(char *)); // end of number for each trace
+ float *yvs=(float *)malloc(cp->nos_traces*sizeof(float)); // y values for all traces on a line
+ char *csv_line;
+ float xv,yv;
+ if(cols==NULL || ystarts==NULL || yends==NULL || yvs==NULL)
+	{cp->out_of_ram=true;
+	 if(cols!=NULL) free(cols);
+	 if(ystarts!=NULL) free(ystarts);
+	 if(yends!=NULL) free(yends);
+	 if(yvs!=NULL) free(yvs);
+	 pass_chunk_batch(cp,true);
+	 return 0;
+	}
+ while(!cp->stop && (csv_line=csv_readline(cp->r))!=NULL)
+	{if(cp->stop_at>0 && csv_tell(cp->r)>cp->stop_at) break; // incomplete last line
+	 if(cp->no_quotes)
+		parsecsv_noquotes(csv_line,cols,cp->max_col);
+	 else
+		parsecsv(csv_line,cols,cp->max_col);
+	 cp->lines++;
+	 if((cp->lines & 0x7fff)==0)
+		{InterlockedExchange64(&cp->bytes_read,csv_tell(cp->r)-cp->start);
+		 cp->lines_read=cp->lines;
+		}
+	 if(cp->xtype==0)
+		xv=0; // x=linenumber in file, but we don't know the line number of the start of this chunk yet so this is done later
+	 else
+		{double xd;
+		 if(!get_csv_double(cols[cp->xcol-1],&xd))
+			{++cp->nos_xerrs;
+			 chunk_error(cp,ERR_TYPE3,'x',cols[cp->xcol-1]);
+			 continue;    // no valid number found
+			}
+		 if(cp->xtype!=2) xd/=x_divisor(cp->xtype);
+		 xv=(float)(xd-cp->x_origin); // offset in double, so big x values keep their resolution
+		 if(!_finite(xv))
+			{++cp->nos_xerrs;
+			 chunk_error(cp,ERR_TYPE5,'x',cols[cp->xcol-1]);
+			 continue; // need a valid x value [eg ignore "inf" ]
+			}
+		}
+	 if(cp->batch==NULL || cp->batch->nos_pts>=CHUNK_BATCH_PTS)
+		{pass_chunk_batch(cp,false); // pass full batch to main thread
+		 if((cp->batch=new_chunk_batch(cp))==NULL)
+			{cp->out_of_ram=true;
+			 break;
+			}
+		}
+	 struct chunk_batch *bp=cp->batch;
+	 if(bp->line_nos!=NULL)
+		bp->line_nos[bp->nos_pts]=cp->lines;
+	 if(bp->x!=NULL)
+		bp->x[bp->nos_pts]=xv;
+	 for(int t=0;t<cp->nos_traces;++t)
+		ystarts[t]=skip_csv_space(cols[cp->traces[t].ycol-1]);
+	 if(cp->any_int_col)
+		{for(int t=0;t<cp->nos_traces;++t)
+			yvs[t]= cp->traces[t].int_col ? fast_strtof_int(ystarts[t],&yends[t]) : strtof(ystarts[t],&yends[t]);
+		}
+	 else
+		fast_strtof_array(ystarts,yvs,yends,cp->nos_traces); // convert all y values on this line in one call
+	 for(int t=0;t<cp->nos_traces;++t)
+		{char *st=cols[cp->traces[t].ycol-1];
+		 yv=yvs[t];
+		 bool valid= ystarts[t]!=yends[t];
+		 if(!valid)
+			{++cp->nos_yerrs[t];
+			 chunk_error(cp,ERR_TYPE4,'y',st);
+			 yv=0; // not used
+			}
+		 else if(!_finite(yv))
+			{++cp->nos_yerrs[t];
+			 chunk_error(cp,ERR_TYPE6,'y',st);
+			}
+		 bp->y[t][bp->nos_pts]=yv;
+		 bp->valid[t][bp->nos_pts]=valid;
+		}
+	 bp->nos_pts++;
+	}
+ InterlockedExchange64(&cp->bytes_read,csv_tell(cp->r)-cp->start);
+ cp->lines_read=cp->lines;
+ free(cols);
+ free(ystarts);
+ free(yends);
+ free(yvs);
+ pass_chunk_batch(cp,true); // pass last batch (if any) to main thread and tell it we have finished
+ return 0;
+}
+
+static void free_parse_chunk(struct parse_chunk *cp) // free all memory used by chunk cp (and close its reader if it was opened for this chunk). Its thread must have finished
+{if(cp->close_r) csv_close(cp->r); // csv_close(NULL) is OK
+ cp->r=NULL;
+ free_chunk_batches(cp->batch);
+ cp->batch=NULL;
+ free_chunk_batches(cp->first);
+ cp->first=cp->last=NULL;
+ if(cp->lock_ok)
+	{DeleteCriticalSection(&cp->lock);
+	 cp->lock_ok=false;
+	}
+ if(cp->nos_yerrs!=NULL) free(cp->nos_yerrs);
+ cp->nos_yerrs=NULL;
+ for(int e=0;e<cp->nos_chunk_errs;++e)
+	if(cp->errs[e].text!=NULL) free(cp->errs[e].text);
+ cp->nos_chunk_errs=0;
+}
+
+static void free_parse_chunks(struct parse_chunk *chunks,int nos_chunks)
+{if(chunks==NULL) return;
+ for(int c=0;c<nos_chunks;++c)
+	free_parse_chunk(&chunks[c]);
+ free(chunks);
+}
+
+static struct parse_chunk *start_parse_chunks(const wchar_t *filename,csv_reader *r,int64_t start,int64_t end,int nos_chunks,int xtype,int xcol,double x_origin,unsigned int max_col,bool no_quotes,struct add_trace_item *traces,int nos_traces,bool keep_line_nos,HANDLE *threads,int *nos_threads)
+/* split filename between offsets start and end into nos_chunks parts, and start a thread to read each one. threads[] is set to the *nos_threads threads actually started.
+   If line_index[] is valid the parts start at the start of a line, otherwise each part starts at the 1st line that starts in it.
+   If r is not NULL then nos_chunks must be 1, and r is used to read the file from its current position (start) up to end (or to the end of the file, even if it grows while being read, if end is 0) - in this case the file does not need to be memory mapped.
+   returns NULL on error (in which case no threads are running) */
+{struct parse_chunk *chunks=(struct parse_chunk *)calloc((size_t)nos_chunks,sizeof(struct parse_chunk)); // calloc() so all pointers start as NULL
+ *nos_threads=0;
+ if(chunks==NULL) return NULL;
+ for(int c=0;c<nos_chunks;++c)
+	{struct parse_chunk *cp=&chunks[c];
+	 cp->start= c==0 ? start : line_start_after(start+(end-start)*c/nos_chunks,end);
+	 cp->xtype=xtype;
+	 cp->xcol=xcol;
+	 cp->x_origin=x_origin;
+	 cp->max_col=max_col;
+	 cp->no_quotes=no_quotes;
+	 cp->traces=traces;
+	 cp->nos_traces=nos_traces;
+	 for(int t=0;t<nos_traces;++t)
+		if(traces[t].int_col) cp->any_int_col=true;
+	 cp->keep_line_nos=keep_line_nos;
+	 if(r!=NULL)
+		{cp->r=r; // caller still owns r
+		 cp->stop_at=end; // r reads to the end of the file, so stop at end (if set)
+		}
+	 else
+		{cp->r=csv_open_part(filename,cp->start,c==nos_chunks-1 ? end : line_start_after(start+(end-start)*(c+1)/nos_chunks,end));
+		 cp->close_r=true;
+		}
+	 InitializeCriticalSection(&cp->lock);
+	 cp->lock_ok=true;
+	 cp->nos_yerrs=(size_t *)calloc((size_t)nos_traces,sizeof(size_t));
+	 if(cp->r==NULL || cp->nos_yerrs==NULL)
+		{free_parse_chunks(chunks,nos_chunks);
+		 return NULL;
+		}
+	}
+ for(int c=0;c<nos_chunks;++c)
+	{HANDLE h=(HANDLE)_beginthreadex(NULL,0,parse_chunk_thread,&chunks[c],0,NULL);
+	 if(h!=0)
+		threads[(*nos_threads)++]=h;
+	 else
+		parse_chunk_thread(&chunks[c]); // cannot start a thread so read this chunk now
+	}
+ return chunks;
+}
+
+#ifdef USE_CSV_CACHE
+static uint32_t x_cache_key(int xtype,int xcol,bool from0,const char *date_time_fmt) // returns key that identifies how x values were created, so they can be found in a sidecar file
+{char buf[64];
+ uint32_t h;
+ snprintf(buf,sizeof(buf),"%d,%d,%d,",xtype,xcol,from0 ? 1:0);
+ hash_reset(&h);
+ hash_add(buf,&h);
+ if(xtype==6) hash_add(date_time_fmt,&h); // format changes how dates/times are read
+ return h==0 ? 1 : h; // 0 is used in sidecar file to mean "no x value errors"
+}
+#endif
+
+// layout of times (x type 1) found on the 1st line, reset with reset_days() before reading a file
+#define TIME_LAYOUT_UNKNOWN 0 /* not found yet */
+#define TIME_LAYOUT_HMS 1 /* hh:mm:ss[.s] with no date */
+#define TIME_LAYOUT_ISO 2 /* yyyy-mm-dd hh:mm:ss[.s] */
+#define TIME_LAYOUT_OTHER 3 /* anything else - always use general code */
+static int time_layout=TIME_LAYOUT_UNKNOWN;
+
+static bool is_iso_date(const char *s) // returns true if s starts "yyyy-mm-dd " followed by a digit
+{return isdigit(s[0]) && isdigit(s[1]) && isdigit(s[2]) && isdigit(s[3]) && s[4]=='-' && isdigit(s[5]) && isdigit(s[6]) && s[7]=='-' &&
+	isdigit(s[8]) && isdigit(s[9]) && s[10]==' ' && isdigit(s[11]);
+}
+
+static bool get_xval(int xtype,char *xs,const char *date_time_fmt,strp_compiled *date_time_c,size_t line,bool firstxvalue,long double *first_time,bool *file_has_dates,size_t *nos_xerrs,size_t *nos_errs,bool *found_error_type,float *x)
+// convert field xs of line (number of lines read so far) to an x value in *x. xtype is Xcol_type->ItemIndex. Returns false (after counting & reporting the error) if the line should be skipped
+// date_time_c is date_time_fmt compiled by ya_strptime_compile(), or NULL if the format could not be compiled
+{float xval;
+ char *st;
+ bool got_date;
+	 {long double ti;   // ti is the time just read in - this needs as much resolution as possible - first_time is also a long double
+	  switch(xtype)
+			{case 0: xval=line; // x=linenumber in file
+					break;
+			 case 1: // time h:m:s.s (with optional date of form 05-Jul-19 or 2020-03-31 or similar terminated in whitespace)
+					st=xs;
+					if(time_layout==TIME_LAYOUT_HMS && isdigit(xs[0]) && isdigit(xs[1]) && xs[2]==':')
+						{got_date=false; // same as 1st line, so no need to look for a date
+						}
+					else if(time_layout==TIME_LAYOUT_ISO && is_iso_date(xs))
+						{st=xs+11; // skip date
+						 got_date=true;
+						 *file_has_dates=true;
+						}
+					else
+					{
+					while(isspace(*st)) ++st; // skip any leading whitespace
+					if(*st=='"')
+							{++st;// skip " if present
+							 while(isspace(*st)) ++st; // skip any more whitespace
+							}
+					 {char *dptr; // look ahead to see if there is a date we need to skip
+									// date is either 05-Jul-19 or 2020-03-31 or 12/12/20 or similar terminated in whitespace
+					  got_date=false;
+					  for(dptr=st;*dptr;++dptr)
+							{if(*dptr=='-' || *dptr=='/')
+									{got_date=true;
+									 break;
+									}
+							 if(*dptr==':')
+									{// found a time, not a date
+									 break;
+									}
+							}
+					   if(got_date)
+							{for(;*dptr;++dptr)
+									if(isspace(*dptr)) break;// carry on from where we were, look for whitespace which marks end of date
+							 while(isspace(*dptr)) ++dptr;  // skip whitespace so should be at start of time
+							 if(isdigit(*dptr)) st=dptr; // if we ended up on a digit then assume this is the start of the time
+							 *file_has_dates=true;
+							}
+					  }
+					 if(time_layout==TIME_LAYOUT_UNKNOWN)
+						{// remember the layout of the 1st line with a time, the checks above for these layouts give the same st & got_date as the general code
+						 if(!got_date && st==xs && isdigit(xs[0]) && isdigit(xs[1]) && xs[2]==':') time_layout=TIME_LAYOUT_HMS;
+						 else if(got_date && st==xs+11 && is_iso_date(xs)) time_layout=TIME_LAYOUT_ISO;
+						 else if(isdigit(*st)) time_layout=TIME_LAYOUT_OTHER; // not a header line, so has a layout we cannot speed up
+						}
+					}
+					// convert time into seconds , gethms_days() ignores trailing whitespace and "'s
+					ti=gethms_days_fast(st);  // note we called reset_days above so we always start correctly at 0 days. gethms_days_fast() uses gethms_days() if st is not hh:mm:ss[.s]
+					if(ti<0)
+						{++*nos_xerrs;
+						 if((++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE1]) && ti== -1)
+							{found_error_type[ERR_TYPE1]=true; // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has an invalid date/time (time does not start with a number): %s\n",line+1,xs);
+							}
+						 if((*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE2]) && ti!= -1)
+							{found_error_type[ERR_TYPE2]=true;  // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has an invalid date/time (time goes backwards!): %s\n",line+1,xs);
+							}
+						 return false;   // gethms_days() returns a -ve value when it finds an error, so ignore this line when that happens
+						}
+					 if(!got_date && *file_has_dates)
+						{ // this has to be after checks on time as we want a header line to be picked up as ERR_TYPE1 not type7
+						 ++*nos_xerrs;
+						 if((++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE7]) )
+							{found_error_type[ERR_TYPE7]=true; // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has no date but previous lines do have dates: %s\n",line+1,xs);
+							}
+						}
+					if(firstxvalue) *first_time=ti;  // remember 1st value, and potentially use as ofset for the rest of the values
+					if(start_time_from_0)
+						{
+						 /* line below assumes times are in increasing order which is NOT guaranteed ! */
+						 /* However, first_time is a double, as is ti so this potentially offers higher resolution as the difference is stored as a float */
+						 xval=(float)(ti-*first_time);  // ofset time by time of 1st value (so we maximise resolution in the float xval)
+						}
+					  else
+						{
+						 xval=(float)ti; // can loose resolution for big times, but we are limited by storing xvalues as floats.
+						}
+					break;
+			 case 6: // date/time with user specified format  - stored in char * date_time_fmt
+					{ // there is no need to skip initial whitespace or deal with quotes here as can be defined in date_time_fmt
+					 //char * ya_strptime(const char *s, const char *format, struct tm *tm)
+					 char *dptr;
+					 struct tm my_tm;
+					 st=xs;
+					 if(date_time_c!=NULL)
+						dptr=ya_strptime_exec(date_time_c,st,&my_tm); // format was compiled when file was opened, this also zeros all members of tm
+					 else
+						{memset(&my_tm, 0, sizeof(struct tm));// zero all members of tm
+						 strp_tz.initialised=0; // mark as not initialised, so will be zeroed on call to ya_strptime();
+						 dptr=ya_strptime(st,date_time_fmt,&my_tm);
+						}
+					 if(dptr==NULL)
+						{// something was wrong with date/time or format
+						 ++*nos_xerrs;
+						 if(++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE1] )
+							{found_error_type[ERR_TYPE1]=true; // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has an invalid date/time (strptime(\"%s\") returned NULL): %s\n",line+1,date_time_fmt,xs);
+							}
+						 return false;      // ignore line
+						}
+					 while(isspace(*dptr)) ++dptr; // if remainder is whitespace then thats OK
+					 if(*dptr!=0)
+						{ // ya_strptime() did not process all of the string  again issue could be date/time or format
+						 ++*nos_xerrs;
+						 if(++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE2] )
+							{found_error_type[ERR_TYPE2]=true;  // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has an invalid date/time (format \"%s\" did not match whole string: %s [\"%s\" left])\n",line+1,date_time_fmt,xs,dptr);
+							}
+						 return false;      // ignore line
+						}
+					 if(!check_tm(&my_tm))
+						{ // invalid date/time found
+						 ++*nos_xerrs;
+						 if(++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE3] )
+							{found_error_type[ERR_TYPE3]=true;  // note we have printed an example of this type of error
+							 rprintf("Warning: x value on line %zu has an invalid date/time (check_tm() failed): %s\n",line+1,xs);
+							}
+						 return false;   // ignore line
+						}
+					 if(date_time_c!=NULL)
+						ti=ya_strptime_mktime(date_time_c,&my_tm); /* same as ya_mktime() but only works out the start of the day when the date changes */
+					 else
+						ti=ya_mktime(&my_tm); /* fully functional version of mktime() that returns secs and takes (and changes if necessary) timeptr */
+					 ti+=strp_tz.f_secs;// add in any fractional seconds (ti is a long double to maximise resolution here) */
+
+					if(firstxvalue)
+						{*first_time=ti;  // remember 1st value, and potentially use as offset for the rest of the values
+						}
+					if(start_time_from_0)
+						{
+						 /* line below assumes times are in increasing order which is NOT guaranteed ! */
+						 /* However, first_time is a double, as is ti so this potentially offers higher resolution as the difference is stored as a float */
+						 xval=(float)(ti-*first_time);  // offset time by time of 1st value [both are long doubles] (so we maximise resolution in the float xval)
+						}
+					  else
+						{
+						 xval=(float)ti; // can loose resolution for big times, but we are limited by storing xvalues as floats.
+						}
+#if 0
+					if(line<5)
+						{// useful for debugging
+						 rprintf("date/time on line %zu returns %g secs (format \"%s\" line: %s, ti=%g)\n",line+1,xval,date_time_fmt,xs,ti);
+						}
+#endif
+					}
+					break;
+			 default: // could be 2,3,4 or 5 value in specified column, potentially divided by a constant
+					st=xs;
+					while(isspace(*st)) ++st; // skip any leading whitespace
+					if(*st=='"')
+							{++st;// skip " if present
+							 while(isspace(*st)) ++st; // skip any more whitespace
+							}
+					{char *end;
+					 double xd= fast_strtod(st,&end);   // get value for this column, as a double so big values can be offset without losing resolution
+					// rprintf("Xval: xcol=%d string=%s =%g\n",xcol,st,xd);
+					if(st==end)
+						{++*nos_xerrs;
+						 if(++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE3])
+							{found_error_type[ERR_TYPE3]=true;
+							 rprintf("Warning: x value on line %zu has an invalid number: %s\n",line+1,xs);
+							}
+						 return false;    // no valid number found
+						}
+					if(xtype!=2) xd/=x_divisor(xtype); // sec->min, hrs or days
+					if(firstxvalue)
+						*first_time=xd; // remember 1st value, and potentially use as offset for the rest of the values
+					if(start_time_from_0)
+						xd-=(double)*first_time; // offset in double so we maximise resolution in the float xval
+					xval=(float)xd;
+					}
+					break;
+			}
+	 }
+	 if(!_finite(xval))
+		{++*nos_xerrs; // line skipped for all traces
+		 if(++*nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE5])
+			{found_error_type[ERR_TYPE5]=true;
+			 rprintf("Warning: x value on line %zu has an invalid number: %s\n",line+1,xs);
+			}
+		 return false; // need a valid x value [eg ignore "inf" ]
+		}
+ *x=xval;
+ return true;
+}
+
+static bool first_x_value(csv_reader *r,int xtype,int xcol,unsigned int max_col,double *x0) // sets *x0 to the 1st valid x value (x types 2-5) after the current position in r, then moves r back to where it started
+// used to find the offset for x values read by worker threads when start_time_from_0 is true. Returns false if this cannot be done (r cannot be seeked, or no valid x value is found quickly)
+{int64_t start=csv_tell(r);
+ char *line;
+ double x;
+ if(csv_is_compressed(r) || csv_is_stream(r)) return false; // cannot move back
+ for(int l=0;l<10000 && (line=csv_readline(r))!=NULL;++l)
+	{parsecsv(line,col_ptrs,max_col);
+	 if(get_csv_double(col_ptrs[xcol-1],&x))
+		{if(xtype!=2) x/=x_divisor(xtype);
+		 if(_finite(x))
+			{*x0=x;
+			 return csv_seek(r,start);
+			}
+		}
+	}
+ csv_seek(r,start);
+ return false;
+}
+
+static bool order_files_by_x(csv_reader *r,int xcol) // reorder a set of files so they are read in order of the 1st x value (in column xcol) in each file
+// returns true if the order was changed (r is then at the start of the set), false if the files are already in order or the x values could not be read
+{int n=csv_nos_files(r);
+ int *order=(int *)malloc((size_t)n*sizeof(int));
+ double *x0=(double *)malloc((size_t)n*sizeof(double)); // 1st x value in each file
+ char **cols=(char **)malloc((size_t)xcol*sizeof(char *));
+ bool changed=false;
+ int i;
+ for(i=0;i<n && order!=NULL && x0!=NULL && cols!=NULL;++i)
+	{csv_reader *f=csv_open(csv_file_name(r,i));
+	 char *line;
+	 bool ok= f!=NULL;
+	 order[i]=i;
+	 x0[i]= -HUGE_VAL; // a file with no data does not matter where it goes
+	 if(ok && csv_readline(f)!=NULL && (line=csv_readline(f))!=NULL) // skip header, x value is on the 1st line of data
+		{parsecsv(line,cols,(unsigned int)xcol);
+		 ok=get_csv_double(cols[xcol-1],&x0[i]) && _finite(x0[i]);
+		}
+	 csv_close(f);
+	 if(!ok) break;
+	}
+ if(i==n)
+	{for(i=1;i<n;++i)
+		{// insertion sort keeps files with the same 1st x value in name order
+		 int o=order[i],j=i;
+		 while(j>0 && x0[order[j-1]]>x0[o])
+			{order[j]=order[j-1];
+			 --j;
+			}
+		 order[j]=o;
+		 if(j!=i) changed=true;
+		}
+	 if(changed)
+		{rprintf("Files will be read in order of their 1st x value: %s",Utf8Of((wchar_t *)csv_file_name(r,order[0])));
+		 rprintf(" ... %s\n",Utf8Of((wchar_t *)csv_file_name(r,order[n-1])));
+		 changed=csv_order_files(r,order);
+		}
+	}
+ else
+	rprintf("Note: cannot read the 1st x value of every file, so files are read in the order of their names\n");
+ free(order);
+ free(x0);
+ free(cols);
+ return changed;
+}
+
+// "follow file" - when Followfile1 is ticked lines appended to the file after traces are added are added to those traces (like tail -f)
+// the file is polled by Timer_follow, and only the bytes added since the last update are read
+static bool follow_start(struct add_trace_item *traces,int nos_traces,int max_traces,int xtype,int xcol,unsigned int max_col,char *date_time_fmt,strp_compiled *date_time_c,double x_offset,
+	bool firstxvalue,long double first_time,bool file_has_dates,bool any_yexpr,size_t lines_in_file,int64_t data_end) // start following filename, takes ownership of traces[], date_time_fmt and date_time_c. Returns false if the file cannot be followed
+{follow_stop();
+ if(nos_traces<1) return false;
+ follow.filename=filename;
+ follow.offset=data_end;
+ follow.lines_in_file=lines_in_file;
+ follow.xtype=xtype;
+ follow.xcol=xcol;
+ follow.max_col=max_col;
+ follow.date_time_fmt=date_time_fmt;
+ follow.date_time_c=date_time_c;
+ follow.x_offset=x_offset;
+ follow.firstxvalue=firstxvalue;
+ follow.first_time=first_time;
+ follow.file_has_dates=file_has_dates;
+ follow.any_yexpr=any_yexpr;
+ follow.traces=traces;
+ follow.nos_traces=nos_traces;
+ follow.max_traces=max_traces;
+ follow.nos_errs=0;
+ follow.nos_xerrs=0;
+ for(int i=0;i<MAX_ERR_TYPES;++i) follow.found_error_type[i]=false;
+ follow.active=true;
+ return true;
+}
+
+static int64_t follow_filesize(void) // returns current size of the file being followed, -1 on error
+{WIN32_FILE_ATTRIBUTE_DATA fa;
+ if(!GetFileAttributesExW(Utf8_to_w(follow.filename.c_str()),GetFileExInfoStandard,&fa)) return -1;
+ return (int64_t)(((uint64_t)fa.nFileSizeHigh<<32) | fa.nFileSizeLow);
+}
+
+static char *follow_read(int64_t start,size_t len,size_t *bytes_read) // read len bytes from start of file being followed, returns malloc'ed buffer (with an extra 0 at the end) or NULL on error
+{HANDLE h;
+ LARGE_INTEGER li;
+ char *buf;
+ size_t got=0;
+ // file is still open for writing by the program creating it, so must allow it to carry on writing
+ h=CreateFileW(Utf8_to_w(follow.filename.c_str()),GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+ if(h==INVALID_HANDLE_VALUE) return NULL;
+ li.QuadPart=start;
+ buf=(char *)malloc(len+1);
+ if(buf==NULL || !SetFilePointerEx(h,li,NULL,FILE_BEGIN))
+	{if(buf!=NULL) free(buf);
+	 CloseHandle(h);
+	 return NULL;
+	}
+ while(got<len)
+	{DWORD n;
+	 DWORD want=(DWORD)min(len-got,(size_t)(1u<<30));
+	 if(!ReadFile(h,buf+got,want,&n,NULL) || n==0) break;
+	 got+=n;
+	}
+ CloseHandle(h);
+ buf[got]=0;
+ *bytes_read=got;
+ return buf;
+}
+
+static int64_t last_line_end(const wchar_t *fname,int64_t start,int64_t end) // returns offset just after the last '\n' in fname between start and end, or start if there is none
+// used so a file that will be followed is only read up to its last complete line, the line still being written is then read by follow_add_lines() when it is complete
+{HANDLE h;
+ char buf[4096];
+ h=CreateFileW(fname,GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,NULL,OPEN_EXISTING,0,NULL);
+ if(h==INVALID_HANDLE_VALUE) return end; // assume last line is complete
+ while(end>start)
+	{LARGE_INTEGER li;
+	 DWORD n;
+	 DWORD len=(DWORD)min(end-start,(int64_t)sizeof(buf));
+	 li.QuadPart=end-len;
+	 if(!SetFilePointerEx(h,li,NULL,FILE_BEGIN) || !ReadFile(h,buf,len,&n,NULL) || n!=len) break;
+	 for(DWORD i=len;i>0;--i)
+		if(buf[i-1]=='\n')
+			{CloseHandle(h);
+			 return end-len+i;
+			}
+	 end-=len;
+	}
+ CloseHandle(h);
+ return end>start ? end : start; // read error (assume last line is complete) or no '\n' found
+}
+
+static size_t follow_add_lines(TScientificGraph *pGraph,int64_t filesize,double *xmin,double *xmax,double *ymin,double *ymax,bool *out_of_ram)
+// add complete lines appended to the file being followed to its traces, returns number of lines added. *xmin etc are expanded to include all points added
+{char *buf,*line,*end;
+ size_t len,lines_added=0;
+ int64_t start=follow.offset-1; // read the byte before offset as well, so we can tell if the last line read previously was complete
+ pnlist px=NULL,pX=NULL,pline=NULL;
+ *out_of_ram=false;
+ if(filesize-start>FOLLOW_MAX_READ) filesize=start+FOLLOW_MAX_READ; // read a lot of data over several updates to keep the user interface responsive
+ buf=follow_read(start,(size_t)(filesize-start),&len);
+ if(buf==NULL) return 0;
+ end=buf+len;
+ while(end>buf+1 && end[-1]!='\n') --end; // only process complete lines, the last line may still be being written
+ if(end<=buf+1)
+	{free(buf); // no complete lines yet
+	 return 0;
+	}
+ line=buf+1;
+ if(buf[0]!='\n')
+	line=(char *)memchr(buf,'\n',(size_t)(end-buf))+1; // last line read previously was incomplete (and has already been added) - skip the rest of it
+ follow.offset=start+(end-buf);
+ if(follow.any_yexpr)
+	{px=lookup("x");
+	 pX=lookup("X");
+	 pline=lookup("line");
+	}
+ for(;line<end && !*out_of_ram;)
+	{char *nl=(char *)memchr(line,'\n',(size_t)(end-line));
+	 float x,x_plus_offset,y;
+	 *nl=0;
+	 parsecsv(line,col_ptrs,follow.max_col);
+	 nos_col_ptrs=follow.max_col;
+	 line=nl+1;
+	 ++follow.lines_in_file;
+	 ++lines_added;
+	 if(!get_xval(follow.xtype,col_ptrs[follow.xcol-1],follow.date_time_fmt,follow.date_time_c,follow.lines_in_file,follow.firstxvalue,&follow.first_time,&follow.file_has_dates,&follow.nos_xerrs,&follow.nos_errs,follow.found_error_type,&x))
+		continue; // invalid x value (error has been reported)
+	 follow.firstxvalue=false;
+	 xval=x;
+	 x_plus_offset= follow.x_offset==0?x:(float)(x+follow.x_offset);
+	 if(px!=NULL) px->value=x;
+	 if(pX!=NULL) pX->value=x;
+	 if(pline!=NULL) pline->value=(double)follow.lines_in_file;
+	 for(int t=0;t<follow.nos_traces;++t)
+		{struct add_trace_item *tp=&follow.traces[t];
+		 if(tp->yexpr)
+			{double yval_d;
+			 try
+				{yval_d=execute_saved_rpn(tp->rpn);
+				}
+			 catch (...)   // assume the issue is an error in the expression
+				{yval_d=NAN;
+				}
+			 if(isnan(yval_d)) continue;
+			 y=(float)yval_d;
+			}
+		 else if(!get_csv_float(col_ptrs[tp->ycol-1],&y))
+			continue; // not a number
+		 if(!_finite(y)) continue; // need 2 valid numbers
+		 if(!add_point_to_trace(pGraph,tp,x,x_plus_offset,y))
+			{*out_of_ram=true;
+			 break;
+			}
+		 if(x_plus_offset<*xmin) *xmin=x_plus_offset;
+		 if(x_plus_offset>*xmax) *xmax=x_plus_offset;
+		 if(y<*ymin) *ymin=y;
+		 if(y>*ymax) *ymax=y;
+		}
+	}
+ free(buf);
+ for(int t=0;t<follow.nos_traces;++t)
+	{struct add_trace_item *tp=&follow.traces[t];
+	 if(!tp->xmonotonic)
+		{// new x values are less than previous ones, need to sort the trace again (this should be rare for a log file)
+		 size_t n;
+		 pGraph->sortx(tp->iGraph);
+		 n=pGraph->fnGetNumberOfDataPoints(tp->iGraph);
+		 if(n>0) tp->previousxvalue=(float)(pGraph->fnGetXval(n-1,tp->iGraph)-follow.x_offset); // values in graph include x offset
+		 tp->xmonotonic=true;
+		}
+	}
+ return lines_added;
 }
 
 void __fastcall TPlotWindow::Button_add_trace1Click(TObject *Sender)
 {  // add graph
    // here we want to display a csv file
+   // all traces in the (comma seperated) list in Edit_ycol are read in a single pass through the file
   P_UNUSED(Sender);
   int iGraph;
   bool yexpr; // set to true if ycol contains an expression rather than just a number
@@ -1412,40 +2519,30 @@ void __fastcall TPlotWindow::Button_add_trace1Click(TObject *Sender)
   AnsiString FString; // Name of filter selected , "" if no filter selected
   static char cstring[64]; // small buffer  to use with snprintf
   TColor Col;
-  FILE *fin;
+  csv_reader *fin; // csv file, memory mapped if possible
   size_t lines_in_file;  // line number within file being read
   char *csv_line=NULL;// line of csv file
   char *st;
   int xcol,ycol;
   int64_t filesize;    // gives filesize which is then used to show progress as a %
-  bool xmonotonic=true; // true is trace is monotonic in x
-  bool firstxvalue; // true on 1st x value
-  bool gotyvalue; // set to true when a valid number found for y value
-  bool skipy; // set to true if we skip a string of identical y values
+  bool firstxvalue; // true till 1st valid x value is read (x values are shared by all traces)
   bool compress;
   bool showsortmessage=true; // only show "sort message" once per press of the "add traces" button
   bool showerrmessage=true; // ditto for message to warn users of errors in format of csv file
   int dupXmessage=0; // only ask if user wants to optimise duplicate X values once
-  float previousxvalue=0,previousyvalue=0,last_actual_x_value=0;
   double median_ahead_t; // >0 for median filtering to be used
   int poly_order=2;
   long double first_time=0; // used when reading times in for x axis, store times relative to 1st time
   int nos_traces_added=0;
-  bool allvalidxvals=true;
+  struct add_trace_item *traces=NULL; // one entry for every trace being added
+  int max_traces=0; // size of traces[]
   double x_offset;
   clock_t start_t,end_t;
-  size_t nos_errs=0; // count of errors found when reading values
-#define MAX_ERRS 2 /* max errors that will be displayyed in full */
-  /* defined below allow 1 example of each error type to be displayed to the user */
-#define ERR_TYPE1 0
-#define ERR_TYPE2 1
-#define ERR_TYPE3 2
-#define ERR_TYPE4 3
-#define ERR_TYPE5 4
-#define ERR_TYPE6 5
-#define ERR_TYPE7 6
-#define MAX_ERR_TYPES 7
+  size_t nos_errs=0; // count of errors found when reading values (limits number of errors displayed in full)
+  size_t nos_xerrs=0; // count of lines skipped due to errors in x values (these apply to every trace)
   bool found_error_type[MAX_ERR_TYPES];
+  int skip_initial_lines; // number of lines to skip before the header line
+  uint32_t hdr_hash; // hash of header line, used to check a sidecar file matches the csv file
 try{
   for(int i=0;i<MAX_ERR_TYPES;++i) found_error_type[i]=false;// set to true when an example of this type of error is found
   if(addtraceactive || xchange_running!=-1)
@@ -1460,6 +2557,7 @@ try{
   if(xchange_running!=-1) return; // still processing a change in x offset
   if(addtraceactive) return; // if still processing a previous call of addtrace
   addtraceactive=true;
+  follow_stop(); // reading a file resets the state used to read times (reset_days()), so cannot carry on following a file
   if(filename=="")
 		{ShowMessage("You must press \"Set Filename\" button to set the filename 1st");
          StatusText->Caption="No filename set";
@@ -1529,42 +2627,58 @@ try{
 		}
 
 
-   // use combination thats fastest  (binary and big buffer) - which ~ halves time
-#ifdef BIG_BUF_SIZE
-   static char *read_buf=NULL ;   // static so we only malloc it once
-   if(read_buf==NULL)
-		{read_buf=(char *)malloc(BIG_BUF_SIZE) ;
-		 if( read_buf==NULL)
-				{
-				 StatusText->Caption="No free RAM!";
-				 ShowMessage("No free RAM! cannot malloc space for read_buf");
-				 // continue anyway - just cannot use big read buffer
-				}
+   if(stream_fin!=NULL)
+		{// stdin or a pipe opened by proces_open_filename(), read it from the start again (using the lines it kept)
+		 fin=stream_fin;
+		 if(!csv_seek(fin,0))
+			{ShowMessage("Error: cannot read "+filename+" again");
+			 addtraceactive=false;// finished
+			 return;
+			}
+		}
+   else
+		{// memory map file if possible (avoids copying every line), otherwise csv_open() uses the fastest combination of binary and a big buffer
+		 fin=csv_open(Utf8_to_w(filename.c_str()));
 		}
-#endif
-   //fin=fopen(filename.c_str(),"rb");
-   fin=_wfopen(Utf8_to_w(filename.c_str()),L"rb");
    if(fin==NULL)
 		{ShowMessage("Error: cannot open file"+filename);
 		 addtraceactive=false;// finished
 		 return;
 		}
-  _fseeki64(fin, 0, SEEK_END);  // seek to end of file
-  filesize=_ftelli64(fin); // get size of file
-  _fseeki64(fin,0,SEEK_SET); // back to start of file
-#ifdef BIG_BUF_SIZE
-   if( read_buf!=NULL)
-		setvbuf(fin,read_buf,_IOFBF,BIG_BUF_SIZE); // buffer input if we have free RAM
-#endif
+  filesize=csv_filesize(fin); // get size of file
+  bool sampled=false; // true if only a sample of the file is read (File/Preview)
+  if(Previewfile1->Checked)
+	{if(csv_is_compressed(fin) || csv_is_stream(fin))
+		rprintf("Note: preview does not work with compressed files, stdin or pipes, all of the file will be read\n");
+	 else if(filesize<SAMPLE_MIN_BYTES)
+		rprintf("Note: file is small so all of it will be read (no preview)\n");
+	 else
+		sampled=true;
+	}
+  if(sample.filename==filename && sample.nos_graphs>0 && sample.first_graph+sample.nos_graphs==pScientificGraph->fnGetNumberOfGraphs())
+	{// replace the last preview of this file (it must still be the last graphs added)
+	 for(int g=sample.first_graph+sample.nos_graphs-1;g>=sample.first_graph;--g)
+		pScientificGraph->fnDeleteGraph(g); // from the last one backwards
+	 line_colour=sample.line_colour; // so traces have the same colours as the preview they replace
+	 rprintf("Preview of %s replaced\n",filename.c_str());
+	}
+  sample.filename="";
+  int sample_line_colour=line_colour; // line_colour before traces are added
 
   // rprintf("filename selected is %s\n",filename.c_str());
-  {int skip_initial_lines=_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str());
-   for(int l=0;l<=skip_initial_lines;++l)    // need to read 1 line if skip=0, 2 lines for skip=1, etc
-	 csv_line=readline(fin);
+  skip_initial_lines=_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str());
+  {int l=0;
+   int64_t line_offset;
+   size_t line_nos;
+   if(skip_initial_lines>=LINE_INDEX_STEP && line_index_lookup((size_t)skip_initial_lines,filesize,&line_offset,&line_nos) && csv_seek(fin,line_offset))
+	l=(int)line_nos; // go straight to the indexed line rather than reading all the lines before it
+   for(;l<=skip_initial_lines;++l)    // need to read 1 line if skip=0, 2 lines for skip=1, etc
+	 csv_line=csv_readline(fin);
   }
   if(csv_line==NULL)
         {ShowMessage("Error: cannot read headers from file "+filename);
-         fclose(fin);
+         if(fin==stream_fin) stream_fin=NULL; // stream has been read, so cannot be used again
+         csv_close(fin);
          filename="";
          StatusText->Caption="No filename set";
          addtraceactive=false;// finished
@@ -1572,14 +2686,16 @@ try{
         }
 
   StatusText->Caption="Reading File";
+  hdr_hash=hash_str(csv_line); // must be done before parsecsv() changes the line
   /* need to scan headers again , as need to have valid pointers in col_ptrs in case ycol is an expression */
   parsecsv(csv_line,col_ptrs, MAX_COLS);
+  nos_col_ptrs=MAX_COLS;
   //xcol must be an unsigned integer number or $number  (unless x source is "linenumber")
   char *s=strdup(Utf8Of(Edit_xcol->Text.c_str())),*xs,*ns; // must take a copy of string as if we just use pointer supplied below strange things happen !
   if(s==NULL)
         {
          ShowMessage("Error (No RAM): invalid xcol ["+Edit_xcol->Text+"] (valid range 1.."+AnsiString(MAX_COLS)+")");
-         fclose(fin);
+         close_csv(fin); // keeps a stream open so traces can still be added from it
          StatusText->Caption="Invalid xcol";
          addtraceactive=false;// finished
          return;
@@ -1599,7 +2715,7 @@ try{
      if(*xs!=0)    // should be at the end of the string if its just an unsigned integer number
         {// not a number
          ShowMessage("Error: invalid xcol ["+Edit_xcol->Text+"] (valid range 1.."+AnsiString(MAX_COLS)+")");
-         fclose(fin);
+         close_csv(fin); // keeps a stream open so traces can still be added from it
          StatusText->Caption="Invalid xcol";
          free(s);
          addtraceactive=false;// finished
@@ -1612,11 +2728,27 @@ try{
         {
          // rprintf("Error: invalid xcol (range 1..%d)\n",MAX_COLS);
          ShowMessage("Error: invalid xcol (range 1.."+AnsiString(MAX_COLS)+")");
-         fclose(fin);
+         close_csv(fin); // keeps a stream open so traces can still be added from it
          StatusText->Caption="Invalid xcol";
          addtraceactive=false;// finished
          return;
 		}
+  if(csv_nos_files(fin)>1 && Xcol_type->ItemIndex>=2 && Xcol_type->ItemIndex<=5)
+	{// a set of files, read them in x order so the x values do not need to be sorted
+	 if(skip_initial_lines>0)
+		rprintf("Note: lines are skipped at the start of the 1st file, so files are read in the order of their names\n");
+	 else if(order_files_by_x(fin,xcol))
+		{// a different file is now 1st, read its header (which is the same as the header already read)
+		 if((csv_line=csv_readline(fin))==NULL)
+			{ShowMessage("Error: cannot read headers from file "+filename);
+			 csv_close(fin);
+			 StatusText->Caption="No filename set";
+			 addtraceactive=false;// finished
+			 return;
+			}
+		 parsecsv(csv_line,col_ptrs, MAX_COLS);
+		}
+	}
   // get x offset from gui to a local variable as a double.
   #if 1
   if(getdouble(Edit_Xoffset->Text.c_str(), &x_offset) )
@@ -1630,13 +2762,18 @@ try{
   char *se=NULL;// expression (if there is one)
   bool isnumber;
   char *date_time_fmt=NULL;
+  strp_compiled *date_time_c=NULL;
   date_time_fmt=strdup(Utf8Of(Date_time_fmt->Text.c_str()));  // only do this once
-  if(Xcol_type->ItemIndex==6) rprintf("Date/time format is: %s\n",date_time_fmt);
+  if(Xcol_type->ItemIndex==6)
+	{rprintf("Date/time format is: %s\n",date_time_fmt);
+	 date_time_c=ya_strptime_compile(date_time_fmt); // NULL if format uses conversions that cannot be compiled, then ya_strptime() is used for every line
+	}
   s=strdup(Utf8Of(Edit_ycol->Text.c_str()));
   if(s==NULL||date_time_fmt==NULL)
         {
          ShowMessage("Error (No RAM): invalid ycol ["+Edit_ycol->Text+"] (valid range 1.."+AnsiString(MAX_COLS)+")");
-         fclose(fin);
+         close_csv(fin); // keeps a stream open so traces can still be added from it
+         ya_strptime_free(date_time_c);
          StatusText->Caption="Invalid ycol";
 		 addtraceactive=false;// finished
 		 return;
@@ -1761,13 +2898,34 @@ try{
         }
 #endif
 
-repeatcomma: // sorry for this !!!, come back here to add next trace if we find a comma in list of traces to add.
-  ++nos_traces_added; // number of traces added
-  // xmonotonic, true means trace is monotonic in x. This is set true at the start as the same x values are used for every trace added by this function, so for 2nd trace onwards is known to be valid
-  firstxvalue=true; // true on 1st x value
-  skipy=false; // have not skipped any values yet
-  gotyvalue=false; // have not got a valid y value yet
-
+  // count commas to get the maximum number of traces (commas inside expressions eg max(1,2) mean this can be an overestimate which is fine)
+  max_traces=1;
+  for(char *cp=ys;*cp;++cp)
+	if(*cp==',') ++max_traces;
+  traces=(struct add_trace_item *)calloc((size_t)max_traces,sizeof(struct add_trace_item)); // calloc() so all pointers start as NULL
+  if(traces==NULL)
+		{ShowMessage("Error: Not enough RAM");
+		 close_csv(fin); // keeps a stream open so traces can still be added from it
+		 StatusText->Caption="Not enough RAM";
+		 free(s);
+		 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
+		 ya_strptime_free(date_time_c); date_time_c=NULL;
+		 addtraceactive=false;// finished
+		 return; // error (not enough memory)
+		}
+  /* 1st decode all items in the (comma seperated) list in ycol, creating an empty graph for each.
+     The file is then read just once, with each line being split up just once and used to add a point to every trace.
+     Previously the file was read once for every item in the list (which takes a long time on big files with many columns).
+  */
+  bool item_error=false; // set true if we find an error in the list of y columns
+  while(nos_traces_added<max_traces)
+  {// decode next item in list
+  struct add_trace_item *tp=&traces[nos_traces_added];
+  tp->firstxvalue=true; // true on 1st x value
+  tp->gotyvalue=false; // have not got a valid y value yet
+  tp->xmonotonic=true; // true means trace is monotonic in x
+  tp->iGraph= -1; // no graph yet
+  tp->cache_col= -1; // y values not being saved to a sidecar file (yet)
   while(isspace(*ys)) ++ys; // skip optional leading whitespace
   start_s=ys; // start of this item [skipped initial whitespace]
   if(*ys=='$') ++ys; // allow for an optional $
@@ -1789,6 +2947,13 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 		 // the expression is terminated by a comma (,), but a command can be used in the expression eg as in max(1,2) so need to keep track of brackets as well as commas...
 		  int nos_bracket=0;
 		  se=strdup(start_s); // take a copy of the potential expression
+		  tp->se=se; // so its freed at the end
+		  if(se==NULL)
+				{ShowMessage("Error: Not enough RAM");
+				 StatusText->Caption="Not enough RAM";
+				 item_error=true;
+				 break;
+				}
 		  char *sp=se;
 		  while(!(nos_bracket==0 && *sp==',' ) && *sp)
 			{if(*sp=='(') nos_bracket++;
@@ -1812,19 +2977,22 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 				  print_rpn(); // print out rpn for debugging
 				  rprintf("\n");
 #endif
+				  tp->rpn=save_rpn(); // keep a copy of the rpn as we will compile more expressions before this one is used
+				  if(tp->rpn==NULL)
+					{ShowMessage("Error: Not enough RAM");
+					 StatusText->Caption="Not enough RAM";
+					 item_error=true;
+					 break;
+					}
 				  // use se later in title for trace so cannot free yet
 				}
 		  else
 				{
 				 // not a number , or a valid expression
 				 ShowMessage("Error: ycol ["+Edit_ycol->Text+"] contains an invalid expression["+se+"]");
-                 fclose(fin);
                  StatusText->Caption="Invalid expression for ycol";
-                 free(s);
-				 free(se);
-				 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
-                 addtraceactive=false;// finished
-                 return;
+				 item_error=true;
+				 break;
                 }
         }
      else
@@ -1832,17 +3000,19 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
          ycol=atoi(ns);   // number (leading $ removed)
         }
     }
-  if(*ys!=',') {free(s);s=NULL;}
   if(ycol<1 || (unsigned int)ycol> MAX_COLS)
         {
          // rprintf("Error: invalid ycol (range 1..%d)\n",MAX_COLS);
 		 ShowMessage("Error: invalid ycol (range 1.."+AnsiString(MAX_COLS)+")");
-		 fclose(fin);
 		 StatusText->Caption="Invalid ycol";
-		 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
-		 addtraceactive=false;// finished
-		 return;
+		 item_error=true;
+		 break;
         }
+  tp->ycol=ycol;
+  tp->yexpr=yexpr;
+  if(!yexpr && (unsigned int)ycol<=nos_col_profiles && col_profiles[ycol-1].type==COL_TEXT)
+	rprintf("Warning: column %d appears to contain text rather than numbers (from the lines sampled when the file was opened)\n",ycol);
+  tp->int_col= !yexpr && (unsigned int)ycol<=nos_col_profiles && col_profiles[ycol-1].type==COL_INT; // fast_strtof_int() still checks every value, so a wrong guess only costs speed
   // rprintf("xcol=%d ycol=%d\n",xcol,ycol);
   line_colour=(line_colour+1);    // next colour
 
@@ -1899,15 +3069,16 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 	}
 
 
-  iGraph=pScientificGraph->fnAddGraph(nos_lines_in_file);  //iGraph==graph index  , 0 for 1st, 1 for 2nd...  -1 => error
+  // all traces added here have the same x values (unless a line has an invalid y value for some of them) so they share the 1st trace's x values
+  iGraph=pScientificGraph->fnAddGraph(sampled ? min(nos_lines_in_file,(size_t)SAMPLE_BLOCKS*SAMPLE_BLOCK_LINES) : nos_lines_in_file,nos_traces_added>0 ? traces[0].iGraph : -1);  //iGraph==graph index  , 0 for 1st, 1 for 2nd...  -1 => error
   if(iGraph<0)
 		{ShowMessage("Error: Not enough RAM");
-		 fclose(fin);
 		 StatusText->Caption="Not enough RAM";
-		 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
-		 addtraceactive=false;// finished
-		 return; // error (not enough memory)
+		 item_error=true;
+		 break; // error (not enough memory)
 		}
+  tp->iGraph=iGraph;
+  ++nos_traces_added; // number of traces added
   //rprintf("iGraph=%d\n",iGraph);
   pScientificGraph->fnSetColDataPoint(Col,iGraph);    //set colors
   pScientificGraph->fnSetColErrorBar(Col,iGraph);
@@ -1975,42 +3146,41 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 	}
   }
 
-  char cap_str[256]; // caption for trace   (used for error messages later as well as graph caption her)
   // add ledgend for trace - add (XXX filter=%g) if a filter is in use
   AnsiString basename;
   basename=filename.SubString(filename.LastDelimiter("\\:")+1,128)+" : ";// in case CheckBox_legend_add_filename is ticked
-  if(yexpr)
-		{ rprintf("Adding trace of %s (expression)\n vs %s (col %d)\n",se,hdr_col_ptrs[xcol-1],xcol);
+  AnsiString sample_str=sampled ? " (preview)" : ""; // added to legend for traces that only have a sample of the file
+  if(tp->yexpr)
+		{ rprintf("Adding trace of %s (expression)\n vs %s (col %d)\n",tp->se,hdr_col_ptrs[xcol-1],xcol);
 		  if(FString=="")
-			  snprintf(cap_str,sizeof(cap_str),"%s",se);
+			  snprintf(tp->cap_str,sizeof(tp->cap_str),"%s",tp->se);
 		  else
 			{
-			 if(is_filter) snprintf(cap_str,sizeof(cap_str),"%s (%s, t/c=%g)",se,FString.c_str(), median_ahead_t);
-			 else          snprintf(cap_str,sizeof(cap_str),"%s (%s)",se,FString.c_str());
+			 if(is_filter) snprintf(tp->cap_str,sizeof(tp->cap_str),"%s (%s, t/c=%g)",tp->se,FString.c_str(), median_ahead_t);
+			 else          snprintf(tp->cap_str,sizeof(tp->cap_str),"%s (%s)",tp->se,FString.c_str());
 			}
 		  if(CheckBox_legend_add_filename->State==cbChecked)
 			{// add basename of filename to legend
-			 pScientificGraph->fnSetCaption(basename+cap_str,iGraph); //graph caption
+			 pScientificGraph->fnSetCaption(basename+tp->cap_str+sample_str,iGraph); //graph caption
 			}
 		  else
-			pScientificGraph->fnSetCaption(cap_str,iGraph); //graph caption
-		  free(se); // can free se now as have printed titles
+			pScientificGraph->fnSetCaption(AnsiString(tp->cap_str)+sample_str,iGraph); //graph caption
 		}
   else
 		{ rprintf("Adding trace of %s (col %d)\n vs %s (col %d)\n",hdr_col_ptrs[ycol-1],ycol,hdr_col_ptrs[xcol-1],xcol);
 		  if(FString=="")
-			  snprintf(cap_str,sizeof(cap_str),"%s",hdr_col_ptrs[ycol-1]); // deleted space after %s PJM 3/6/2024
+			  snprintf(tp->cap_str,sizeof(tp->cap_str),"%s",hdr_col_ptrs[ycol-1]); // deleted space after %s PJM 3/6/2024
 		  else
 			{
-			 if(is_filter) snprintf(cap_str,sizeof(cap_str),"%s (%s, t/c=%g)",hdr_col_ptrs[ycol-1],FString.c_str(), median_ahead_t);
-			 else          snprintf(cap_str,sizeof(cap_str),"%s (%s)",hdr_col_ptrs[ycol-1],FString.c_str());
+			 if(is_filter) snprintf(tp->cap_str,sizeof(tp->cap_str),"%s (%s, t/c=%g)",hdr_col_ptrs[ycol-1],FString.c_str(), median_ahead_t);
+			 else          snprintf(tp->cap_str,sizeof(tp->cap_str),"%s (%s)",hdr_col_ptrs[ycol-1],FString.c_str());
 			}
 		  if(CheckBox_legend_add_filename->State==cbChecked)
 			{// add basename of filename to legend
-			 pScientificGraph->fnSetCaption(basename+cap_str,iGraph); //graph caption
+			 pScientificGraph->fnSetCaption(basename+tp->cap_str+sample_str,iGraph); //graph caption
 			}
 		  else
-			pScientificGraph->fnSetCaption(cap_str,iGraph); //graph caption
+			pScientificGraph->fnSetCaption(AnsiString(tp->cap_str)+sample_str,iGraph); //graph caption
 		}
 #if 1
   // automatically add y axis label
@@ -2020,12 +3190,34 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 	 Edit_y->Text=Utf8_to_w(hdr_col_ptrs[ycol-1]);
 	}
 #endif
+  if(*ys!=',') break; // end of list
+  ++ys; // skip , - multiple items are comma seperated
+  } // end of while() decoding list of y columns
+  free(s);
+  s=NULL;
+  if(item_error)
+		{// error found in list of y columns, message has already been shown to the user
+		 close_csv(fin); // keeps a stream open so traces can still be added from it
+		 for(int t=nos_traces_added-1;t>=0;--t)
+			pScientificGraph->fnDeleteGraph(traces[t].iGraph); // delete (empty) graphs already created, these are at the end so delete from the last one backwards
+		 free_add_trace_items(traces,max_traces);
+		 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
+		 ya_strptime_free(date_time_c); date_time_c=NULL;
+		 addtraceactive=false;// finished
+		 return;
+		}
 
-  unsigned int max_col=max((unsigned int)xcol,(unsigned int)ycol);
-
+  unsigned int max_col=(unsigned int)xcol;
+  bool any_yexpr=false; // true if at least 1 trace is an expression
+  for(int t=0;t<nos_traces_added;++t)
+	{if(traces[t].yexpr)
+		{any_yexpr=true;
+		 max_col=max(max_col,saved_rpn_max_dollar_col(traces[t].rpn)); // expression only needs columns up to the highest $n it uses
+		}
+	 else max_col=max(max_col,(unsigned int)traces[t].ycol);
+	}
   max_col=min(max_col,MAX_COLS); // only process the required channels on csv read (saves a little time).
-
-  if(yexpr) max_col=MAX_COLS;  // if there is an expression for y we need to read all the columns
+  nos_col_ptrs=max_col; // get_dollar_var_value() must not look at columns past max_col as they are not set by parsecsv()
 #if 0
   // some checks of functions that read times
   char *t_string;
@@ -2076,20 +3268,294 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
  // this is the normal working code
 
   reset_days(); // in case we are reading in times
+  time_layout=TIME_LAYOUT_UNKNOWN; // layout of times is found from 1st line
+  if(Xcol_type->ItemIndex==1 && (unsigned int)xcol<=nos_col_profiles && col_profiles[xcol-1].type==COL_TIME)
+	time_layout=col_profiles[xcol-1].time_layout; // use layout found when the file was opened (its still checked for every line, so this is always safe)
+  bool no_quotes=max_col<=nos_col_profiles; // true if no quotes were found in the columns we need when the file was opened, parsecsv_noquotes() then splits lines faster
+  for(unsigned int c=0;c<max_col && no_quotes;++c)
+	if(col_profiles[c].quoted) no_quotes=false; // parsecsv_noquotes() also passes any line with a quote to parsecsv(), so this is always safe
   bool file_has_dates=false;
-  bool got_date;
+  bool out_of_ram=false; // set true if fnAddDataPoint() fails
+  pnlist px=NULL,pX=NULL,pline=NULL; // predefined "variables" for expressions, set for every line read
+  if(any_yexpr)
+	{px=lookup("x");
+	 pX=lookup("X");  // also allow cap X
+	 pline=lookup("line");
+	}
+  float xval_offset; // xval+x_offset - value actually added to graph
   lines_in_file=0;
-  nos_errs=0;  // count of errors for this "column" as thats how its reported to user
+  nos_errs=0;
+  nos_xerrs=0;
+  firstxvalue=true;
   clock_t begin_t,end_t2s;
+  int nos_read_threads=1; // number of threads used to read the file
+  int64_t data_end=filesize; // offset in file just after the last line read (used to follow the file)
+  bool compressed_file=csv_is_compressed(fin); // compressed files cannot be followed
+  bool stream_file=csv_is_stream(fin); // nor can stdin or pipes
+  bool file_set=csv_nos_files(fin)>1; // or a set of files
+  bool stop_at_data_end= Followfile1->Checked && !compressed_file && !stream_file && !file_set && !sampled && FilterType->ItemIndex==0; // file will be followed (see follow_start() below)
+  if(stop_at_data_end)
+	data_end=last_line_end(Utf8_to_w(filename.c_str()),csv_tell(fin),filesize); // don't read a last line that is still being written, follow_add_lines() will add it when it is complete
+  // The file is read by the main thread (which still shows progress and previews and calls ProcessMessages() every 32768 lines) for:
+  //  - y expressions: execute_saved_rpn() uses the global symbol table and $n reads the global col_ptrs[], so expressions cannot be evaluated by other threads
+  //  - x type 1 (times): gethms_days() counts days by spotting when the time wraps around, so each line depends on the ones before it and the count is in static variables.
+  //    A chunk cannot know how many days the chunks before it contain, and the layout of times (time_layout) is also shared.
+  //  - x type 6 (date/time format): ya_strptime() keeps the time zone in the global strp_tz, and get_xval() reports errors with rprintf() which worker threads must not use
+  //  - sampled files (File/Preview): only a few % of the file is read (seeking between blocks), so this is quick anyway
+  bool use_read_threads= !any_yexpr && Xcol_type->ItemIndex!=1 && Xcol_type->ItemIndex!=6 && !sampled; // if true file is read by worker thread(s) (see parse_chunk_thread() )
+  double x_origin=0; // subtracted from x values read by worker threads
+  if(use_read_threads && start_time_from_0 && Xcol_type->ItemIndex>=2)
+	{// worker threads need the 1st x value before they start
+	 if(first_x_value(fin,Xcol_type->ItemIndex,xcol,max_col,&x_origin))
+		{first_time=x_origin; // also used if the file is read below by the main thread, or is followed
+		 firstxvalue=false;
+		}
+	 else
+		use_read_threads=false; // main thread finds the 1st x value as it reads the file
+	}
+  if(use_read_threads && csv_is_mapped(fin))
+	nos_read_threads=read_threads_to_use(data_end-csv_tell(fin));
+#ifdef USE_CSV_CACHE
+  csv_cache *cache=NULL; // sidecar file with values from the csv file (only kept open if it has all the values we need)
+  csv_cache_writer *cache_w=NULL; // collects values read from the csv file so they can be written to a sidecar file
+  const float *cached_x=NULL; // x values from sidecar file
+  int cache_xcol= -1; // column in cache_w for x values
+  uint32_t cache_xkey=x_cache_key(Xcol_type->ItemIndex,xcol,start_time_from_0,date_time_fmt);
+  if(!any_yexpr && filesize>=CSV_CACHE_MIN_BYTES && !sampled && !file_set && !Followfile1->Checked) // a sample must not be saved in a sidecar file, there is no single file to put next to a set of files,
+	// and a followed file must be read as lines added to it need the time on the 1st line and the day state at the end of the file (see follow_start() ) which are not in the sidecar file
+	{cache=csv_cache_open(Utf8_to_w(filename.c_str()),hdr_hash,(uint32_t)skip_initial_lines);
+	 if(cache!=NULL)
+		{bool have_all=true; // set to false if any values we need are not in the sidecar file
+		 if(Xcol_type->ItemIndex!=0)
+			{cached_x=csv_cache_column(cache,CSV_CACHE_X,cache_xkey,cache_xkey);
+			 if(cached_x==NULL) have_all=false;
+			}
+		 for(int t=0;t<nos_traces_added && have_all;++t)
+			{traces[t].cached_y=csv_cache_column(cache,CSV_CACHE_Y,(uint32_t)traces[t].ycol,cache_xkey);
+			 if(traces[t].cached_y==NULL) have_all=false;
+			}
+		 if(!have_all)
+			{csv_cache_close(cache); // need to read the csv file, the sidecar file will then be updated
+			 cache=NULL;
+			 for(int t=0;t<nos_traces_added;++t)
+				traces[t].cached_y=NULL;
+			}
+		}
+	 if(cache==NULL)
+		{cache_w=csv_cache_writer_new(Utf8_to_w(filename.c_str()));
+		 if(cache_w!=NULL)
+			{if(Xcol_type->ItemIndex!=0)
+				cache_xcol=csv_cache_writer_column(cache_w,CSV_CACHE_X,cache_xkey);
+			 for(int t=0;t<nos_traces_added;++t)
+				traces[t].cache_col=csv_cache_writer_column(cache_w,CSV_CACHE_Y,(uint32_t)traces[t].ycol);
+			}
+		}
+	}
+  if(cache!=NULL)
+	{// all the values we need are in the sidecar file so there is no need to read the csv file
+	 size_t nos_lines=csv_cache_nos_lines(cache);
+	 nos_read_threads=0; // skips reading the csv file below
+	 rprintf("Reading values from cache file %s.csvgraph-cache\n",filename.c_str());
+	 for(size_t i=0;i<nos_lines && !out_of_ram;++i)
+		{if((i & 0xfffff)==0)
+			{snprintf(cstring,sizeof(cstring),"%.0f %% read from cache",100.0*(double)i/(double)nos_lines);
+			 StatusText->Caption=cstring;
+			 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+			}
+		 if(cached_x==NULL)
+			xval=i+1; // x=linenumber in file
+		 else
+			{xval=cached_x[i];
+			 if(!_finite(xval))
+				{++nos_xerrs; // line skipped for all traces (invalid values are NAN in the sidecar file)
+				 ++nos_errs;
+				 continue;
+				}
+			}
+		 firstxvalue=false; // have now got a valid x value
+		 xval_offset= x_offset==0?xval:(float)(xval+x_offset);
+		 for(int t=0;t<nos_traces_added;++t)
+			{struct add_trace_item *tp=&traces[t];
+			 yval=tp->cached_y[i];
+			 if(isnan(yval))
+				{++tp->nos_errs; // invalid number on this line
+				 ++nos_errs;
+				 continue;
+				}
+			 tp->gotyvalue=true;// a valid y value
+			 if(!_finite(yval))
+				{++tp->nos_errs;
+				 ++nos_errs;
+				 continue; // need 2 valid numbers [eg ignore "inf" ]
+				}
+			 if(!add_point_to_trace(pScientificGraph,tp,xval,xval_offset,yval))
+				{// out of RAM
+				 out_of_ram=true;
+				 break;
+				}
+			}
+		}
+	 lines_in_file=nos_lines;
+	 if(nos_errs>0)
+		rprintf("Warning: %zu invalid values found in cache file (the csv file must be read to see examples of the errors - delete the cache file to do this)\n",nos_errs);
+	 csv_cache_close(cache);
+	 cache=NULL;
+	}
+#endif
+  bool first_graph=traces[0].iGraph==0;
+  bool zoomed_at_start=zoomed; // if user zooms while the file is being read we don't autoscale at the end
+  clock_t next_preview=clock()+PREVIEW_INTERVAL; // time to next redraw traces while they are being read
+  if(nos_read_threads>1 || (nos_read_threads==1 && use_read_threads))
+	{// read file using worker thread(s), multiple threads each read a part of the file, a single thread reads it all (using fin)
+	 HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+	 int nos_threads;
+	 int64_t data_start=csv_tell(fin); // data starts after the header line (and any lines skipped before that)
+	 bool keep_line_nos=false; // line numbers are needed to save values in a sidecar file
+#ifdef USE_CSV_CACHE
+	 keep_line_nos= cache_w!=NULL;
+#endif
+	 struct parse_chunk *chunks=start_parse_chunks(Utf8_to_w(filename.c_str()),nos_read_threads==1 ? fin : NULL,data_start,nos_read_threads==1 && !stop_at_data_end ? 0 : data_end,nos_read_threads,Xcol_type->ItemIndex,xcol,x_origin,max_col,no_quotes,traces,nos_traces_added,keep_line_nos,threads,&nos_threads);
+	 if(chunks==NULL)
+		{rprintf("Cannot read file with worker threads - reading it directly\n");
+		 nos_read_threads=1;
+		 use_read_threads=false;
+		}
+	 else
+		{if(nos_read_threads>1) rprintf("Reading file using %d threads\n",nos_threads);
+		 // add the values read by each thread to the traces in file order as they become available, showing progress to the user
+		 int c_next=0; // chunk whose values are being added to the traces
+		 clock_t next_progress=clock();
+		 while(c_next<nos_read_threads && !out_of_ram)
+			{struct parse_chunk *cp=&chunks[c_next];
+			 bool finished;
+			 struct chunk_batch *batches=take_chunk_batches(cp,&finished);
+			 bool got_values= batches!=NULL;
+			 for(struct chunk_batch *bp=batches;bp!=NULL && !out_of_ram;bp=bp->next)
+				{for(size_t i=0;i<bp->nos_pts && !out_of_ram;++i)
+					{if(Xcol_type->ItemIndex==0)
+						xval=lines_in_file+bp->line_nos[i]; // x=linenumber in file
+					 else
+						xval=bp->x[i];
+					 firstxvalue=false; // have now got a valid x value
+					 xval_offset= x_offset==0?xval:(float)(xval+x_offset);
+#ifdef USE_CSV_CACHE
+					 if(cache_w!=NULL)
+						{size_t line=lines_in_file+bp->line_nos[i]-1; // 0 for 1st line after the header
+						 csv_cache_set(cache_w,cache_xcol,line,xval);
+						 for(int t=0;t<nos_traces_added;++t)
+							if(bp->valid[t][i]) csv_cache_set(cache_w,traces[t].cache_col,line,bp->y[t][i]);
+						}
+#endif
+					 for(int t=0;t<nos_traces_added;++t)
+						{if(!bp->valid[t][i]) continue; // no number found (reported when the chunk has been read)
+						 yval=bp->y[t][i];
+						 traces[t].gotyvalue=true;// a valid y value, as for the main thread this includes "nan" and "inf"
+						 if(!_finite(yval)) continue; // need 2 valid numbers [eg ignore "inf" ] (also reported when the chunk has been read)
+						 if(!add_point_to_trace(pScientificGraph,&traces[t],xval,xval_offset,yval))
+							{// out of RAM
+							 out_of_ram=true;
+							 break;
+							}
+						}
+					}
+				}
+			 free_chunk_batches(batches); // free memory used as soon as possible
+			 if(out_of_ram) break;
+			 if(finished)
+				{// all of this chunk has been added to the traces
+				 if(cp->out_of_ram)
+					{out_of_ram=true;
+					 break;
+					}
+				 // report errors exactly as they would be if the file was read by the main thread
+				 for(int e=0;e<cp->nos_chunk_errs;++e)
+					{struct chunk_err *ep=&cp->errs[e];
+					 if(nos_errs+ep->err_nos<=MAX_ERRS || !found_error_type[ep->err_type])
+						{found_error_type[ep->err_type]=true;
+						 print_chunk_error(ep,lines_in_file+ep->line+1);
+						}
+					}
+				 nos_errs+=cp->nos_errs;
+				 nos_xerrs+=cp->nos_xerrs;
+				 for(int t=0;t<nos_traces_added;++t)
+					traces[t].nos_errs+=cp->nos_yerrs[t];
+				 lines_in_file+=cp->lines;
+				 free_parse_chunk(cp); // free memory used by this chunk as soon as possible
+				 ++c_next;
+				 continue;
+				}
+			 if(clock()>=next_progress)
+				{int64_t bytes_read=0;
+				 size_t lines_read=0;
+				 next_progress=clock()+CLOCKS_PER_SEC/4;
+				 for(int c=0;c<nos_read_threads;++c)
+					{bytes_read+=InterlockedCompareExchange64(&chunks[c].bytes_read,0,0); // atomic read
+					 lines_read+=chunks[c].lines_read;
+					}
+				 if(csv_is_stream(fin))
+					snprintf(cstring,sizeof(cstring),"%zu lines read (%.1f MB)",lines_read,(double)(data_start+bytes_read)/1e6); // size of a stream is unknown
+				 else if(line_index_valid(filesize))
+					snprintf(cstring,sizeof(cstring),"%.0f %% read (%zu of %zu lines)",100.0*(double)(data_start+bytes_read)/(double)filesize,lines_read,nos_lines_in_file);
+				 else
+					snprintf(cstring,sizeof(cstring),"%.0f %% read",100.0*(double)(data_start+bytes_read)/(double)filesize);
+				 StatusText->Caption=cstring;
+				}
+			 if(clock()>=next_preview)
+				{// show what has been read so far, the user can zoom etc while the rest of the file is read
+				 clock_t t0=clock();
+				 if(preview_scales(pScientificGraph,traces,nos_traces_added,first_graph))
+					fnReDraw();
+				 next_preview=clock()+max(PREVIEW_INTERVAL,4*(clock()-t0)); // don't spend more than 20% of the time redrawing
+				}
+			 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+			 if(!got_values && nos_threads>0)
+				WaitForMultipleObjects((DWORD)nos_threads,threads,TRUE,50); // nothing to do, so wait a little for the threads (returns at once when all have finished)
+			}
+		 for(int c=0;c<nos_read_threads;++c)
+			chunks[c].stop=true; // only needed if we have stopped early (eg out of RAM)
+		 if(nos_threads>0)
+			WaitForMultipleObjects((DWORD)nos_threads,threads,TRUE,INFINITE);
+		 for(int c=0;c<nos_threads;++c)
+			CloseHandle(threads[c]);
+		 free_parse_chunks(chunks,nos_read_threads);
+		}
+	}
   begin_t=clock();
-  while(1)
+  int64_t sample_start=csv_tell(fin); // for a preview blocks are evenly spaced from here to the end of the file
+  int sample_block=0,sample_lines=0; // block being read, and lines read from it
+  if(sampled)
+	{rprintf("Preview: reading %d lines from each of %d parts of the file\n",SAMPLE_BLOCK_LINES,SAMPLE_BLOCKS);
+	 if(Xcol_type->ItemIndex==1)
+		rprintf("Note: if the file has times without dates the day may be wrong in a preview (as days are counted when the time wraps around)\n");
+	}
+  while(nos_read_threads==1 && !use_read_threads) // read file with the main thread (loop is skipped if file has already been read by worker threads above)
 		{
-		 csv_line=readline(fin);
+		 if(sampled && ++sample_lines>SAMPLE_BLOCK_LINES)
+				{// move on to the next block, starting at the 1st whole line in it
+				 bool found=false;
+				 sample_lines=1;
+				 while(!found && ++sample_block<SAMPLE_BLOCKS)
+					{int64_t offset=sample_start+(filesize-sample_start)*sample_block/SAMPLE_BLOCKS;
+					 if(offset>csv_tell(fin)) found=csv_seek_line(fin,offset); // else block starts in the lines just read
+					 else found=true;
+					}
+				 if(!found) break; // end of file
+				 if(nos_lines_in_file>0)
+					{size_t est_line=(size_t)((double)nos_lines_in_file*(double)(csv_tell(fin)-sample_start)/(double)(filesize-sample_start)); // estimate of line number (used for x if x is the line number)
+					 if(est_line>lines_in_file) lines_in_file=est_line; // line numbers must never go backwards
+					}
+				}
+		 csv_line=csv_readline(fin);
 		 if(csv_line==NULL)
 				{break;// whole file read
 				}
+		 if(stop_at_data_end && csv_tell(fin)>data_end)
+				break; // incomplete last line of a file that will be followed
 
-		 parsecsv(csv_line,col_ptrs, max_col);   // was MAX_COLS, its slightly faster using max_col
+		 if(no_quotes)
+			parsecsv_noquotes(csv_line,col_ptrs, max_col);
+		 else
+			parsecsv(csv_line,col_ptrs, max_col);   // was MAX_COLS, its slightly faster using max_col
 		 lines_in_file++;
 		 if((lines_in_file & 0x7fff)==1)     // ==1 means we start with 0% read . Was 0x3ff   , 0x7fff gives one every 40ms in a typical case
 				{// let user see something happening , printing to the screen is slow so only do this occasionally
@@ -2099,207 +3565,65 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 						 if(lines_in_file!=1)
 								begin_t+=2*CLK_TCK; // move forward 2 secs  (unless 1st line in file)
 #if 1
-						 if(yexpr)
-								{snprintf(cstring,sizeof(cstring),"%.0f %% read",100.0*(double)_ftelli64(fin)/(double)filesize);
+						 if(csv_is_stream(fin))
+								{snprintf(cstring,sizeof(cstring),"%zu lines read (%.1f MB)",lines_in_file,(double)csv_tell(fin)/1e6); // size of a stream is unknown
+								}
+						 else if(line_index_valid(filesize))
+								{snprintf(cstring,sizeof(cstring),"%.0f %% read (%zu of %zu lines)",100.0*(double)csv_tell(fin)/(double)filesize,lines_in_file,nos_lines_in_file);
+								}
+						 else if(nos_traces_added>1 || any_yexpr)
+								{snprintf(cstring,sizeof(cstring),"%.0f %% read",100.0*(double)csv_tell(fin)/(double)filesize);
 								}
 						  else
-								{snprintf(cstring,sizeof(cstring),"%.0f %% read of column %d",100.0*(double)_ftelli64(fin)/(double)filesize,ycol);
+								{snprintf(cstring,sizeof(cstring),"%.0f %% read of column %d",100.0*(double)csv_tell(fin)/(double)filesize,traces[0].ycol);
 								}
 #else
 						 snprintf(cstring,sizeof(cstring),"%zu lines read ",lines_in_file);
 #endif
 						 StatusText->Caption=cstring;
                         }
+				 if(end_t2s>=next_preview)
+						{// show what has been read so far, the user can zoom etc while the rest of the file is read
+						 clock_t t0=clock();
+						 if(preview_scales(pScientificGraph,traces,nos_traces_added,first_graph))
+								fnReDraw();
+						 next_preview=clock()+max(PREVIEW_INTERVAL,4*(clock()-t0)); // don't spend more than 20% of the time redrawing
+						}
                  Application->ProcessMessages(); /* allow windows to update (but not go idle), do this regularly [not just every 2 secs] */
 				}
 
-		 // get x value
-		 if(allvalidxvals && nos_traces_added>1 && xmonotonic && !compress && dupXmessage!=IDNO )  // This optimisation disabled if lines with invalid xvals found (and skipped)
-			{xval=(float)((double)(pScientificGraph->fnAddDataPoint_nextx(iGraph))-x_offset); // same value as previous graph loaded  as this is faster than decoding it again , x_offset will be added later but is already in previous trace so must subtract here
-			 if(!firstxvalue && xval<previousxvalue)
-				{if(++nos_errs<=MAX_ERRS)
-					rprintf("Error: adding x value from previous trace and values not monotonic at line %zu xval=%g\n",lines_in_file+1,xval);
-				 xval=previousxvalue; // try and fix issue
-				 allvalidxvals=false; // stop problem repeating by turning off this optimisation
-				}
-			}
-		 else
-			{long double ti;   // ti is the time just read in - this needs as much resolution as possible - first_time is also a long double
-			 switch(Xcol_type->ItemIndex)
-				{case 0: xval=lines_in_file; // x=linenumber in file
-						break;
-				 case 1: // time h:m:s.s (with optional date of form 05-Jul-19 or 2020-03-31 or similar terminated in whitespace)
-						st=col_ptrs[xcol-1];
-						while(isspace(*st)) ++st; // skip any leading whitespace
-						if(*st=='"')
-								{++st;// skip " if present
-								 while(isspace(*st)) ++st; // skip any more whitespace
-								}
-						 {char *dptr; // look ahead to see if there is a date we need to skip
-										// date is either 05-Jul-19 or 2020-03-31 or 12/12/20 or similar terminated in whitespace
-						  got_date=false;
-						  for(dptr=st;*dptr;++dptr)
-								{if(*dptr=='-' || *dptr=='/')
-										{got_date=true;
-										 break;
-										}
-								 if(*dptr==':')
-										{// found a time, not a date
-										 break;
-										}
-								}
-						   if(got_date)
-								{for(;*dptr;++dptr)
-										if(isspace(*dptr)) break;// carry on from where we were, look for whitespace which marks end of date
-								 while(isspace(*dptr)) ++dptr;  // skip whitespace so should be at start of time
-								 if(isdigit(*dptr)) st=dptr; // if we ended up on a digit then assume this is the start of the time
-								 file_has_dates=true;
-								}
-						  }
-						// convert time into seconds , gethms_days() ignores trailing whitespace and "'s
-						ti=gethms_days(st);  // note we called reset_days above so we always start correctly at 0 days
-						if(ti<0)
-							{allvalidxvals=false;
-							 if((++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE1]) && ti== -1)
-								{found_error_type[ERR_TYPE1]=true; // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has an invalid date/time (time does not start with a number): %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-								}
-							 if((nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE2]) && ti!= -1)
-								{found_error_type[ERR_TYPE2]=true;  // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has an invalid date/time (time goes backwards!): %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-								}
-							 continue;   // gethms_days() returns a -ve value when it finds an error, so ignore this line when that happens
-							}
-						 if(!got_date && file_has_dates)
-							{ // this has to be after checks on time as we want a header line to be picked up as ERR_TYPE1 not type7
-							 if((++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE7]) )
-								{found_error_type[ERR_TYPE7]=true; // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has no date but previous lines do have dates: %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-								}
-							}
-						if(firstxvalue) first_time=ti;  // remember 1st value, and potentially use as ofset for the rest of the values
-						if(start_time_from_0)
-							{
-							 /* line below assumes times are in increasing order which is NOT guaranteed ! */
-							 /* However, first_time is a double, as is ti so this potentially offers higher resolution as the difference is stored as a float */
-							 xval=(float)(ti-first_time);  // ofset time by time of 1st value (so we maximise resolution in the float xval)
-							}
-						  else
-							{
-							 xval=(float)ti; // can loose resolution for big times, but we are limited by storing xvalues as floats.
-							}
-						break;
-				 case 6: // date/time with user specified format  - stored in char * date_time_fmt
-						{ // there is no need to skip initial whitespace or deal with quotes here as can be defined in date_time_fmt
-						 //char * ya_strptime(const char *s, const char *format, struct tm *tm)
-						 char *dptr;
-						 struct tm my_tm;
-						 memset(&my_tm, 0, sizeof(struct tm));// zero all members of tm
-						 strp_tz.initialised=0; // mark as not initialised, so will be zeroed on call to ya_strptime();
-						 st=col_ptrs[xcol-1];
-						 dptr=ya_strptime(st,date_time_fmt,&my_tm);
-						 if(dptr==NULL)
-							{// something was wrong with date/time or format
-							 allvalidxvals=false;
-							 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE1] )
-								{found_error_type[ERR_TYPE1]=true; // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has an invalid date/time (strptime(\"%s\") returned NULL): %s\n",lines_in_file+1,date_time_fmt,col_ptrs[xcol-1]);
-								}
-							 continue;      // ignore line
-							}
-						 while(isspace(*dptr)) ++dptr; // if remainder is whitespace then thats OK
-						 if(*dptr!=0)
-							{ // ya_strptime() did not process all of the string  again issue could be date/time or format
-							 allvalidxvals=false;
-							 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE2] )
-								{found_error_type[ERR_TYPE2]=true;  // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has an invalid date/time (format \"%s\" did not match whole string: %s [\"%s\" left])\n",lines_in_file+1,date_time_fmt,col_ptrs[xcol-1],dptr);
-								}
-							 continue;      // ignore line
-							}
-						 if(!check_tm(&my_tm))
-							{ // invalid date/time found
-							 allvalidxvals=false;
-							 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE3] )
-								{found_error_type[ERR_TYPE3]=true;  // note we have printed an example of this type of error
-								 rprintf("Warning: x value on line %zu has an invalid date/time (check_tm() failed): %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-								}
-							 continue;   // ignore line
-							}
-						 ti=ya_mktime(&my_tm); /* fully functional version of mktime() that returns secs and takes (and changes if necessary) timeptr */
-						 ti+=strp_tz.f_secs;// add in any fractional seconds (ti is a long double to maximise resolution here) */
-
-						if(firstxvalue)
-							{first_time=ti;  // remember 1st value, and potentially use as offset for the rest of the values
-							}
-						if(start_time_from_0)
-							{
-							 /* line below assumes times are in increasing order which is NOT guaranteed ! */
-							 /* However, first_time is a double, as is ti so this potentially offers higher resolution as the difference is stored as a float */
-							 xval=(float)(ti-first_time);  // offset time by time of 1st value [both are long doubles] (so we maximise resolution in the float xval)
-							}
-						  else
-							{
-							 xval=(float)ti; // can loose resolution for big times, but we are limited by storing xvalues as floats.
-							}
-#if 0
-						if(lines_in_file<5)
-							{// useful for debugging
-							 rprintf("date/time on line %zu returns %g secs (format \"%s\" line: %s, ti=%g)\n",lines_in_file+1,xval,date_time_fmt,col_ptrs[xcol-1],ti);
-							}
+		 // get x value - this is only done once per line, the same x value is then used for all traces
+		 if(!get_xval(Xcol_type->ItemIndex,col_ptrs[xcol-1],date_time_fmt,date_time_c,lines_in_file,firstxvalue,&first_time,&file_has_dates,&nos_xerrs,&nos_errs,found_error_type,&xval))
+			continue; // invalid x value (error has been reported), skip this line
+		 firstxvalue=false; // have now got a valid x value
+		 xval_offset= x_offset==0?xval:(float)(xval+x_offset);
+#ifdef USE_CSV_CACHE
+		 if(cache_w!=NULL)
+			csv_cache_set(cache_w,cache_xcol,lines_in_file-1,xval); // does nothing if cache_xcol is -1 (x=linenumber)
 #endif
-						}
-						break;
-				 default: // could be 2,3,4 or 5 value in specified column, potentially divided by a constant
-						st=col_ptrs[xcol-1];
-						while(isspace(*st)) ++st; // skip any leading whitespace
-						if(*st=='"')
-								{++st;// skip " if present
-								 while(isspace(*st)) ++st; // skip any more whitespace
-								}
-						char *end;
-						xval= strtof(st,&end);   // get value for this column
-						// rprintf("Xval: xcol=%d string=%s =%g\n",xcol,st,xval);
-						if(st==end)
-							{allvalidxvals=false;
-							 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE3])
-								{found_error_type[ERR_TYPE3]=true;
-								 rprintf("Warning: x value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-								}
-							 continue;    // no valid number found
-							}
-						// if(xval!=yval) rprintf("**** xval (col %d) %s=>%g\n",xcol,st,xval);
-						if(Xcol_type->ItemIndex==3)
-							xval/=60.0; // sec->min
-						else if(Xcol_type->ItemIndex==4)
-							xval/=3600.0; // sec->hrs
-						else if(Xcol_type->ItemIndex==5)
-							xval/=86400.0; // sec->days
-						break;
-				}
-			}
-		 if(yexpr)
-				{double yval_d;
-                 // first set current values for predefined "variables"
-				 pnlist px=lookup("x");
-				 pnlist pline=lookup("line");
+		 if(any_yexpr)
+				{// set current values for predefined "variables" once for all expressions
 				 if(px!=NULL)
 					px->value=xval;// current x value
-				 px=lookup("X");  // also allow cap X
-                 if(px!=NULL)
-					px->value=xval;// current x value
+				 if(pX!=NULL)
+					pX->value=xval;// current x value
 				 if(pline!=NULL)
 					pline->value=(double)lines_in_file;
-
+				}
+		 // now get y value for every trace and add a point to each trace
+		 for(int t=0;t<nos_traces_added;++t)
+		 {struct add_trace_item *tp=&traces[t];
+		  if(tp->yexpr)
+				{double yval_d;
 				 try
 						{
-						 yval_d=execute_rpn(); // expression - excute it
+						 yval_d=execute_saved_rpn(tp->rpn); // expression - excute it
 						}
 				 catch (...)   // assume the issue is an error in the expression
 						{yval_d=NAN;
 						}
 				 if(isnan(yval_d))
-					{allvalidxvals=false; // line skipped
+					{++tp->nos_errs; // line skipped for this trace
 					 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE4])
 							{found_error_type[ERR_TYPE4]=true;
 							 rprintf("Warning: y value on line %zu expression generates NAN (missing value?)\n",lines_in_file+1);
@@ -2308,8 +3632,8 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 					}
                  yval=(float)yval_d;
 				}
-         else
-                {st=col_ptrs[ycol-1];
+		  else
+                {st=col_ptrs[tp->ycol-1];
                  while(isspace(*st)) ++st; // skip any leading whitespace
                  if(*st=='"')
                         {++st;// skip " if present
@@ -2317,118 +3641,126 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
                         }
 				 // now hope we have a number left - strtof() will terminate at the end of the number so any trailing whitespace or " will be ignored
                  char *end;
-				 yval= strtof(st,&end);   // just a column number - get value for this column
+				 yval= tp->int_col ? fast_strtof_int(st,&end) : strtof(st,&end);   // just a column number - get value for this column
 				 if(st==end)
-					{allvalidxvals=false; // line skipped
+					{++tp->nos_errs; // line skipped for this trace
 					 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE4])
 							{found_error_type[ERR_TYPE4]=true;
-							 rprintf("Warning: y value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[ycol-1]);
+							 rprintf("Warning: y value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[tp->ycol-1]);
 							}
 					 continue;    // no valid number found
 					}
 				 // rprintf("yval (col %d) %s=>%g\n",ycol,st,yval);
+#ifdef USE_CSV_CACHE
+				 if(cache_w!=NULL)
+					csv_cache_set(cache_w,tp->cache_col,lines_in_file-1,yval);
+#endif
 				}
-		 gotyvalue=true;// if we get here we have a valid y value
-		 if(!_finite(xval) || !_finite(yval))
-			{allvalidxvals=false; // line skipped
-			 if(!_finite(xval) && (++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE5]))
-				{found_error_type[ERR_TYPE5]=true;
-				 rprintf("Warning: x value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[xcol-1]);
-				}
-			 if( !_finite(yval) && (++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE6]))
+		  tp->gotyvalue=true;// if we get here we have a valid y value
+		  if(!_finite(yval))
+			{++tp->nos_errs; // line skipped for this trace
+			 if(++nos_errs<=MAX_ERRS || !found_error_type[ERR_TYPE6])
 				{found_error_type[ERR_TYPE6]=true;
-				 rprintf("Warning: y value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[ycol-1]);
+				 rprintf("Warning: y value on line %zu has an invalid number: %s\n",lines_in_file+1,col_ptrs[tp->ycol-1]);
 				}
 			 continue; // need 2 valid numbers [eg ignore "inf" ]
 			}
-		 if(firstxvalue)
-				{firstxvalue=false;
-				 previousxvalue=xval;
-				 last_actual_x_value=xval;
-				 previousyvalue=yval;
-				}
-		   else
-				{
-				 last_actual_x_value=xval;  // remember actual last x value
-				 if((float)xval<(float)previousxvalue)
-						{ // x value is NOT monotonically increasing  (equal values are OK)
-						 xmonotonic=false;
-                         // rprintf("xval(=%.15g)<previousxvalue(=%.15g)\n", xval,previousxvalue);
-						}
-				 else   {// x value is monotonically increasing  (or =)
-
-#if 1   /* this way of compressing only works if x values are monotonically increasing, we only know this correctly on the 2nd trace added onwards when we can trust xmonotonic */
-		/* There is a general solution for compression in function compress_y() but that requires reading all data into an array and then compressing it (and then freeing extra memory) so peak RAM is lower by doing it here if we can */
-						 if(nos_traces_added>1 && xmonotonic && compress && yval==previousyvalue)        // don't bother to store lots of identical values if "compress" is enabled
-								{skipy=true;
-								 previousxvalue=xval;
-								 continue;
-								}
-						 if(skipy) // if have skipped some values put last point in so we see a correct straight line
-								{skipy=false;
-								 pScientificGraph->fnAddDataPoint((float)(previousxvalue+x_offset),previousyvalue,iGraph); // ignore out of ram as that will be trapped below
-								}
-#endif
-						}
-				 previousxvalue=xval;
-				 previousyvalue=yval;
-				}
-		 // rprintf("before addDatapoint: xval=%g x_offset=%g yval=%g iGraph=%d\n",xval,x_offset,yval,iGraph);
-		 if(!pScientificGraph->fnAddDataPoint(x_offset==0?xval:(float)(xval+x_offset),yval,iGraph))
+		  if(!add_point_to_trace(pScientificGraph,tp,xval,xval_offset,yval))
 				{// out of RAM
-				 ShowMessage("Error: not enough memory to load all specified columns");
-				 fclose(fin);
-				 StatusText->Caption="Error: not enough memory to load all specified columns";
-				 if(s) free(s);
-                 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
-				 addtraceactive=false;// finished
-				 pScientificGraph->fnDeleteGraph(iGraph); // delete partial column
-				 if(iGraph==0 || !zoomed)
-						{ // if 1st graph or not already zoomed then autoscale, otherwise leave this to the user.
-						 StatusText->Caption="Autoscaling";
-						 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
-						 pScientificGraph->fnAutoScale();
-						}
-				 StatusText->Caption="Drawing graph";
-				 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
-				 fnReDraw();
-				 StatusText->Caption="Error: not enough memory to load all specified columns";
-				 return;
+				 out_of_ram=true;
+				 break;
 				}
+		 }
+		 if(out_of_ram) break;
 		}
-  if(nos_errs==0)
+  if(nos_read_threads==1 && !csv_is_mapped(fin) && !stop_at_data_end)
+	data_end=csv_tell(fin); // file may have grown while it was being read
+  if(csv_error(fin)!=NULL)
+	rprintf("Warning: %s - only the lines before this error have been read\n",csv_error(fin)); // eg a compressed file that is truncated
+  if(out_of_ram)
+			{
+			 ShowMessage("Error: not enough memory to load all specified columns");
+			 if(fin==stream_fin) stream_fin=NULL; // stream has been read, so cannot be used again
+			 csv_close(fin);
+#ifdef USE_CSV_CACHE
+			 csv_cache_writer_free(cache_w);
+#endif
+			 StatusText->Caption="Error: not enough memory to load all specified columns";
+			 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
+			 ya_strptime_free(date_time_c); date_time_c=NULL;
+			 addtraceactive=false;// finished
+			 for(int t=nos_traces_added-1;t>=0;--t)
+				pScientificGraph->fnDeleteGraph(traces[t].iGraph); // delete partial columns (from the last one backwards)
+			 free_add_trace_items(traces,max_traces);
+			 if(first_graph || !zoomed)
+					{ // if 1st graph or not already zoomed then autoscale, otherwise leave this to the user.
+					 StatusText->Caption="Autoscaling";
+					 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+					 pScientificGraph->fnAutoScale();
+					}
+			 StatusText->Caption="Drawing graph";
+			 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+			 fnReDraw();
+			 StatusText->Caption="Error: not enough memory to load all specified columns";
+			 return;
+			}
+  if(fin==stream_fin) stream_fin=NULL; // stream has been read, so cannot be used again
+  csv_close(fin);
+#ifdef USE_CSV_CACHE
+  if(cache_w!=NULL)
+	{// save values just read in a sidecar file so they can be loaded quickly next time
+	 StatusText->Caption="Writing cache file";
+	 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+	 if(csv_cache_write(cache_w,Utf8_to_w(filename.c_str()),hdr_hash,(uint32_t)skip_initial_lines,lines_in_file,nos_xerrs>0 ? cache_xkey : 0))
+		rprintf("Values read saved in cache file %s.csvgraph-cache\n",filename.c_str());
+	 else
+		rprintf("Note: cannot write cache file %s.csvgraph-cache\n",filename.c_str());
+	 csv_cache_writer_free(cache_w);
+	 cache_w=NULL;
+	}
+#endif
+  for(int t=0;t<nos_traces_added;++t)
+	pScientificGraph->fnShrinkGraph(traces[t].iGraph); // trace arrays grow as points are added, so free any unused space at the end
+  /* now report errors and do any post processing required (sorting, compression, filtering) on each trace just read in */
+  for(int t=0;t<nos_traces_added;++t)
+  {struct add_trace_item *tp=&traces[t];
+  bool xmonotonic=tp->xmonotonic;
+  size_t trace_errs=nos_xerrs+tp->nos_errs; // number of lines skipped for this trace
+  iGraph=tp->iGraph;
+  if(nos_traces_added>1)
+	rprintf("%s: ",tp->cap_str);
+  if(trace_errs==0)
 	rprintf("%zu lines read from csv file (no errors found)\n",lines_in_file);
-  else if(nos_errs==1)
+  else if(trace_errs==1)
 	rprintf("%zu lines read from csv file (1 line skipped dues to errors)\n",lines_in_file);
   else
-	rprintf("%zu lines read from csv file (%zu lines skipped dues to errors - at least one example of each error type is shown above)\n",lines_in_file,nos_errs);
-  if(*ys!=',') fclose(fin);
-  if(!gotyvalue)
-        {// no valid y values found
-		 strncat(cap_str,": Warning: no valid numbers found for y values of column",sizeof(cap_str)-1-strlen(cap_str));
-         ShowMessage(cap_str);
-        }
-  else if(firstxvalue)
+	rprintf("%zu lines read from csv file (%zu lines skipped dues to errors - at least one example of each error type is shown above)\n",lines_in_file,trace_errs);
+  if(firstxvalue)
         {// no valid x values found
-		 strncat(cap_str,": Warning: no valid numbers found for x values of column",sizeof(cap_str)-1-strlen(cap_str));
-		 ShowMessage(cap_str);
+		 strncat(tp->cap_str,": Warning: no valid numbers found for x values of column",sizeof(tp->cap_str)-1-strlen(tp->cap_str));
+		 ShowMessage(tp->cap_str);
 		}
-  else if(nos_errs>0 && showerrmessage)
+  else if(!tp->gotyvalue)
+        {// no valid y values found
+		 strncat(tp->cap_str,": Warning: no valid numbers found for y values of column",sizeof(tp->cap_str)-1-strlen(tp->cap_str));
+         ShowMessage(tp->cap_str);
+        }
+  else if(trace_errs>0 && showerrmessage)
 		{// errors found in file just read in , tell user (just once)
 		 char temp_str[100];
 		 showerrmessage=false;
-		 snprintf(temp_str,sizeof(temp_str),": Warning: %zu errors found while reading file",nos_errs);
-		 strncat(cap_str,temp_str,sizeof(cap_str)-1-strlen(cap_str));
-		 ShowMessage(cap_str);
+		 snprintf(temp_str,sizeof(temp_str),": Warning: %zu errors found while reading file",trace_errs);
+		 strncat(tp->cap_str,temp_str,sizeof(tp->cap_str)-1-strlen(tp->cap_str));
+		 ShowMessage(tp->cap_str);
 		}
 #if 1 /* check x values are monotonic if we think they are  */
   bool found_eq_xvals=false;
   if(xmonotonic)
-	  {float *xptr,*yptr;
+	  {float *xptr;
 	   size_t nos_points;
 	   bool sorted=true;
 	   //   size_t fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF = 0); // allow access to x and y arrays, returns nos points
-	   nos_points=pScientificGraph->fnGetxyarr(&xptr,&yptr,iGraph);
+	   nos_points=pScientificGraph->fnGetxyarr(&xptr,NULL,iGraph); // only x values are needed
 	   for(size_t i=1;i<nos_points;++i)
 			{if(xptr[i]<xptr[i-1])
 				{sorted=false;
@@ -2438,6 +3770,7 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 			  if(xptr[i]==xptr[i-1])
 				 found_eq_xvals=true;
 			}
+	   pScientificGraph->fnFreexarr(xptr,iGraph);
 	   if(!sorted)
 		{// rprintf("Error adding data xmonotic is true but sorted is false!");
 		 xmonotonic=false; // we need to sort them!
@@ -2458,10 +3791,10 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 		 StatusText->Caption="X values sorted";
 		 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
 		 /* now see if there are any equal values */
-		 float *xptr,*yptr;
+		 float *xptr;
 		 size_t nos_points;
 		 //   size_t fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF = 0); // allow access to x and y arrays, returns nos points
-		 nos_points=pScientificGraph->fnGetxyarr(&xptr,&yptr,iGraph);
+		 nos_points=pScientificGraph->fnGetxyarr(&xptr,NULL,iGraph); // only x values are needed
 		 for(size_t i=1;i<nos_points;++i)
 			{
 			  if(xptr[i]==xptr[i-1])
@@ -2469,6 +3802,7 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 				  break;
 				 }
 			}
+		 pScientificGraph->fnFreexarr(xptr,iGraph);
 		}
 #if 0
 	/* warning - if this code is enabled some x values may be removed (with their y values) and some sets of y values that originally appeared on one line of the csvfile may appear on different lines of a saved csv file
@@ -2483,7 +3817,7 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 		}
 #endif
 #if 1    /* general purpose compression - works well but does require all data for the trace is read into ram , then excess is returned so peak ram is high */
-   if(compress && !(nos_traces_added>1 && xmonotonic) ) // && ! bit traps cases that can be done when reading the trace data in (above)
+   if(compress) // all traces are now read in a single pass, so we cannot know x values are monotonic while reading them in - so always compress here
 		{
 		 StatusText->Caption="Compressing...";
 		 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
@@ -2527,12 +3861,13 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 				// exp_constant  provides "scaling" between time constant and lambda, 30 seems to be a reasonable number
 				{
 				 double lambda,m,c,exp_constant=30.0,lpow,e;
-				 float *xptr,*yptr;
+				 float x0,xn; // first and last x values
 				 size_t nos_points;
-				 //   size_t fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF = 0); // allow access to x and y arrays, returns nos points
-				 nos_points=pScientificGraph->fnGetxyarr(&xptr,&yptr,iGraph);
+				 nos_points=pScientificGraph->fnGetNumberOfDataPoints(iGraph);
 				 if(nos_points<2 || median_ahead_t<0) break;
-				 e=exp(-median_ahead_t*exp_constant/(xptr[nos_points-1]-xptr[0]));
+				 x0=pScientificGraph->fnGetXval(0,iGraph);
+				 xn=pScientificGraph->fnGetXval(nos_points-1,iGraph);
+				 e=exp(-median_ahead_t*exp_constant/(xn-x0));
 				 lpow=exp(exp_constant);  // used as part of scaling
 				 if(lpow<=1.0 || !isfinite(lpow) ) m=0; // avoid divide by zero or m going negative
 				 else
@@ -2541,8 +3876,8 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 				 lambda=m*e+c;
 #if 0    /* if 1 then print some info useful for debugging */
 				 rprintf("smoothing spline: median_ahead_t=%g, e=%g,lpow=%g,m=%g,c=%g\n",median_ahead_t, e,lpow,m,c );
-				 rprintf("smoothing spline: t/c=%g x=%g to %g => range is %g lambda=%g\n",median_ahead_t,xptr[0],xptr[nos_points-1],
-						(xptr[nos_points-1]-xptr[0]),lambda);
+				 rprintf("smoothing spline: t/c=%g x=%g to %g => range is %g lambda=%g\n",median_ahead_t,x0,xn,
+						(xn-x0),lambda);
 #endif
 				 StatusText->Caption=FString;
 				 pScientificGraph->Spline_smoothing(lambda,iGraph);
@@ -2766,47 +4101,90 @@ repeatcomma: // sorry for this !!!, come back here to add next trace if we find
 						}
 				break;
 		}
-  if(*ys!=',')
-	{// if this is the final trace then rescale & actually plot, otherwise skip this step to save time
-	 if(iGraph==0 || !zoomed)
-		{ // if 1st graph or not already zoomed then autoscale, otherwise leave this to the user.
-		 StatusText->Caption="Autoscaling";
+  if(pScientificGraph->fnImplicitX(iGraph)) // done last as sorting, compression etc may change the x values
+	rprintf("x values are evenly spaced so are calculated when needed rather than stored\n");
+  } // end of for() - post processing of each trace
+  if(!Followfile1->Checked) // lines added to a file being followed would uncompress the traces again
+	{// if the traces just read use a lot of RAM (or File/Compress traces in RAM is ticked) compress them (see TScientificGraph::fnCompress() ) so more traces can be kept in RAM
+	 MEMORYSTATUSEX memstat;
+	 double trace_bytes=0;
+	 bool always=Compresstraces1->Checked;
+	 for(int t=0;t<nos_traces_added;++t)
+		trace_bytes+=(double)pScientificGraph->fnGraphBytes(traces[t].iGraph);
+	 memstat.dwLength=sizeof(memstat);
+	 if(always || (scratch_dir()==NULL && COMPRESS_TRACES_RAM_FRACTION>0 && GlobalMemoryStatusEx(&memstat) && trace_bytes*COMPRESS_TRACES_RAM_FRACTION>(double)memstat.ullTotalPhys))
+		{double comp_bytes=0;
+		 int nos_comp=0;
+		 StatusText->Caption="Compressing traces in RAM";
 		 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
-		 pScientificGraph->fnAutoScale();
+		 for(int t=0;t<nos_traces_added;++t)
+			{if(pScientificGraph->fnCompress(traces[t].iGraph,always ? compress_max_error : 0)) ++nos_comp;
+			 comp_bytes+=(double)pScientificGraph->fnGraphBytes(traces[t].iGraph);
+			}
+		 if(always)
+			rprintf("Traces just added used %.0f MB of RAM: %d of %d traces compressed (y values changed by at most %g), they now use %.0f MB\n",
+				trace_bytes/(1024.0*1024.0),nos_comp,nos_traces_added,compress_max_error,comp_bytes/(1024.0*1024.0));
+		 else
+			rprintf("Traces just added use %.0f MB of RAM (more than 1/%d of the RAM in this PC): %d of %d traces compressed, they now use %.0f MB\n",
+				trace_bytes/(1024.0*1024.0),COMPRESS_TRACES_RAM_FRACTION,nos_comp,nos_traces_added,comp_bytes/(1024.0*1024.0));
 		}
-	 StatusText->Caption="Drawing graph";
+	}
+  if(scratch_dir()!=NULL)
+	{// File/Keep traces in scratch files is ticked, move values of traces just read (that are not compressed) into scratch files (see TScientificGraph::fnToScratch() )
+	 // big traces were already moved while the file was read. Lines added to a file being followed are added to the scratch files.
+	 int nos_scratch=0;
+	 StatusText->Caption="Moving traces to scratch files";
 	 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
-	 fnReDraw();
+	 for(int t=0;t<nos_traces_added;++t)
+		if(pScientificGraph->fnToScratch(traces[t].iGraph)) ++nos_scratch;
+	 rprintf("%d of %d traces just added are in scratch files in %s\n",nos_scratch,nos_traces_added,AnsiString(scratch_dir()).c_str());
+	}
+  // all traces have now been read, so rescale & actually plot
+  if((first_graph || !zoomed) && !(zoomed && !zoomed_at_start))
+	{ // if 1st graph or not already zoomed then autoscale, otherwise leave this to the user (who may have zoomed while the file was being read).
+	 StatusText->Caption="Autoscaling";
+	 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+	 pScientificGraph->fnAutoScale();
 	}
+  StatusText->Caption="Drawing graph";
+  Application->ProcessMessages(); /* allow windows to update (but not go idle) */
+  fnReDraw();
   end_t=clock();
+  if(sampled)
+	{// remember traces just added so they can be replaced when all of the file is read
+	 sample.filename=filename;
+	 sample.first_graph=traces[0].iGraph;
+	 sample.nos_graphs=nos_traces_added;
+	 sample.line_colour=sample_line_colour;
+	 rprintf("Preview of %s added, untick File/Preview and add the same traces again to read all of the file\n",filename.c_str());
+	}
 
-  if(*ys==',')
-		{// multiple items are comma seperated
-		 ++ys; // skip ,
-		 rewind(fin); // back to start of file
-		 char *text_first_line=NULL;
-		 {int skip_initial_lines=_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str());
-		  for(int l=0;l<=skip_initial_lines;++l)    // need to read 1 line if skip=0, 2 lines for skip=1, etc
-				text_first_line=readline(fin);
-		 }
-		 if(text_first_line==NULL)  // check header line to check file can be read again
-                {
-				 ShowMessage("Error: cannot rewind input file to read next column");
-				 fclose(fin);
-                 StatusText->Caption="Error reading multiple columns";
-				 if(s) free(s);
-				 if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
-                 addtraceactive=false;// finished
-                 return;
-                }
-		 StatusText->Caption="Reading next column...";
-         rprintf("\n");
-         Application->ProcessMessages(); /* allow windows to update (but not go idle) */
-         goto repeatcomma; // go and process next 
+   if(Followfile1->Checked)
+		{// keep what is needed to add lines that are appended to the file to the traces just added
+		 if(FilterType->ItemIndex!=0)
+			rprintf("Note: follow file only works when no filter is selected, so the traces just added will not be updated when the file changes\n");
+		 else if(compressed_file)
+			rprintf("Note: follow file does not work with compressed files, so the traces just added will not be updated when the file changes\n");
+		 else if(stream_file)
+			rprintf("Note: follow file does not work with stdin or pipes, so the traces just added will not be updated\n");
+		 else if(file_set)
+			rprintf("Note: follow file does not work with a set of files, so the traces just added will not be updated when the files change\n");
+		 else if(sampled)
+			rprintf("Note: follow file does not work with a preview, so the traces just added will not be updated when the file changes\n");
+		 else if(follow_start(traces,nos_traces_added,max_traces,Xcol_type->ItemIndex,xcol,max_col,date_time_fmt,date_time_c,x_offset,firstxvalue,first_time,file_has_dates,any_yexpr,lines_in_file,data_end))
+			{traces=NULL; // these are now owned by follow_start()
+			 date_time_fmt=NULL;
+			 date_time_c=NULL;
+			 Timer_follow->Enabled=true;
+			 rprintf("Following file %s - lines added to it will be added to the traces just added\n",filename.c_str());
+			}
 		}
    // free memory potentially used
    if(s) free(s);
    if(date_time_fmt!=NULL) {free(date_time_fmt); date_time_fmt=NULL;}
+   ya_strptime_free(date_time_c); date_time_c=NULL;
+   free_add_trace_items(traces,max_traces);
+   traces=NULL;
 // #define DEBUG_RAM_USED /* when defined use rprintf to give "user" more info */
 #if 1  /* use Windows API to get information about the memory usage of a specified process - see    https://learn.microsoft.com/en-us/windows/win32/api/psapi/nf-psapi-getprocessmemoryinfo */
 	/* This does not exactly match what task manager says, but its a similar number [ and seems to be the best match possible]    */
@@ -3006,14 +4384,45 @@ static void set_ListboxXY(void) // highlight default columns in ListBoxX/Y (if v
 /* use built in windows functions directly to read file, check for \n's by reading array 64bits at a time */
 	/* \n detection from idea in http://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord */
 
+#ifdef ESTIMATE_LINES_MIN_BYTES
+static bool is_network_file(const char *fn) // returns true if file fn (utf-8) is on a network drive (so reading all of it is likely to be slow)
+{wchar_t root[MAX_PATH];
+ const wchar_t *wfn=Utf8_to_w(fn);
+ if(wfn[0]=='\\' && wfn[1]=='\\') return true; // UNC path (\\server\share\...)
+ if(!GetVolumePathNameW(wfn,root,MAX_PATH)) return false;
+ return GetDriveTypeW(root)==DRIVE_REMOTE;
+}
+#endif
+
+static size_t add_line_index(int64_t offset,size_t *max_line_index) // add offset to line_index[] (growing it if required), returns next line to add (SIZE_MAX if out of RAM)
+{if(line_index_size>=*max_line_index)
+	{int64_t *new_index=(int64_t *)realloc(line_index,2*(*max_line_index)*sizeof(int64_t));
+	 if(new_index==NULL)
+		{// out of RAM, keep the index we have as its still valid for the lines it covers
+		 return SIZE_MAX;
+		}
+	 line_index=new_index;
+	 *max_line_index*=2;
+	}
+ line_index[line_index_size++]=offset;
+ return line_index_size*LINE_INDEX_STEP;
+}
+
 static size_t count_lines(char *cfilename, double filesize)
 {   HANDLE hFile;
 	size_t lines=0;
 	char *buf=(char *)malloc(CL_BLOCK_SIZE); // buffer for reads - malloc guarantees sensible alignment for buf;
 	char *cp;
+	char *data; // block of file being counted (buf, or a block from the read ahead thread)
 	DWORD nBytesRead = 0;
-	BOOL bResult   = FALSE;
+	size_t block_len;
+	int fd;
+	FILE *fp;
+	csv_decomp *rd; // reads file in another thread, so reading the disk overlaps counting lines
 	double total_bytes_read=0;
+	int64_t block_start; // offset in file of buf[0]
+	size_t next_index_line=LINE_INDEX_STEP; // next line whose offset is saved in line_index[]
+	size_t max_line_index; // size of line_index[]
 	clock_t begin_t;
 	begin_t=clock();
 	// rprintf("count_lines: Filename=%s filesize=%.0f KB\n",cfilename,filesize/1024.0);
@@ -3021,6 +4430,20 @@ static size_t count_lines(char *cfilename, double filesize)
 		{rprintf(" count_lines() - not enough RAM - sorry!\n");
 		 return 0; // No RAM
 		}
+	// start a new index of line offsets for this file
+	if(line_index!=NULL) free(line_index);
+	max_line_index=1+(size_t)(filesize/(LINE_INDEX_STEP*16.0)); // initial guess (lines average 16 bytes), grown below if required
+	line_index=(int64_t *)malloc(max_line_index*sizeof(int64_t));
+	line_index_filename=cfilename;
+	line_index_filesize=0;
+	if(line_index==NULL)
+		{line_index_size=0;
+		 next_index_line=SIZE_MAX; // no index, but we can still count lines
+		}
+	else
+		{line_index[0]=0; // 1st line starts at the start of the file
+		 line_index_size=1;
+		}
 	/*
 	HANDLE CreateFileA(
 	LPCSTR                lpFileName,
@@ -3059,21 +4482,25 @@ static size_t count_lines(char *cfilename, double filesize)
 		 free(buf);
 		 return 0; // cannot open file
 		}
-	while ( (bResult = ReadFile(hFile, buf, CL_BLOCK_SIZE, &nBytesRead, NULL)))    /* bResult is false only on error */
+	fd=_open_osfhandle((intptr_t)hFile,_O_RDONLY|_O_BINARY); // fd (then fp) takes ownership of hFile
+	fp= fd== -1 ? NULL : _fdopen(fd,"rb");
+	rd= fp==NULL ? NULL : csv_read_ahead_open(fp,CL_BLOCK_SIZE); // CL_BLOCK_SIZE blocks are read by another thread
+	if(rd!=NULL && csv_decomp_error(rd)!=NULL)
+		{csv_decomp_close(rd); // thread could not be started, use ReadFile() instead
+		 rd=NULL;
+		}
+	data=buf; // only changed by csv_decomp_read()
+	while(rd!=NULL ? (block_len=csv_decomp_read(rd,&data))>0 :
+		  (ReadFile(hFile, data, CL_BLOCK_SIZE, &nBytesRead, NULL) && (block_len=nBytesRead)>0)) /* ReadFile() is false only on error, nBytesRead is 0 at eof */
 		{
-		 // Check for eof.
-		 if (bResult &&  nBytesRead == 0)
-			{
-			 // at the end of the file
-			 break;
-			}
-		 total_bytes_read+=nBytesRead; // keep track of bytes read to date
+		 block_start=(int64_t)total_bytes_read;
+		 total_bytes_read+=block_len; // keep track of bytes read to date
 		 uint64_t v64;
 		 uint64_t *pv64;
 	/* # pragma's below work for gcc and clang compilers. This code is done for efficiency, buf is obtained from heap so has suitable alignment */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-align"
-		 for(pv64=(uint64_t *)buf; nBytesRead>=8;nBytesRead-=8)
+		 for(pv64=(uint64_t *)data; block_len>=8;block_len-=8)
 			{// read buffer 8 bytes at a time looking for \n = 0a*/
 #pragma GCC diagnostic pop
 			 v64=*pv64++; // read next 8 characters from buffer
@@ -3081,13 +4508,27 @@ static size_t count_lines(char *cfilename, double filesize)
 			 if ((v64 - UINT64_C(0x0101010101010101)) & (~v64) & UINT64_C(0x8080808080808080))
 				{// at least 1 byte is a \n, count them, there is 1 bit set in data for every \n character in the 8 bytes
                  v64=(v64 - UINT64_C(0x0101010101010101)) & (~v64) & UINT64_C(0x8080808080808080);
+				 uint64_t nl_bits=v64; // keep a copy in case we need to find where the \n's are
+				 size_t prev_lines=lines;
 				 ++lines; // at least 1 \n found
 				 while((v64=(v64&(v64-1)))) ++lines; // (x&(x-1)) removes a single bit set from data, so this counts the remaining \n's
+				 if(lines>=next_index_line)
+					{// the start of a line we want to index is in these 8 bytes, so find which \n it follows (this is rare so speed is not important)
+					 int64_t word_start=block_start+((char *)(pv64-1)-data);
+					 for(int b=0;b<8;++b)
+						if((nl_bits>>(8*b+7)) & 1)
+							{if(++prev_lines==next_index_line)
+								next_index_line=add_line_index(word_start+b+1,&max_line_index);
+							}
+					}
 				}
 			}
 		 cp=(char *)pv64;// might be some bytes left to process, do them here 1 character at a time
-		 while(nBytesRead--)
-			if(*cp++=='\n') ++lines;
+		 while(block_len--)
+			if(*cp++=='\n')
+				{if(++lines==next_index_line)
+					next_index_line=add_line_index(block_start+(cp-data),&max_line_index);
+				}
 		 if( clock()-begin_t > 2*CLK_TCK)
 			{// more than 2 secs difference , give user something to see
              char str_buf[128];
@@ -3097,17 +4538,124 @@ static size_t count_lines(char *cfilename, double filesize)
 			 Application->ProcessMessages(); /* allow windows to update (but not go idle), do this regularly  */
 			}
 		}
-	CloseHandle(hFile);
+	if(rd!=NULL)
+		{if(csv_decomp_error(rd)!=NULL) rprintf("count_lines(%s): %s\n",cfilename,csv_decomp_error(rd));
+		 csv_decomp_close(rd); // must be before fclose() as the thread reads from fp
+		}
+	if(fp!=NULL)
+		fclose(fp); // also closes fd and hFile
+	else if(fd!= -1)
+		_close(fd);
+	else
+		CloseHandle(hFile);
 	free(buf);
+	line_index_filesize=(int64_t)total_bytes_read; // index is valid while the file is at least this big
 	//rprintf("  %.0f lines found\n",(double)lines);
 	return lines;
 }
 
 //---------------------------------------------------------------------------
+static void profile_field(struct col_profile *cp,char *f) // update profile cp with field f
+{char *st=skip_csv_space(f),*end;
+ int type,layout=TIME_LAYOUT_OTHER;
+ float v;
+ if(strchr(f,'"')!=NULL) cp->quoted=true;
+ if(*st==0 || *st=='"') return; // empty field (or "")
+ v=strtof(st,&end);
+ if(end==st)
+	type=COL_TEXT;
+ else
+	{// starts with a number, check nothing other than whitespace or " follows it
+	 char *e=end;
+	 while(isspace(*e) || *e=='"') ++e;
+	 if(*e==0)
+		{type=COL_DECIMAL;
+		 if(*st=='-' || *st=='+') ++st;
+		 while(isdigit(*st)) ++st;
+		 if(st==end) type=COL_INT;
+		 if(cp->nos_numbers++==0 || v<cp->min) cp->min=v;
+		 if(cp->nos_numbers==1 || v>cp->max) cp->max=v;
+		}
+	 else if(strchr(end,':')!=NULL)
+		{type=COL_TIME; // eg 12:34:56 or 2020-03-31 12:34:56 (these are checked in the same way as get_xval() does)
+		 if(isdigit(f[0]) && isdigit(f[1]) && f[2]==':') layout=TIME_LAYOUT_HMS;
+		 else if(is_iso_date(f)) layout=TIME_LAYOUT_ISO;
+		}
+	 else
+		type=COL_TEXT;
+	}
+ if(cp->nos_values++==0)
+	{cp->type=type;
+	 cp->time_layout=layout;
+	 return;
+	}
+ if(type!=cp->type)
+	{if((type==COL_INT || type==COL_DECIMAL) && (cp->type==COL_INT || cp->type==COL_DECIMAL))
+		cp->type=COL_DECIMAL; // mixture of integers and decimals
+	 else
+		cp->type=COL_TEXT;
+	}
+ if(layout!=cp->time_layout) cp->time_layout=TIME_LAYOUT_OTHER; // mixture of layouts
+}
+
+static void profile_line(char *cols[],unsigned int nos_cols) // add fields in cols[] (split by parsecsv() ) to col_profiles[]
+{for(unsigned int c=0;c<nos_cols && c<nos_col_profiles;++c)
+	profile_field(&col_profiles[c],cols[c]);
+}
+
+static size_t profile_columns(csv_reader *fin,char *line2[],int64_t filesize) // sets col_profiles[] from line2[] (the 1st line of data, split by parsecsv() ) and lines sampled from the rest of the file
+// fin is just after the 1st line of data, if the file can be seeked lines are read from PROFILE_BLOCKS evenly spaced blocks and fin is then moved back to the start of the 2nd line of data
+// compressed files and streams cannot be seeked, so the 1st lines are read and the number of lines read is returned (0 is returned for other files)
+{int64_t data_start=csv_tell(fin);
+ size_t lines_read=0;
+ bool compressed=csv_is_compressed(fin) || csv_is_stream(fin);
+ char **cols=(char **)malloc(MAX_COLS*sizeof(char *)); // cannot use col_ptrs as they point to line2[]
+ for(unsigned int c=0;c<nos_col_profiles;++c)
+	{col_profiles[c].type=COL_EMPTY;
+	 col_profiles[c].time_layout=TIME_LAYOUT_OTHER;
+	 col_profiles[c].quoted=false;
+	 col_profiles[c].nos_values=col_profiles[c].nos_numbers=0;
+	 col_profiles[c].min=col_profiles[c].max=0;
+	}
+ profile_line(line2,MAX_COLS);
+ if(cols==NULL) return 0; // out of RAM, just use 1st line
+ for(int block=0;block<PROFILE_BLOCKS;++block)
+	{char *csv_line;
+	 if(block>0)
+		{if(compressed) break; // only 1st block can be read
+		 int64_t offset=data_start+(filesize-data_start)*block/PROFILE_BLOCKS;
+		 if(offset>csv_tell(fin) && !csv_seek_line(fin,offset)) break; // end of file
+		}
+	 for(int l=0;l<PROFILE_BLOCK_LINES && (csv_line=csv_readline(fin))!=NULL;++l)
+		{parsecsv(csv_line,cols,MAX_COLS);
+		 profile_line(cols,MAX_COLS);
+		 ++lines_read;
+		}
+	}
+ free(cols);
+ if(compressed) return lines_read;
+ csv_seek(fin,data_start); // back to where we started
+ return 0;
+}
+
+static void profile_str(char *buf,size_t len,unsigned int col) // puts a short description of the profile of column col (0 is 1st) into buf[len]
+{struct col_profile *cp;
+ *buf=0;
+ if(col>=nos_col_profiles) return;
+ cp=&col_profiles[col];
+ switch(cp->type)
+	{case COL_EMPTY: snprintf(buf,len," [empty]"); break;
+	 case COL_INT: snprintf(buf,len," [%sint %.9g..%.9g]",cp->quoted?"quoted ":"",cp->min,cp->max); break;
+	 case COL_DECIMAL: snprintf(buf,len," [%snum %.4g..%.4g]",cp->quoted?"quoted ":"",cp->min,cp->max); break;
+	 case COL_TIME: snprintf(buf,len," [%stime]",cp->quoted?"quoted ":""); break;
+	 default: snprintf(buf,len," [text]"); break;
+	}
+}
+
 void proces_open_filename(char *fn) // open filename - just to peek at header row  : now also counts the number of lines in the file
 {
 // Form1->pPlotWindow->StatusText->Caption=cstring;
-  FILE *fin;
+  csv_reader *fin;
   char *csv_line=NULL;// line of csv file
   unsigned int nos_cols_in_file;
   unsigned int j;
@@ -3124,6 +4672,11 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 	}
   if(addtraceactive) return; // currently adding traces so cannot change filename
   addtraceactive=true;// use this flag to avoid running simulateneous button presses...
+  follow_stop(); // col_ptrs[] may change size for the new file
+  if(stream_fin!=NULL)
+	{csv_close(stream_fin); // stream from previous file that has not been used
+	 stream_fin=NULL;
+	}
   nos_lines_in_file=0; // we need to count the number of lines in the file
   if(fn==NULL || strcmp(fn,"")==0)
 		{filename="";
@@ -3134,8 +4687,9 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 		}
   filename=fn;
   basename=filename.SubString(filename.LastDelimiter("\\:")+1,128); // window will add scroll bars automaticaly if name is too long
+  if(filename=="-") basename="stdin";
   // fin=fopen(filename.c_str(),"rb");
-  fin=_wfopen(Utf8_to_w(filename.c_str()),L"rb");
+  fin=csv_open(Utf8_to_w(filename.c_str())); // csv_open() decompresses the file if its compressed
   if(fin==NULL)
 		{ShowMessage(String("Error: cannot open file ")+Utf8_to_w(filename.c_str()));
          Form1->pPlotWindow->StatusText->Caption="No filename set";
@@ -3146,11 +4700,15 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
          return;
 		}
 
-  _fseeki64(fin, 0, SEEK_END);  // seek to end of file
-  filesize=_ftelli64(fin); // get size of file
-  _fseeki64(fin,0,SEEK_SET); // back to start of file
+  filesize=csv_filesize(fin); // get size of file
 
   rcls();
+  if(csv_nos_files(fin)>1)
+	{// a set of files read as one file
+	 AnsiString first=Utf8Of((wchar_t *)csv_file_name(fin,0)),last=Utf8Of((wchar_t *)csv_file_name(fin,csv_nos_files(fin)-1));
+	 basename=first.SubString(first.LastDelimiter("\\:/")+1,128)+" (+"+AnsiString(csv_nos_files(fin)-1)+" more files)";
+	 rprintf("%d files will be read as one file: %s ... %s\n",csv_nos_files(fin),first.c_str(),last.c_str());
+	}
   // rprintf("filesize=%llu =(double) %.0f\n",filesize,(double)filesize);
 #if 0
   /* add some debugging info */
@@ -3185,11 +4743,14 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
   rprintf("filename selected is %s\n",filename.c_str());
   {int skip_initial_lines=_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str());
    for(int l=0;l<=skip_initial_lines;++l)    // need to read 1 line if skip=0, 2 lines for skip=1, etc
-	 csv_line=readline(fin);
+	 csv_line=csv_readline(fin);
   }
   if(csv_line==NULL)
-        {ShowMessage("Error: cannot read headers from file "+filename);
-         fclose(fin);
+        {if(csv_error(fin)!=NULL)
+			ShowMessage("Error: cannot read headers from file "+filename+" : "+csv_error(fin));
+		 else
+			ShowMessage("Error: cannot read headers from file "+filename);
+         csv_close(fin);
          filename="";
          Form1->pPlotWindow->StatusText->Caption="No filename set";
 		 Form1->pPlotWindow->StaticText_filename->Text="Not set";
@@ -3200,17 +4761,20 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
   col_names=strdup(csv_line); // copy input line as we want to save column header strings
   if(col_names==NULL)
 		{ShowMessage("Error (no RAM): cannot read headers from file "+filename);
-         fclose(fin);
+         csv_close(fin);
          filename="";
          Form1->pPlotWindow->StatusText->Caption="No filename set";
 		 Form1->pPlotWindow->StaticText_filename->Text="Not set";
 		 addtraceactive=false; // tell other tasks we have finished
          return;
         }
+  {size_t len=strlen(col_names);
+   if(len>0 && col_names[len-1]=='\r') col_names[len-1]=0; // unlike readline(), csv_readline() leaves a \r at the end of the line
+  }
   j=csv_count_cols(col_names); // count how many columns are present in header row
   if(j==0 || (j==1 && strlen(col_names)>300) )   // no columns means empty line, 1 column means no commas so if line is long its suspect
         {ShowMessage("Error: file does not appear to be a csv file\n");
-         fclose(fin);
+         csv_close(fin);
          filename="";
          Form1->pPlotWindow->StatusText->Caption="No filename set";
 		 Form1->pPlotWindow->StaticText_filename->Text="Not set";
@@ -3220,10 +4784,10 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 
 
     // read 2nd line check # columns the same as in the 1st line
-  csv_line=readline(fin);
+  csv_line=csv_readline(fin);
   if(csv_line==NULL)
         {ShowMessage("Error: cannot read 2nd line from file "+filename);
-         fclose(fin);
+         csv_close(fin);
          filename="";
          Form1->pPlotWindow->StatusText->Caption="No filename set";
 		 Form1->pPlotWindow->StaticText_filename->Text="Not set";
@@ -3244,7 +4808,7 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
         }
   if(col_ptrs==NULL || hdr_col_ptrs==NULL)
         {ShowMessage("Error - malloc for col-ptrs failed - out of RAM\n");
-         fclose(fin);
+         csv_close(fin);
 		 Form1->pPlotWindow->StatusText->Caption="No more RAM!";
 		 addtraceactive=false; // tell other tasks we have finished
          return;
@@ -3273,7 +4837,28 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 	}
    nos_cols_in_file=parsecsv((char *)p,hdr_col_ptrs, MAX_COLS);// 1st line = headers
   }
-  parsecsv(csv_line,col_ptrs,MAX_COLS); // 2nd line (real data)
+  char *line2=strdup(csv_line); // copy of 2nd line, as more lines are read below to profile the columns
+  if(line2==NULL)
+		{ShowMessage("Error (no RAM): cannot read 2nd line from file "+filename);
+		 csv_close(fin);
+		 filename="";
+		 Form1->pPlotWindow->StatusText->Caption="No filename set";
+		 Form1->pPlotWindow->StaticText_filename->Text="Not set";
+		 addtraceactive=false; // tell other tasks we have finished
+		 return;
+		}
+  parsecsv(line2,col_ptrs,MAX_COLS); // 2nd line (real data)
+  nos_col_ptrs=MAX_COLS;
+  size_t profile_lines=0; // lines read to profile columns (only for compressed files)
+  if(col_profiles!=NULL) free(col_profiles);
+  col_profiles=(struct col_profile *)malloc(nos_cols_in_file*sizeof(struct col_profile));
+  nos_col_profiles=0;
+  if(col_profiles!=NULL)
+	{nos_col_profiles=nos_cols_in_file;
+	 Form1->pPlotWindow->StatusText->Caption="Sampling columns..." ;
+	 Application->ProcessMessages(); /* allow windows to update (but not go idle), do this regularly  */
+	 profile_lines=profile_columns(fin,col_ptrs,filesize);
+	}
    {// update list boxes with names of columns found, use { so we can declare local variables
 	// add in horizontal scroll bar only if its required
 	int max_str_len_pixels=0,str_len_pixels;
@@ -3306,10 +4891,12 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 						{if(s[1]==0 && *s=='"') *s=0;   // get rid of final "
 						}
 				}
-		 rprintf("Col %-3d : %s  =%s,...\n",j+1,hdr_col_ptrs[j],col_ptrs[j]);// print col number, name of column from header line and value from 2nd line
+		 char prof_buf[64]; // profile of column
+		 profile_str(prof_buf,sizeof(prof_buf),j);
+		 rprintf("Col %-3d : %s  =%s,...%s\n",j+1,hdr_col_ptrs[j],col_ptrs[j],prof_buf);// print col number, name of column from header line, value from 2nd line and profile
 #if 1
 		 /* add text as column number:text from header . This helps if column headers are not very descriptive [or missing] */
-		 snprintf(str_buf,sizeof(str_buf)-1,"%d: %s",j+1,hdr_col_ptrs[j]);
+		 snprintf(str_buf,sizeof(str_buf)-1,"%d: %s%s",j+1,hdr_col_ptrs[j],prof_buf);
 		 if(is_utf8)
 			{label->Caption =Utf8_to_w(str_buf);
 			 Form1->pPlotWindow->ListBoxX->Items->Add(Utf8_to_w(str_buf));
@@ -3349,12 +4936,69 @@ void proces_open_filename(char *fn) // open filename - just to peek at header ro
 		Form1->pPlotWindow->ListBoxY->ScrollWidth=0;
 	delete label;
    }
-  fclose(fin);// only want 1st line here (just display headers so user can select ones to graph
+  bool count_all_lines=true; // if false the number of lines is estimated
+  bool compressed_file=csv_is_compressed(fin);
+  bool file_set=csv_nos_files(fin)>1; // count_lines() only works with a single file, so the number of lines in a set of files is estimated
+#ifdef ESTIMATE_LINES_MIN_BYTES
+  if(!compressed_file && (file_set || (filesize>=ESTIMATE_LINES_MIN_BYTES && is_network_file(filename.c_str()))))
+#else
+  if(!compressed_file && file_set)
+#endif
+	{// reading all of a big file on a network drive just to count the lines is slow, and traces grow as they are read so the number of lines is only needed as an estimate
+	 // estimate number of lines from the length of the 1st few lines of data
+	 int64_t data_start=csv_tell(fin);
+	 size_t sample_lines=0;
+	 while(sample_lines<1000 && csv_readline(fin)!=NULL) ++sample_lines;
+	 int64_t sample_bytes=csv_tell(fin)-data_start;
+	 if(sample_lines>0 && sample_bytes>0)
+		{count_all_lines=false;
+		 nos_lines_in_file=(size_t)((double)(filesize-data_start)*(double)sample_lines/(double)sample_bytes)+1+(size_t)_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str()); // +1 for header line
+		 line_index_filename=""; // no line index for this file
+		}
+	}
+  if(compressed_file)
+	{// counting the lines in a compressed file means decompressing all of it, so estimate the number of lines from the compression ratio of the 1st part of the file
+	 size_t lines_read=(size_t)_wtoi(Form1->pPlotWindow->Edit_skip_lines->Text.c_str())+2+profile_lines; // skipped lines + header + 2nd line + lines read to profile columns
+	 while(lines_read<COMPRESSED_SAMPLE_LINES && csv_readline(fin)!=NULL) ++lines_read;
+	 int64_t sample_bytes=csv_tell(fin); // compressed bytes used for the lines read so far
+	 count_all_lines=false;
+	 if(csv_readline(fin)==NULL)
+		nos_lines_in_file=lines_read; // all of file read
+	 else
+		nos_lines_in_file=(size_t)((double)filesize*(double)(lines_read+1)/(double)(sample_bytes>0 ? sample_bytes : 1));
+	 line_index_filename=""; // no line index for this file
+	}
+  bool stream=csv_is_stream(fin);
+  if(stream)
+	{stream_fin=fin; // cannot be opened again, so keep it open (the lines read so far are kept by fin so they can be read again)
+	 count_all_lines=false;
+	 nos_lines_in_file=0; // unknown, traces grow as lines are read
+	 line_index_filename=""; // no line index for this file
+	}
+  else
+	csv_close(fin);// only want 1st line here (just display headers so user can select ones to graph
+  free(line2);
+  nos_col_ptrs=0; // col_ptrs[] point into the 2nd line, which has now been freed
   set_ListboxXY(); // highlight items in ListBoxX & Y that have been selected in Edit_xcol & Edit_ycol
   Application->ProcessMessages(); /* allow windows to update (but not go idle), do this regularly  */
+  clock_t begin_t=clock();
+  if(stream)
+	{rprintf(" Reading from a stream (stdin or a pipe) so lines are not counted. All the traces wanted must be added at once as a stream can only be read once\n");
+	 Form1->pPlotWindow->StatusText->Caption="Ready : stream (add all traces wanted at once)";
+	 Form1->pPlotWindow->StaticText_filename->Text=Utf8_to_w(basename.c_str());
+	 addtraceactive=false; // tell other tasks we have finished
+	 return;
+	}
+  if(!count_all_lines)
+	{rprintf(" File has about %zu lines (estimated as file is %s)\n",nos_lines_in_file,compressed_file ? "compressed" : file_set ? "a set of files" : "on a network drive");
+	 snprintf(str_buf,sizeof(str_buf),"Ready : about %zu lines in file",nos_lines_in_file);
+	 Form1->pPlotWindow->StatusText->Caption=str_buf;
+	 Form1->pPlotWindow->StaticText_filename->Text=Utf8_to_w(basename.c_str());
+	 addtraceactive=false; // tell other tasks we have finished
+	 return;
+	}
   // now do fast count of lines in file
   Form1->pPlotWindow->StatusText->Caption="Counting lines in file..." ;
-  clock_t begin_t=clock();
   nos_lines_in_file=count_lines(filename.c_str(),filesize);  // this will keep user updated on its progress by updating status line message every 2 secs
   if(nos_lines_in_file==0 )   // no columns means empty line, 1 column means no commas so if line is long its suspect
 		{
@@ -3449,6 +5093,137 @@ void __fastcall TPlotWindow::Edit_xChange(TObject *Sender)
 
 //---------------------------------------------------------------------------
 
+void __fastcall TPlotWindow::Followfile1Click(TObject *Sender)
+{ P_UNUSED(Sender);
+  Followfile1->Checked=!Followfile1->Checked;
+  if(Followfile1->Checked)
+	{StatusText->Caption="Traces added will follow file";
+	}
+  else
+	{if(follow.active)
+		rprintf("Stopped following file %s\n",follow.filename.c_str());
+	 follow_stop();
+	 Timer_follow->Enabled=false;
+	 StatusText->Caption="Follow file off";
+	}
+}
+//---------------------------------------------------------------------------
+
+void __fastcall TPlotWindow::Previewfile1Click(TObject *Sender)
+{ P_UNUSED(Sender);
+  Previewfile1->Checked=!Previewfile1->Checked;
+  if(Previewfile1->Checked)
+	StatusText->Caption="Traces added will be a preview (sample) of big files";
+  else
+	StatusText->Caption="Traces added will read all of the file";
+}
+//---------------------------------------------------------------------------
+
+void __fastcall TPlotWindow::Compresstraces1Click(TObject *Sender)
+{ P_UNUSED(Sender);
+  if(Compresstraces1->Checked)
+	{Compresstraces1->Checked=false;
+	 StatusText->Caption="Traces added will only be compressed if they use a lot of RAM";
+	 return;
+	}
+  String s=FloatToStr(compress_max_error);
+  float max_err;
+  if(!InputQuery("Compress traces in RAM","Max error allowed in y values (0 => y values are kept exactly):",s))
+	return; // cancelled
+  if(!getfloatge0(s.c_str(),&max_err))
+	{ShowMessage("Error: max error must be a number >= 0");
+	 return;
+	}
+  compress_max_error=max_err;
+  Compresstraces1->Checked=true;
+  if(compress_max_error==0)
+	StatusText->Caption="Traces added will be compressed in RAM (y values are kept exactly)";
+  else
+	StatusText->Caption=String("Traces added will be compressed in RAM (y values may change by up to ")+FloatToStr(compress_max_error)+")";
+}
+//---------------------------------------------------------------------------
+
+void __fastcall TPlotWindow::Scratchfiles1Click(TObject *Sender)
+{ P_UNUSED(Sender);
+  if(Scratchfiles1->Checked)
+	{scratch_set_dir(NULL); // traces already in scratch files stay there
+	 Scratchfiles1->Checked=false;
+	 StatusText->Caption="Traces added will be kept in RAM";
+	 return;
+	}
+  static String dir; // remember directory used last time
+  if(dir=="")
+	{wchar_t tmp[MAX_PATH+1];
+	 if(GetTempPathW(MAX_PATH+1,tmp)>0) dir=tmp; // default to the temporary directory
+	}
+  if(!InputQuery("Keep traces in scratch files","Directory for scratch files (ideally on a fast disk with lots of free space):",dir))
+	return; // cancelled
+  if(!scratch_set_dir(dir.c_str()))
+	{ShowMessage(String("Error: ")+dir+" is not a directory");
+	 return;
+	}
+  MEMORYSTATUSEX memstat;
+  memstat.dwLength=sizeof(memstat);
+  if(SCRATCH_RAM_FRACTION>0 && GlobalMemoryStatusEx(&memstat))
+	pScientificGraph->scratch_ram_bytes=(size_t)(memstat.ullTotalPhys/SCRATCH_RAM_FRACTION);
+  Scratchfiles1->Checked=true;
+  StatusText->Caption=String("Traces added will be kept in scratch files in ")+dir;
+}
+//---------------------------------------------------------------------------
+
+void __fastcall TPlotWindow::Timer_followTimer(TObject *Sender)
+{ // called regularly while following a file, adds any lines appended to the file to the traces read from it
+  P_UNUSED(Sender);
+  static char cstring[100]; // small buffer  to use with snprintf
+  if(!follow.active)
+	{Timer_follow->Enabled=false; // no longer following a file
+	 return;
+	}
+  if(addtraceactive || xchange_running!=-1) return; // busy, try again next time
+  int64_t filesize=follow_filesize();
+  if(filesize<0 || filesize==follow.offset) return; // cannot access file at present or nothing added to it
+  if(filesize<follow.offset)
+	{rprintf("File %s is now smaller than when it was read, so it is no longer being followed\n",follow.filename.c_str());
+	 follow_stop();
+	 Timer_follow->Enabled=false;
+	 StatusText->Caption="Stopped following file";
+	 return;
+	}
+  addtraceactive=true; // traces must not be changed by anything else while we add to them
+  bool out_of_ram;
+  double old_xmin=pScientificGraph->fnGetScaleXMin(),old_xmax=pScientificGraph->fnGetScaleXMax();
+  double old_ymin=pScientificGraph->fnGetScaleYMin(),old_ymax=pScientificGraph->fnGetScaleYMax();
+  double xmin=old_xmin,xmax=old_xmax,ymin=old_ymin,ymax=old_ymax;
+  double old_lastx=follow.traces[0].previousxvalue+follow.x_offset; // last x value before new lines are added
+  size_t lines_added=follow_add_lines(pScientificGraph,filesize,&xmin,&xmax,&ymin,&ymax,&out_of_ram);
+  if(lines_added>0)
+	{if(!zoomed && (xmin<old_xmin || xmax>old_xmax || ymin<old_ymin || ymax>old_ymax))
+		{// make sure new points are visible (this only looks at the points just added, fnAutoScale() would look at every point)
+		 double dy=(ymax-ymin)*0.1; // leave space above & below traces as fnAutoScale() does so y scale does not change on every update
+		 if(ymin<old_ymin) ymin-=dy;
+		 if(ymax>old_ymax) ymax+=dy;
+		 pScientificGraph->fnSetScales(xmin,xmax,ymin,ymax);
+		 pScientificGraph->fnOptimizeGrids();
+		}
+	 else if(zoomed && old_lastx<=old_xmax && xmax>old_xmax)
+		{// end of traces was on the screen, so scroll to keep it there
+		 pScientificGraph->fnSetScales(xmax-(old_xmax-old_xmin),xmax,old_ymin,old_ymax);
+		 pScientificGraph->fnOptimizeGrids();
+		}
+	 fnReDraw();
+	 snprintf(cstring,sizeof(cstring),"Following file: %zu lines read (%zu new)",follow.lines_in_file,lines_added);
+	 StatusText->Caption=cstring;
+	}
+  if(out_of_ram)
+	{ShowMessage("Error: not enough memory to add new lines in file being followed - no longer following file");
+	 follow_stop();
+	 Timer_follow->Enabled=false;
+	 StatusText->Caption="Stopped following file (not enough memory)";
+	}
+  addtraceactive=false;
+}
+//---------------------------------------------------------------------------
+
 
 
 
@@ -3481,6 +5256,10 @@ void __fastcall TPlotWindow::Edit_XoffsetChange(TObject *Sender)
 #endif
       bool changed;
 	  changed=pScientificGraph->fnChangeXoffset( new_Xoffset-last_Xoffset); // change ofset if possible
+      if(changed && follow.active)
+		{follow_stop(); // x values of the most recent trace have changed so new lines cannot be added to it correctly
+		 rprintf("X offset changed, so no longer following file %s\n",follow.filename.c_str());
+		}
       if(changed)
         {
 #if 0      /* its normally better not to rescale as user may have zoomed in on a feature to see the impact of changing the offset */
@@ -128,6 +128,11 @@ __published:	// IDE-managed Components
 	TLabel *Label17;
 	TLabel *Label18;
 	TCheckBox *CheckBox_legend;
+	TMenuItem *Followfile1;
+	TTimer *Timer_follow;
+	TMenuItem *Previewfile1;
+	TMenuItem *Compresstraces1;
+	TMenuItem *Scratchfiles1;
         void __fastcall FormDestroy(TObject *Sender);
         void __fastcall FormClose(TObject *Sender, TCloseAction &Action);
         void __fastcall ResizeExecute(TObject *Sender);
@@ -180,6 +185,11 @@ __published:	// IDE-managed Components
 	void __fastcall FormGetSiteInfo(TObject *Sender, TControl *DockClient, TRect &InfluenceRect,
           TPoint &MousePos, bool &CanDock);
 	void __fastcall FormBeforeMonitorDpiChanged(TObject *Sender, int OldDPI, int NewDPI);
+	void __fastcall Followfile1Click(TObject *Sender);
+	void __fastcall Timer_followTimer(TObject *Sender);
+	void __fastcall Previewfile1Click(TObject *Sender);
+	void __fastcall Compresstraces1Click(TObject *Sender);
+	void __fastcall Scratchfiles1Click(TObject *Sender);
 
 
 
@@ -5,6 +5,11 @@
 //  Loosely based on an original public domain version by  Frank heinrich, mail@frank-heinrich.de
 // Major tidy up 1/9/2019 to remove unused functionality
 // 6/2/2021 for 2v0 major change to use float *x_vals,*y_vals rather than SDataPoints in a TLIST.
+// traces can share their x values (eg all traces read from the same csv file) - a trace gets its own copy if its x values are changed.
+// evenly spaced x values (eg line numbers) need not be stored at all, they are calculated from the index when needed (see fnImplicitX() ).
+// values can be compressed in RAM (see fnCompress() ), fnXval() and fnYval() read values whether they are compressed or not.
+// values can be held in memory mapped scratch files rather than in RAM (see fnToScratch() ), functions that change values call fnGraphData() which copies them back into RAM.
+// points can still be added to values in scratch files, and big traces are moved to scratch files as points are added (see fnGrowGraph() ).
 //
 /*----------------------------------------------------------------------------
  * Copyright (c) 2019,2022,2025 Peter Miller
@@ -176,6 +181,8 @@ TScientificGraph::TScientificGraph(int iBitmapWidthK, int iBitmapHeightK)
   iNumberOfGraphs = 0;                               //no graphs
 
   pHistory = new TList();                            //Graphs
+  uScratchClock=0;
+  scratch_ram_bytes=(size_t)-1;                      // by default leave it to the operating system to decide which values in scratch files are kept in RAM
   pBitmap = new Graphics::TBitmap;                   //bitmap
   pBitmap->Width = iBitmapWidth;
   pBitmap->Height = iBitmapHeight;
@@ -800,40 +807,21 @@ void TScientificGraph::fnPaint()
       xd=sScaleX.dMin-xi; // -xi as add xi before its used
 	  iCount=pAGraph->nos_vals ;
 #if 1
-      // do binary search to find start of area thats visible on the screen
-	  ssize_t starti;    // index just before start
-      {
-	   ssize_t low=0;
-	   ssize_t high=(ssize_t)iCount-1;
-       bool found=false;
-       double key=sScaleX.dMin;  // needs to be double as otherwise compare midval<key can generate an overflow if dMin -? dMax is a very large range
-	   ssize_t mid=0;
-       while(low<=high && !found)
-        {mid=low+((high-low)>>1); /* (low+high)/2 but written so cannot overflow */
-		 double midVal=pAGraph->x_vals[mid];
-		 if(midVal<key)
-				low=mid+1;
-		 else if (midVal>key)
-				high=mid-1;
-		 else
-				found=true; // mid is exact match
-		}
-	   if(found) starti=mid;
-	   else starti=low-1;   // not found want 1 before
-	   if(starti<0) starti=0; // ensure not before start (don't worry if its past the end as for loop below deals with that case)
-	  }
+      // find start of area thats visible on the screen (binary search, or calculated directly if x values are implicit)
+	  ssize_t starti=(ssize_t)fnFindX(pAGraph,sScaleX.dMin);    // index just before start
+	  if(pAGraph->pScratch!=NULL) fnScratchUse(pAGraph,(size_t)starti,fnFindX(pAGraph,sScaleX.dMax)+2); // start reading the visible values from the scratch files
 	  for (size_t ii=(size_t)starti; ii<iCount; ii++)  // was i+=step
 #else
 	  for (size_t ii=0; ii<iCount; ii++)  // was i+=step
 #endif
 	  {
-	   dX = pAGraph->x_vals[ii];
+	   dX = fnXval(pAGraph,ii);
 	   if(!fnInScaleX(dX))
 				{if(dX> sScaleX.dMax) break; // past end so all done for this trace
                  else continue; // PMi optimisation - skip values before xmin
                                 // this is important when zooming in as otherwise code below will see the whole file and will "compress" the graph incorrectly
                 }
-	   ymax=ymin=pAGraph->y_vals[ii];// dY
+	   ymax=ymin=fnYval(pAGraph,ii);// dY
 	   x_ymax=x_ymin=(float)dX;
 	   if(zoom_fun_level)
 		  {Application->ProcessMessages(); /* allow windows to update (but not go idle) - potentially causes recursion ! */
@@ -842,11 +830,22 @@ void TScientificGraph::fnPaint()
 		  }
 		// we know scaling so we can calculate how many points we need to skip
 	   xd+=xi; // this works better when "skip equal y values is set" as x values are not then evenly spaced and this way points selected are evenly spaced
-	   dX = pAGraph->x_vals[ii]; // dX,dY is 1st point examined, lastx,lasty is last point in this "segment"
-	   dY = pAGraph->y_vals[ii];
-	   for(istep=1;ii+istep<iCount && pAGraph->x_vals[ii+istep]<xd ;++istep)
-		{lastx = pAGraph->x_vals[ii+istep];
-		 lasty = pAGraph->y_vals[ii+istep];
+	   dX = fnXval(pAGraph,ii); // dX,dY is 1st point examined, lastx,lasty is last point in this "segment"
+	   dY = fnYval(pAGraph,ii);
+	   for(istep=1;ii+istep<iCount && fnXval(pAGraph,ii+istep)<xd ;++istep)
+		{const fc_block *pBlock;
+		 size_t nb=fnYBlockBefore(pAGraph,ii+istep,xd,&pBlock);
+		 if(nb>0)
+			{// a whole block of compressed y values is in this pixel column, so use its header rather than decoding it
+			 lastx = fnXval(pAGraph,ii+istep+nb-1);
+			 lasty = pBlock->last;
+			 if(pBlock->max>ymax) {ymax=pBlock->max;x_ymax=fnXval(pAGraph,ii+istep+pBlock->max_i);}
+			 if(pBlock->min<ymin) {ymin=pBlock->min;x_ymin=fnXval(pAGraph,ii+istep+pBlock->min_i);}
+			 istep+=(unsigned int)nb-1;
+			 continue;
+			}
+		 lastx = fnXval(pAGraph,ii+istep);
+		 lasty = fnYval(pAGraph,ii+istep);
          if(lasty>ymax) {ymax=lasty;x_ymax=lastx;}
          if(lasty<ymin) {ymin=lasty;x_ymin=lastx;}
         }
@@ -913,8 +912,8 @@ void TScientificGraph::fnPaint()
       //iCount=pAList->Count;
       if (iCount!=0)
 	  {
-		dX = pAGraph->x_vals[0];
-		dY = pAGraph->y_vals[0];
+		dX = fnXval(pAGraph,0);
+		dY = fnYval(pAGraph,0);
         fnKoord2Point(pPoint,dX,dY);
         pBitmap->Canvas->PenPos=*pPoint;
         *pPoint2=*pPoint;
@@ -924,34 +923,15 @@ void TScientificGraph::fnPaint()
       double xi=xd/x_width_pixels; // use all the pixels available
       xd=sScaleX.dMin-xi; // -xi as add xi before its used
 #if 1
-      // do binary search to find start of area thats visible on the screen
-	  ssize_t starti;    // index just before start
-      {
-	   ssize_t low=0;
-	   ssize_t high=(ssize_t)iCount-1;
-       bool found=false;
-       double key=sScaleX.dMin;   // without this being a double we get floating point overflow on midVal<key below when dMin->dMax is very large
-	   ssize_t mid=0;
-       while(low<=high && !found)
-		{mid=low+((high-low)>>1); /* (low+high)/2 but written so cannot overflow */
-		 double midVal=pAGraph->x_vals[mid];
-         if(midVal<key)
-                low=mid+1;
-         else if (midVal>key)
-                high=mid-1;
-         else
-                found=true; // mid is exact match
-        }
-	   if(found) starti=mid;
-       else starti=low-1;   // not found want 1 before
-       if(starti<0) starti=0; // ensure not before start (don't worry if its past the end as for loop below deals with that case)
-      }
+      // find start of area thats visible on the screen (binary search, or calculated directly if x values are implicit)
+	  ssize_t starti=(ssize_t)fnFindX(pAGraph,sScaleX.dMin);    // index just before start
+	  if(pAGraph->pScratch!=NULL) fnScratchUse(pAGraph,(size_t)starti,fnFindX(pAGraph,sScaleX.dMax)+2); // start reading the visible values from the scratch files
 	  for (size_t ii=(size_t)starti; ii<iCount; ii++)  // start processing just where we need to.
 #else
 	  for (size_t ii=0; ii<iCount; ii++)  // linear search from start
 #endif      
       {
-	   dX = pAGraph->x_vals[ii];
+	   dX = fnXval(pAGraph,ii);
 	   if(first && dX >sScaleX.dMin)
         { // 1st point after min x value - want to process this
         }
@@ -967,17 +947,17 @@ void TScientificGraph::fnPaint()
        if(first)
         {// first point to be displayed - need to define start of the 1st line
          if(ii>0)
-				{xs= pAGraph->x_vals[ii-1];
-				 ys =pAGraph->y_vals[ii-1];
+				{xs= fnXval(pAGraph,ii-1);
+				 ys =fnYval(pAGraph,ii-1);
                 }
 		 else
-				{xs= pAGraph->x_vals[0];
-				 ys = pAGraph->y_vals[0] ;
+				{xs= fnXval(pAGraph,0);
+				 ys = fnYval(pAGraph,0) ;
                 }
         }
 
-	   dX = pAGraph->x_vals[ii];
-	   dY = pAGraph->y_vals[ii] ;
+	   dX = fnXval(pAGraph,ii);
+	   dY = fnYval(pAGraph,ii) ;
 	   ymax=ymin=(float)dY;
 	   x_ymin=x_ymax=(float)dX;
        if(zoom_fun_level)
@@ -989,9 +969,20 @@ void TScientificGraph::fnPaint()
        xd+=xi; // this works better when "skip equal y values is set" as x values are not then evenly spaced and this way points selected are evenly spaced
 	   lastx=(float)dX ; // dX,dY is 1st point examined, lastx,lasty is last point in this "segment"
 	   lasty=(float)dY ;
-	   for(istep=1;ii+istep<iCount && pAGraph->x_vals[ii+istep]<xd ;++istep)
-		{lastx = pAGraph->x_vals[ii+istep];
-		 lasty = pAGraph->y_vals[ii+istep];
+	   for(istep=1;ii+istep<iCount && fnXval(pAGraph,ii+istep)<xd ;++istep)
+		{const fc_block *pBlock;
+		 size_t nb=fnYBlockBefore(pAGraph,ii+istep,xd,&pBlock);
+		 if(nb>0)
+			{// a whole block of compressed y values is in this pixel column, so use its header rather than decoding it
+			 lastx = fnXval(pAGraph,ii+istep+nb-1);
+			 lasty = pBlock->last;
+			 if(pBlock->max>ymax) {ymax=pBlock->max;x_ymax=fnXval(pAGraph,ii+istep+pBlock->max_i);}
+			 if(pBlock->min<ymin) {ymin=pBlock->min;x_ymin=fnXval(pAGraph,ii+istep+pBlock->min_i);}
+			 istep+=(unsigned int)nb-1;
+			 continue;
+			}
+		 lastx = fnXval(pAGraph,ii+istep);
+		 lasty = fnYval(pAGraph,ii+istep);
 		 if(lasty>ymax) {ymax=lasty;x_ymax=lastx;}
          if(lasty<ymin) {ymin=lasty;x_ymin=lastx;}
         }
@@ -1200,14 +1191,549 @@ fnpaint_end:  // tidy up then return if we get here via a goto.
 
 //------------------------------------------------------------------------------
 
+bool TScientificGraph::fnGrowGraph(SGraph *pAGraph) // make x_vals and y_vals arrays bigger, returns false if out of RAM (arrays are unchanged in that case)
+{ // arrays grow by 50% each time (min GRAPH_MIN_GROW points) so the number of lines in the file does not need to be known in advance, fnShrinkGraph() frees any unused space at the end.
+  size_t new_size=pAGraph->size_vals_arrays+pAGraph->size_vals_arrays/2;
+  if(new_size<pAGraph->size_vals_arrays+GRAPH_MIN_GROW) new_size=pAGraph->size_vals_arrays+GRAPH_MIN_GROW;
+  if(pAGraph->pScratch==NULL && pAGraph->nos_vals>=SCRATCH_MIN_POINTS && scratch_dir()!=NULL)
+	fnMoveToScratch(pAGraph); // File/Keep traces in scratch files is ticked, so rather than making a big trace even bigger in RAM move it to scratch files (if this fails values just stay in RAM)
+  if(pAGraph->pSharedX==NULL && pAGraph->x_vals!=NULL && !fnResizeArray(pAGraph,true,new_size))
+	return false; // x values belong to this graph (shared x values grow in fnGrowSharedX(), implicit x values have no array)
+  if(!fnResizeArray(pAGraph,false,new_size)) return false; // x_vals is now bigger than it needs to be, but thats OK
+  pAGraph->size_vals_arrays=new_size;
+  return true;
+}
+
+bool TScientificGraph::fnResizeArray(SGraph *pAGraph,bool x,size_t n) // change size of x (x=true) or y values array of graph to n values, in RAM or in its scratch file. Returns false if out of RAM or disk space (array is unchanged in that case)
+{ scratch_file *s= pAGraph->pScratch==NULL ? NULL : x ? pAGraph->pScratch->x : pAGraph->pScratch->y;
+  float **pv= x ? &pAGraph->x_vals : &pAGraph->y_vals;
+  if(s!=NULL)
+	{bool ok=scratch_resize(s,n);
+	 *pv=scratch_values(s); // file may now be mapped at a different address
+	 return ok;
+	}
+  float *v=(float *)realloc(*pv,n*sizeof(float));
+  if(v==NULL) return false;
+  *pv=v;
+  return true;
+}
+
+bool TScientificGraph::fnGrowSharedX(SSharedX *pShared) // make shared x values array bigger, returns false if out of RAM (array is unchanged in that case)
+{ size_t new_size=pShared->size_x_vals+pShared->size_x_vals/2; // grows in the same way as fnGrowGraph()
+  if(new_size<pShared->size_x_vals+GRAPH_MIN_GROW) new_size=pShared->size_x_vals+GRAPH_MIN_GROW;
+  float *new_x=(float *)realloc(pShared->x_vals,new_size*sizeof(float));
+  if(new_x==NULL) return false;
+  pShared->x_vals=new_x;
+  pShared->size_x_vals=new_size;
+  fnMovedSharedX(pShared);
+  return true;
+}
+
+void TScientificGraph::fnMovedSharedX(SSharedX *pShared) // update x_vals of all graphs using pShared after its array has been reallocated
+{ for(int i=0;i<iNumberOfGraphs;++i)
+	{SGraph *pAGraph = ((SGraph*) pHistory->Items[i]);
+	 if(pAGraph->pSharedX==pShared) pAGraph->x_vals=pShared->x_vals;
+	}
+}
+
+bool TScientificGraph::fnPrivateX(SGraph *pAGraph) // give graph its own copy of its x values (if they are shared) so they can be changed, returns false if out of RAM (x values are still shared in that case)
+{ SSharedX *pShared=pAGraph->pSharedX;
+  float *new_x;
+  if(pAGraph->x_vals==NULL) return fnXarray(pAGraph)!=NULL; // implicit x values, create an array just for this graph
+  if(pShared==NULL) return true; // x values already belong to just this graph
+  if(pShared->refs==1)
+	{// no other graph uses these x values, so just take them over (making the array the same size as y_vals)
+	 new_x=(float *)realloc(pShared->x_vals,pAGraph->size_vals_arrays*sizeof(float));
+	 if(new_x==NULL) return false;
+	 delete pShared;
+	}
+  else
+	{new_x=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float));
+	 if(new_x==NULL) return false;
+	 memcpy(new_x,pShared->x_vals,pAGraph->nos_vals*sizeof(float)); // other graphs may have more x values, we only need the ones used by this graph
+	 pShared->refs--;
+	}
+  pAGraph->x_vals=new_x;
+  pAGraph->pSharedX=NULL;
+  return true;
+}
+
+void TScientificGraph::fnReleaseX(SGraph *pAGraph) // free x values of graph (or its reference to shared x values)
+{ if(pAGraph->pSharedX!=NULL)
+	{// x values are shared, only delete them when the last graph using them releases them
+	 if(--pAGraph->pSharedX->refs==0)
+		{free(pAGraph->pSharedX->x_vals);
+		 delete pAGraph->pSharedX;
+		}
+	 pAGraph->pSharedX=NULL;
+	}
+  else if(pAGraph->x_vals !=NULL) free(pAGraph->x_vals);
+  pAGraph->x_vals=NULL;
+}
+
+float *TScientificGraph::fnXarray(SGraph *pAGraph) // returns x_vals, creating it first if x values are implicit (as some functions need an array). Returns NULL if out of RAM
+{ if(pAGraph->x_vals!=NULL) return pAGraph->x_vals;
+  float *x=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float));
+  if(x==NULL)
+	{rprintf("Not enough ram to create array of x values\n");
+	 return NULL;
+	}
+  for(size_t i=0;i<pAGraph->nos_vals;++i)
+	x[i]=(float)(pAGraph->x_start+(double)i*pAGraph->x_step); // same as fnXval()
+  pAGraph->x_vals=x;
+  return x;
+}
+
+float *TScientificGraph::fnXcopy(SGraph *pAGraph) // returns x values for functions that only read them: x_vals if the graph has an array, otherwise a temporary copy (so implicit x values stay implicit). Free with fnFreeXcopy(), returns NULL if out of RAM
+{ if(pAGraph->x_vals!=NULL) return pAGraph->x_vals;
+  float *x=(float *)malloc((pAGraph->nos_vals>0 ? pAGraph->nos_vals : 1)*sizeof(float));
+  if(x==NULL)
+	{rprintf("Not enough ram to create array of x values\n");
+	 return NULL;
+	}
+  for(size_t i=0;i<pAGraph->nos_vals;++i)
+	x[i]=fnXval(pAGraph,i);
+  return x;
+}
+
+void TScientificGraph::fnFreeXcopy(SGraph *pAGraph,float *x) // free array returned by fnXcopy() (if it was a temporary copy)
+{ if(x!=NULL && x!=pAGraph->x_vals) free(x);
+}
+
+bool TScientificGraph::fnImplicitX(int iGraphNumberF) // if x values are exactly evenly spaced (eg line numbers, or a fixed sample rate) stop storing them, returns true if x values are now implicit
+{ if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return false; // invalid graph number
+  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  if(pAGraph->pComp!=NULL && !fnUncompress(pAGraph)) return false; // not enough RAM to uncompress values (x values in a scratch file are checked where they are)
+  float *x=pAGraph->x_vals;
+  size_t n=pAGraph->nos_vals;
+  if(x==NULL) return true; // already implicit
+  if(n<2) return false; // need at least 2 points to define the step
+  double x_start=x[0];
+  double x_step=((double)x[n-1]-x_start)/(double)(n-1);
+  if(!(x_step>0)) return false; // x values must increase (this also rejects NaN's)
+  for(size_t i=1;i<n;++i)
+	if((float)(x_start+(double)i*x_step)!=x[i]) return false; // calculated x values must be exactly the same as those stored
+  if(pAGraph->pScratch!=NULL && pAGraph->pScratch->x!=NULL)
+	{pAGraph->x_vals=NULL;
+	 fnDropScratch(pAGraph,true);
+	}
+  else
+	fnReleaseX(pAGraph);
+  pAGraph->x_start=x_start;
+  pAGraph->x_step=x_step;
+  return true;
+}
+
+float TScientificGraph::fnInterpY(SGraph *pAGraph,float x,bool clip) // y value at x, interpolated if required (as interp1D_f() )
+{ if(pAGraph->x_vals!=NULL && pAGraph->y_vals!=NULL) return interp1D_f(pAGraph->x_vals,pAGraph->y_vals,pAGraph->nos_vals,x,clip);
+  // implicit x values (so we can calculate where x is rather than having to search for it) or compressed values
+  size_t n=pAGraph->nos_vals;
+  if(n<2) return n==1 ? fnYval(pAGraph,0) : 0;
+  size_t lo=fnFindX(pAGraph,x);
+  if(lo>n-2) lo=n-2;
+  float xl=fnXval(pAGraph,lo),xh=fnXval(pAGraph,lo+1);
+  float yl=fnYval(pAGraph,lo),yh=fnYval(pAGraph,lo+1);
+  if(x==xl) return yl; // exact matches
+  if(x==xh) return yh;
+  if(clip && x<xl) return fnYval(pAGraph,0); // before 1st value
+  if(clip && x>xh) return fnYval(pAGraph,n-1); // after last value
+  return yl+(yh-yl)*(x-xl)/(xh-xl); /* linear interpolation */
+}
+
+size_t TScientificGraph::fnFindX(SGraph *pAGraph,double key) // returns index of point just before key (or at key if its an exact match), 0 if key is before the 1st point and nos_vals-1 if its after the last one
+{ // key needs to be double as otherwise compare midval<key can generate an overflow if key is very large
+  ssize_t iCount=(ssize_t)pAGraph->nos_vals;
+  if(iCount==0) return 0;
+  if(pAGraph->x_vals==NULL && (pAGraph->pComp==NULL || pAGraph->pComp->x==NULL))
+	{// implicit x values, so index can be calculated directly
+	 double d=floor((key-pAGraph->x_start)/pAGraph->x_step);
+	 ssize_t i;
+	 if(!(d>=0)) return 0; // also catches NaN
+	 if(d>=(double)(iCount-1)) i=iCount-1;
+	 else i=(ssize_t)d;
+	 // rounding of x values to floats means we could be out by 1, so fix that up here
+	 while(i>0 && fnXval(pAGraph,i)>key) --i;
+	 while(i<iCount-1 && fnXval(pAGraph,i+1)<=key) ++i;
+	 return (size_t)i;
+	}
+  // do binary search
+  ssize_t low=0;
+  ssize_t high=iCount-1;
+  bool found=false;
+  ssize_t mid=0;
+  while(low<=high && !found)
+	{mid=low+((high-low)>>1); /* (low+high)/2 but written so cannot overflow */
+	 double midVal=fnXval(pAGraph,mid);
+	 if(midVal<key)
+			low=mid+1;
+	 else if (midVal>key)
+			high=mid-1;
+	 else
+			found=true; // mid is exact match
+	}
+  ssize_t starti;
+  if(found) starti=mid;
+  else starti=low-1;   // not found want 1 before
+  if(starti<0) starti=0; // ensure not before start
+  return (size_t)starti;
+}
+
+void TScientificGraph::fnShrinkGraph(int iGraphNumberF) // free any unused space at the end of the arrays for this graph (use when all points have been added)
+{ if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return; // invalid graph number
+  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  if(pAGraph->pComp!=NULL && !fnUncompress(pAGraph)) return; // not enough RAM to uncompress values (values in scratch files are resized where they are)
+  SSharedX *pShared=pAGraph->pSharedX;
+  if(pShared!=NULL && pShared->nos_vals>0 && pShared->nos_vals<pShared->size_x_vals)
+	{// shared x values only need to hold as many values as the graph using the most of them
+	 float *new_x=(float *)realloc(pShared->x_vals,pShared->nos_vals*sizeof(float));
+	 if(new_x!=NULL)
+		{pShared->x_vals=new_x;
+		 pShared->size_x_vals=pShared->nos_vals;
+		 fnMovedSharedX(pShared);
+		}
+	}
+  size_t n=pAGraph->nos_vals;
+  if(n==0 || n>=pAGraph->size_vals_arrays) return; // realloc(p,0) might free arrays, so always leave at least 1 point
+  // realloc() to a smaller size should never fail, but just in case keep the original arrays if it does
+  bool x_ok= pShared!=NULL || pAGraph->x_vals==NULL || fnResizeArray(pAGraph,true,n);
+  if(fnResizeArray(pAGraph,false,n) && x_ok) pAGraph->size_vals_arrays=n;
+}
+
+bool TScientificGraph::fnCompress(int iGraphNumberF,float y_max_err) // compress x and y values of graph to save RAM (see float-compress.c), returns true if graph is now compressed
+{ // values are compressed in blocks so they can still be read one at a time (via fnXval() and fnYval() ), and fnPaint() can use the block headers to skip blocks
+  // functions that need arrays of values (eg filters) uncompress the graph first via fnGraphData().
+  // x values are only compressed if they belong to just this graph (shared x values are only stored once anyway, and implicit x values are not stored at all)
+  // values in scratch files (eg moved there while a file was read) are read from there, the scratch files are closed for the values that are kept compressed.
+  // x and y values are each only kept compressed if this saves at least 25% of the RAM they use.
+  // if y_max_err>0 y values may be stored as 16 bit values (with a scale and offset for each block) and then read back with an error of up to y_max_err, x values are always kept exactly.
+  if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return false; // invalid graph number
+  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  size_t n=pAGraph->nos_vals;
+  if(pAGraph->pComp!=NULL) return true; // already compressed
+  if(n<FC_BLOCK_SIZE) return false; // not worthwhile for small graphs
+  size_t raw_bytes=n*sizeof(float);
+  size_t block_bytes=FC_BLOCK_SIZE*sizeof(float); // compressed values also need a buffer to decode a block into
+  SCompressed *pComp=new SCompressed;
+  pComp->x=pComp->y=NULL;
+  pComp->x_block=pComp->y_block=NULL;
+  pComp->x_blockn=pComp->y_blockn=(size_t)-1;
+  pComp->y=fc_compress(pAGraph->y_vals,n,y_max_err);
+  if(pComp->y!=NULL && (fc_bytes(pComp->y)+block_bytes>raw_bytes*3/4 || (pComp->y_block=(float *)malloc(FC_BLOCK_SIZE*sizeof(float)))==NULL))
+	{fc_free(pComp->y); // not worthwhile (or out of RAM)
+	 pComp->y=NULL;
+	}
+  if(pAGraph->x_vals!=NULL && pAGraph->pSharedX==NULL)
+	{pComp->x=fc_compress(pAGraph->x_vals,n,0);
+	 if(pComp->x!=NULL && (fc_bytes(pComp->x)+block_bytes>raw_bytes*3/4 || (pComp->x_block=(float *)malloc(FC_BLOCK_SIZE*sizeof(float)))==NULL))
+		{fc_free(pComp->x);
+		 pComp->x=NULL;
+		}
+	}
+  if(pComp->x==NULL && pComp->y==NULL)
+	{free(pComp->x_block);
+	 free(pComp->y_block);
+	 delete pComp;
+	 return false;
+	}
+  if(pComp->x!=NULL)
+	{if(pAGraph->pScratch!=NULL && pAGraph->pScratch->x!=NULL) fnDropScratch(pAGraph,true);
+	 else free(pAGraph->x_vals);
+	 pAGraph->x_vals=NULL;
+	}
+  if(pComp->y!=NULL)
+	{if(pAGraph->pScratch!=NULL && pAGraph->pScratch->y!=NULL) fnDropScratch(pAGraph,false);
+	 else free(pAGraph->y_vals);
+	 pAGraph->y_vals=NULL;
+	}
+  pAGraph->pComp=pComp;
+  return true;
+}
+
+bool TScientificGraph::fnUncompress(SGraph *pAGraph) // expand compressed values back into x_vals/y_vals, returns false if out of RAM (values are still compressed in that case)
+{ SCompressed *pComp=pAGraph->pComp;
+  float *x=NULL,*y=NULL;
+  if(pComp==NULL) return true; // not compressed
+  size_t n=pAGraph->nos_vals; // only graphs with values are compressed
+  if((pComp->x!=NULL && (x=(float *)malloc(n*sizeof(float)))==NULL) ||
+	 (pComp->y!=NULL && (y=(float *)malloc(n*sizeof(float)))==NULL))
+	{free(x);
+	 rprintf("Not enough ram to uncompress trace\n");
+	 return false;
+	}
+  if(x!=NULL)
+	{fc_decompress(pComp->x,x);
+	 pAGraph->x_vals=x;
+	}
+  if(y!=NULL)
+	{fc_decompress(pComp->y,y);
+	 pAGraph->y_vals=y;
+	}
+  pAGraph->size_vals_arrays=n; // uncompressed arrays are exactly the size needed (as after fnShrinkGraph() )
+  fnFreeCompressed(pAGraph);
+  return true;
+}
+
+void TScientificGraph::fnFreeCompressed(SGraph *pAGraph) // free compressed values of graph
+{ SCompressed *pComp=pAGraph->pComp;
+  if(pComp==NULL) return;
+  fc_free(pComp->x);
+  fc_free(pComp->y);
+  free(pComp->x_block);
+  free(pComp->y_block);
+  delete pComp;
+  pAGraph->pComp=NULL;
+}
+
+TScientificGraph::SGraph *TScientificGraph::fnGraphData(int iGraphNumberF) // returns graph with its values uncompressed and in RAM (so x_vals/y_vals can be used directly and changed), NULL if out of RAM
+{ SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  if(!fnFromScratch(pAGraph) || !fnUncompress(pAGraph)) return NULL;
+  return pAGraph;
+}
+
+bool TScientificGraph::fnYData(SGraph *pAGraph) // copy just the y values of graph into RAM (so they can be changed), x values are left as they are (implicit, compressed or in a scratch file). Returns false if out of RAM
+{ SScratch *pScratch=pAGraph->pScratch;
+  SCompressed *pComp=pAGraph->pComp;
+  size_t n=pAGraph->nos_vals;
+  float *y;
+  if(pScratch!=NULL && pScratch->y!=NULL)
+	{if((y=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float)))==NULL)
+		{rprintf("Not enough ram to read trace back from scratch file\n");
+		 return false;
+		}
+	 memcpy(y,pAGraph->y_vals,n*sizeof(float));
+	 pAGraph->y_vals=y;
+	 fnDropScratch(pAGraph,false); // x values stay in their scratch file
+	}
+  if(pComp!=NULL && pComp->y!=NULL)
+	{if(pComp->x==NULL) return fnUncompress(pAGraph); // only y values are compressed
+	 if((y=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float)))==NULL)
+		{rprintf("Not enough ram to uncompress trace\n");
+		 return false;
+		}
+	 fc_decompress(pComp->y,y);
+	 fc_free(pComp->y); // x values stay compressed
+	 free(pComp->y_block);
+	 pComp->y=NULL;
+	 pComp->y_block=NULL;
+	 pComp->y_blockn=(size_t)-1;
+	 pAGraph->y_vals=y;
+	}
+  return true;
+}
+
+size_t TScientificGraph::fnGraphBytes(int iGraphNumberF) // returns RAM used by x and y values of graph (shared x values and values in scratch files are not included)
+{ if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return 0; // invalid graph number
+  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  SCompressed *pComp=pAGraph->pComp;
+  SScratch *pScratch=pAGraph->pScratch;
+  size_t bytes=0;
+  if(pAGraph->y_vals!=NULL && (pScratch==NULL || pScratch->y==NULL)) bytes+=pAGraph->size_vals_arrays*sizeof(float);
+  if(pAGraph->x_vals!=NULL && pAGraph->pSharedX==NULL && (pScratch==NULL || pScratch->x==NULL)) bytes+=pAGraph->size_vals_arrays*sizeof(float);
+  if(pComp!=NULL)
+	{if(pComp->x!=NULL) bytes+=fc_bytes(pComp->x)+FC_BLOCK_SIZE*sizeof(float);
+	 if(pComp->y!=NULL) bytes+=fc_bytes(pComp->y)+FC_BLOCK_SIZE*sizeof(float);
+	}
+  return bytes;
+}
+
+float TScientificGraph::fnCompVal(SGraph *pAGraph,size_t i,bool x) // returns value i of compressed x (x=true) or y values
+{ SCompressed *pComp=pAGraph->pComp;
+  fc_array *a= x ? pComp->x : pComp->y;
+  float *buf= x ? pComp->x_block : pComp->y_block;
+  size_t *pBlockn= x ? &pComp->x_blockn : &pComp->y_blockn;
+  size_t b=i/FC_BLOCK_SIZE;
+  if(b!=*pBlockn)
+	{// not in the block decoded last time
+	 const fc_block *pBlock=fc_block_info(a,b);
+	 if(i==b*FC_BLOCK_SIZE) return pBlock->first; // first and last values of a block are in its header, so no need to decode it for these
+	 if(i==pAGraph->nos_vals-1 || i==b*FC_BLOCK_SIZE+FC_BLOCK_SIZE-1) return pBlock->last;
+	 fc_decode_block(a,b,buf);
+	 *pBlockn=b;
+	}
+  return buf[i-b*FC_BLOCK_SIZE];
+}
+
+size_t TScientificGraph::fnYBlockBefore(SGraph *pAGraph,size_t i,double x,const fc_block **ppBlock) // if i is the start of a block of compressed y values whose x values are all < x returns number of values in block (and sets *ppBlock to its header), otherwise returns 0
+{ // used by fnPaint() to skip over blocks that are all inside one pixel column without decoding them
+  if(pAGraph->pComp==NULL || pAGraph->pComp->y==NULL || i%FC_BLOCK_SIZE!=0) return 0;
+  size_t n=pAGraph->nos_vals-i;
+  if(n>FC_BLOCK_SIZE) n=FC_BLOCK_SIZE;
+  if(!(fnXval(pAGraph,i+n-1)<x)) return 0; // x values are in increasing order, so only need to check the last one
+  *ppBlock=fc_block_info(pAGraph->pComp->y,i/FC_BLOCK_SIZE);
+  return n;
+}
+
+bool TScientificGraph::fnToScratch(int iGraphNumberF) // move x and y values of graph into memory mapped scratch files (see scratch-file.c), returns true if values are now in scratch files
+{ if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return false; // invalid graph number
+  return fnMoveToScratch((SGraph*) pHistory->Items[iGraphNumberF]);
+}
+
+bool TScientificGraph::fnMoveToScratch(SGraph *pAGraph) // move x and y values of graph into memory mapped scratch files, returns true if values are now in scratch files
+{ // when RAM is short Windows just drops the pages of the scratch files from RAM (and reads them back when needed) rather than writing them to the pagefile.
+  // values are still read directly via x_vals/y_vals. Functions that change values (eg filters) copy them back into RAM first via fnGraphData().
+  // points can still be added by fnAddDataPoint(), the files have space for size_vals_arrays values and fnGrowGraph() makes them bigger when they are full.
+  // x values are only moved if they belong to just this graph (shared x values are only stored once anyway), compressed values are not moved as they are already small.
+  // the min and max y values are found as the values are moved (and kept up to date by fnAddDataPoint() ), so fnAutoScale() does not need to read the whole of the scratch file again.
+  size_t n=pAGraph->nos_vals;
+  if(pAGraph->pScratch!=NULL) return true; // already in scratch files
+  if(pAGraph->pComp!=NULL || n==0 || scratch_dir()==NULL) return false;
+  SScratch *pScratch=new SScratch;
+  pScratch->x=NULL;
+  pScratch->y=scratch_create(pAGraph->y_vals,n,pAGraph->size_vals_arrays);
+  if(pScratch->y==NULL)
+	{delete pScratch; // disk full etc, so leave values in RAM
+	 return false;
+	}
+  if(pAGraph->x_vals!=NULL && pAGraph->pSharedX==NULL)
+	pScratch->x=scratch_create(pAGraph->x_vals,n,pAGraph->size_vals_arrays); // if this fails x values just stay in RAM
+  pScratch->y_min=FLT_MAX;
+  pScratch->y_max= -FLT_MAX;
+  pScratch->y_min_i=pScratch->y_max_i=0;
+  for(size_t i=0;i<n;++i)
+	{float y=pAGraph->y_vals[i];
+	 if(y<pScratch->y_min) {pScratch->y_min=y;pScratch->y_min_i=i;}
+	 if(y>pScratch->y_max) {pScratch->y_max=y;pScratch->y_max_i=i;}
+	}
+  // functions that change values in scratch files (other than adding points) call fnGraphData() first which copies them back into RAM
+  free(pAGraph->y_vals);
+  pAGraph->y_vals=scratch_values(pScratch->y);
+  if(pScratch->x!=NULL)
+	{free(pAGraph->x_vals);
+	 pAGraph->x_vals=scratch_values(pScratch->x);
+	}
+  pScratch->last_used=++uScratchClock;
+  pScratch->in_ram=false; // values have been written to the file, but have not been read via the mapping yet
+  pAGraph->pScratch=pScratch;
+  return true;
+}
+
+bool TScientificGraph::fnFromScratch(SGraph *pAGraph) // copy values in scratch files back into RAM (so they can be changed), returns false if out of RAM (values are still in scratch files in that case)
+{ SScratch *pScratch=pAGraph->pScratch;
+  float *x=NULL,*y=NULL;
+  if(pScratch==NULL) return true; // not in scratch files
+  size_t n=pAGraph->nos_vals;
+  size_t size=pAGraph->size_vals_arrays; // arrays in RAM must be the same size as the other array (eg a followed file may add more points)
+  if((pScratch->x!=NULL && (x=(float *)malloc(size*sizeof(float)))==NULL) ||
+	 (pScratch->y!=NULL && (y=(float *)malloc(size*sizeof(float)))==NULL))
+	{free(x);
+	 rprintf("Not enough ram to read trace back from scratch file\n");
+	 return false;
+	}
+  if(x!=NULL) memcpy(x,pAGraph->x_vals,n*sizeof(float));
+  if(y!=NULL) memcpy(y,pAGraph->y_vals,n*sizeof(float));
+  fnFreeScratch(pAGraph);
+  if(x!=NULL) pAGraph->x_vals=x;
+  if(y!=NULL) pAGraph->y_vals=y;
+  return true;
+}
+
+void TScientificGraph::fnFreeScratch(SGraph *pAGraph) // close (and so delete) scratch files of graph
+{ SScratch *pScratch=pAGraph->pScratch;
+  if(pScratch==NULL) return;
+  if(pScratch->x!=NULL)
+	{scratch_close(pScratch->x);
+	 pAGraph->x_vals=NULL;
+	}
+  if(pScratch->y!=NULL)
+	{scratch_close(pScratch->y);
+	 pAGraph->y_vals=NULL;
+	}
+  delete pScratch;
+  pAGraph->pScratch=NULL;
+}
+
+void TScientificGraph::fnDropScratch(SGraph *pAGraph,bool x) // close the scratch file holding the x (x=true) or y values of graph (the caller has already replaced them), deletes pScratch if it has no scratch files left
+{ SScratch *pScratch=pAGraph->pScratch;
+  if(pScratch==NULL) return;
+  scratch_file **ps= x ? &pScratch->x : &pScratch->y;
+  scratch_close(*ps);
+  *ps=NULL;
+  if(pScratch->x==NULL && pScratch->y==NULL)
+	{delete pScratch;
+	 pAGraph->pScratch=NULL;
+	}
+}
+
+void TScientificGraph::fnScratchUse(SGraph *pAGraph,size_t start,size_t end) // values start..end-1 of graph are about to be read (eg to draw them)
+{ SScratch *pScratch=pAGraph->pScratch;
+  if(pScratch==NULL || end<=start) return;
+  pScratch->last_used=++uScratchClock;
+  if(pScratch->x!=NULL) scratch_willneed(pScratch->x,start,end-start); // start reading values from the disk in big blocks, rather than a page at a time as they are used
+  if(pScratch->y!=NULL) scratch_willneed(pScratch->y,start,end-start); // y values may have been copied back into RAM by fnYData()
+  if(!pScratch->in_ram)
+	{pScratch->in_ram=true;
+	 fnScratchEvict(pAGraph); // make space for these values by removing the least recently used ones from RAM
+	}
+}
+
+void TScientificGraph::fnScratchEvict(SGraph *pKeep) // remove values in scratch files of the least recently used graphs (other than pKeep) from RAM till the rest fit in scratch_ram_bytes
+{ // left to itself Windows removes pages from RAM in roughly the order they were last used, which is a poor choice when several traces are drawn in turn.
+  // Removing all the values of the least recently used traces means the traces used most recently (eg the ones being zoomed into) stay in RAM.
+  size_t bytes=0;
+  for(int i=0;i<iNumberOfGraphs;++i)
+	{SScratch *pScratch=((SGraph*) pHistory->Items[i])->pScratch;
+	 if(pScratch==NULL || !pScratch->in_ram) continue;
+	 if(pScratch->y!=NULL) bytes+=scratch_bytes(pScratch->y);
+	 if(pScratch->x!=NULL) bytes+=scratch_bytes(pScratch->x);
+	}
+  while(bytes>scratch_ram_bytes)
+	{SScratch *pOldest=NULL;
+	 for(int i=0;i<iNumberOfGraphs;++i)
+		{SGraph *pAGraph=(SGraph*) pHistory->Items[i];
+		 SScratch *pScratch=pAGraph->pScratch;
+		 if(pScratch==NULL || !pScratch->in_ram || pAGraph==pKeep) continue;
+		 if(pOldest==NULL || (int)(pScratch->last_used-pOldest->last_used)<0) pOldest=pScratch; // works even if uScratchClock wraps around
+		}
+	 if(pOldest==NULL) break; // only pKeep left in RAM
+	 if(pOldest->y!=NULL)
+		{scratch_release(pOldest->y);
+		 bytes-=scratch_bytes(pOldest->y);
+		}
+	 if(pOldest->x!=NULL)
+		{scratch_release(pOldest->x);
+		 bytes-=scratch_bytes(pOldest->x);
+		}
+	 pOldest->in_ram=false;
+	}
+}
+
 bool TScientificGraph::fnAddDataPoint(float dXValueF, float dYValueF,int iGraphNumberF)    // returns true is added OK, false if not
 { if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return false; // invalid graph number
   SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  if(pAGraph->pComp!=NULL && !fnUncompress(pAGraph)) return false; // not enough RAM to uncompress values (points are added directly to values in scratch files)
   size_t i=pAGraph->nos_vals; // current size
-  if(i >=pAGraph->size_vals_arrays ) return false; // array full [ could try and extend arrays here, but should not be needed ]
-  pAGraph->x_vals[i]= dXValueF;
+  if(i >=pAGraph->size_vals_arrays && !fnGrowGraph(pAGraph)) return false; // array full and cannot make it bigger
+  SSharedX *pShared=pAGraph->pSharedX;
+  if(pAGraph->x_vals==NULL)
+	{// implicit x values, only need an array if x value is not the next one expected (eg when following a file that stops being sampled at a fixed rate)
+	 if(dXValueF!=fnXval(pAGraph,i))
+		{if(fnXarray(pAGraph)==NULL) return false;
+		 pAGraph->x_vals[i]= dXValueF;
+		}
+	}
+  else if(pShared==NULL)
+	pAGraph->x_vals[i]= dXValueF;
+  else if(i==pShared->nos_vals)
+	{// 1st graph sharing these x values to get this far, so add x value for all of them
+	 if(i>=pShared->size_x_vals && !fnGrowSharedX(pShared)) return false;
+	 pShared->x_vals[i]= dXValueF;
+	 pShared->nos_vals=i+1;
+	}
+  else if(pShared->x_vals[i]!=dXValueF)
+	{// x value is different to the one shared (eg this line had an invalid y value for another trace), so this graph needs its own x values from now on
+	 if(!fnPrivateX(pAGraph)) return false;
+	 pAGraph->x_vals[i]= dXValueF;
+	}
   pAGraph->y_vals[i]= dYValueF;
   pAGraph->nos_vals=i+1; // one more data point stored
+  SScratch *pScratch=pAGraph->pScratch;
+  if(pScratch!=NULL && pScratch->y!=NULL)
+	{// keep min/max y values up to date for fnAutoScale()
+	 if(dYValueF<pScratch->y_min) {pScratch->y_min=dYValueF;pScratch->y_min_i=i;}
+	 if(dYValueF>pScratch->y_max) {pScratch->y_max=dYValueF;pScratch->y_max_i=i;}
+	}
+  else if(pScratch==NULL && i+1==SCRATCH_MIN_POINTS && scratch_dir()!=NULL)
+	fnMoveToScratch(pAGraph); // arrays may already be big enough for the whole file (so fnGrowGraph() is not called), so move big traces to scratch files here (if this fails values just stay in RAM)
   // rprintf("addpoint X=%g Y=%g graphnos=%d point#=%d\n",dXValueF,dYValueF,iGraphNumberF,i);
   return true; // data point added OK
 };
@@ -1222,7 +1748,7 @@ float TScientificGraph::fnAddDataPoint_nextx(int iGraphNumberF)    // returns ne
 	{rprintf("Warning:fnAddDataPoint_nextx(%d): pAGraph->nos_vals=%.0f pAGraph_1->nos_vals=%.0f\n",iGraphNumberF,(double)i,(double)(pAGraph_1->nos_vals));
 	 return 0; // past end of previous x array
 	}
-  return pAGraph_1->x_vals[i];     // value from previous trace
+  return fnXval(pAGraph_1,i);     // value from previous trace
 };
 
 #if 1  /* use interpolation to find matching y value to current x value even if current x value is not actually in the array */
@@ -1231,7 +1757,7 @@ float TScientificGraph::fnAddDataPoint_thisy(int iGraphNumber)    // returns nex
   if(iGraphNumber<0 || iGraphNumber >=iNumberOfGraphs-1) return 0; // invalid graph number (-1 as cannot refer to current trace
   SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumber]); // previous trace added
   // float interp1D(float *xa, float *ya, int size, float x, bool clip)
-  return interp1D_f(pAGraph->x_vals,pAGraph->y_vals,pAGraph->nos_vals ,xval,false);
+  return fnInterpY(pAGraph,xval,false);
 };
 #else /* original code - does not work if x values need to be sorted afterwards */
 float TScientificGraph::fnAddDataPoint_thisy(int iGraphNumber)    // returns next y value of iGraphNumber (locn from current graph number)  used to do $T1
@@ -1248,8 +1774,17 @@ bool TScientificGraph::fnChangeXoffset(double dX) // change all X values by addi
 {
   if( iNumberOfGraphs<2) return false;   // must be at least 2 graphs to do this
   int j=iNumberOfGraphs-1;
-  SGraph *pAGraph = ((SGraph*) pHistory->Items[j]);
+  SGraph *pAGraph = fnGraphData(j);
+  if(pAGraph==NULL) return false; // not enough RAM to uncompress values
   size_t iCount=pAGraph->nos_vals; // current size;
+  if(pAGraph->x_vals==NULL)
+	{pAGraph->x_start+=dX; // implicit x values, so just move the start
+	 return true;
+	}
+  if(!fnPrivateX(pAGraph))
+	{rprintf("fnChangeXoffset: Not enough ram for a copy of the x values\n");
+	 return false;
+	}
   for (size_t i=0; i<iCount; i++)  // for all items in list add dX to x value
       {
 	   pAGraph->x_vals[i]+=dX;
@@ -1303,7 +1838,8 @@ void TScientificGraph::fnMedian_filt(unsigned int median_ahead, int iGraphNumber
 {// mt=median(mint+,maxt+,mt-1)  - min, max look ahead 2+ . This algorithm provides a fast (if median_ahead is smallish) but good approximation to a true median
  if(median_ahead>1)
 		{double m,ymin,ymax;
-		 SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+		 SGraph *pAGraph = fnGraphData(iGraphNumberF);
+		 if(pAGraph==NULL) return; // not enough RAM to uncompress values
 		 size_t iCount=pAGraph->nos_vals;
 		 m=pAGraph->y_vals[0]; // initial value
 		 for (size_t i=0; i<iCount; i++)  // for all items in list
@@ -1327,7 +1863,8 @@ void TScientificGraph::fnMedian_filt(unsigned int median_ahead, int iGraphNumber
 void TScientificGraph::fnKalman_filter(double median_ahead_t, int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt)) // apply single variable Kalamn filter with noise variance of median_ahead_t to graph in place
 {// see e.g. "Tracking and Kalman Filtering made easy" by Eli Brookner. or https://wirelesspi.com/the-easiest-tutorial-on-kalman-filter/
  time_t lastT=clock(); // used to keep callbacks at uniform time intervals;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals;
  double kalman_gain,current_estimate, estimated_var;
 
@@ -1355,14 +1892,15 @@ void TScientificGraph::fnCentral_moving_average_filter(double median_ahead_t, in
 {  // central moving average - take average of values +/- median_ahead_t either side of current x value
  // callback() is called periodically to let caller know progress. This is done based on time (once/sec).
  time_t lastT;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t maxi=pAGraph->nos_vals ;
  float *yp=pAGraph->y_vals;
- float *xp=pAGraph->x_vals;// we know this is already sorted into ascending order
+ // x values are already sorted into ascending order, they are read via fnXval() so implicit x values do not need an array
  double avy;
  if(median_ahead_t<=0 || maxi<3) // need at least 3 points for initial median and need a positive value for the look ahead time
 	return;
- if( (xp[maxi-1]-xp[0])<=median_ahead_t )
+ if( (fnXval(pAGraph,maxi-1)-fnXval(pAGraph,0))<=median_ahead_t )
 	{// range is very large - just take (exact) average and set all values to this
 	 avy=yp[0];
 	 for(size_t i=1;i<maxi;++i)
@@ -1391,19 +1929,19 @@ void TScientificGraph::fnCentral_moving_average_filter(double median_ahead_t, in
 			 (*callback)(i,maxi); // give user an update on progress
 			}
 	 // update istart , this is always <= i as x values are in increasing order so doesn't need any special checks
-	 while(xp[istart]<xp[i]-median_ahead_t)
+	 while(fnXval(pAGraph,istart)<fnXval(pAGraph,i)-median_ahead_t)
 		{sum -=yp[istart];    // we need to keep track of the sum
 		 ++istart;
 		}
 	 // update iend, here we do need to make sure we don't go beyond the end of the array
-	 while(iend<maxi-1 &&  xp[iend]< xp[i]+median_ahead_t)
+	 while(iend<maxi-1 &&  fnXval(pAGraph,iend)< fnXval(pAGraph,i)+median_ahead_t)
 		{++iend;
 		 sum +=yp[iend];    // we need to keep track of the sum
 
 		}
 	 // now calculate average of values in range
 	 avy=sum/(1+iend-istart);
-	 // rprintf(" CMA i=%zu [x=%g]: istart=%zu [x=%g] iend=%zu [x=%g] gives sum=%g avg=%g\n",i, xp[i],istart,xp[istart],iend,xp[iend],sum,avy);
+	 // rprintf(" CMA i=%zu [x=%g]: istart=%zu [x=%g] iend=%zu [x=%g] gives sum=%g avg=%g\n",i, fnXval(pAGraph,i),istart,fnXval(pAGraph,istart),iend,fnXval(pAGraph,iend),sum,avy);
 	 newy[i]=(float)avy; // current moving average
 	}
  free(yp);
@@ -1485,15 +2023,16 @@ return (p[12]);
 {  // central median filter - take median of values +/- median_ahead_t either side of current x value
  // callback() is called periodically to let caller know progress. This is done based on time (once/sec).
  time_t lastT,startT,nowT;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t maxi=pAGraph->nos_vals ;
  float *yp=pAGraph->y_vals;
- float *xp=pAGraph->x_vals;// we know this is already sorted into ascending order
+ // x values are already sorted into ascending order, they are read via fnXval() so implicit x values do not need an array
  double avy,medy;
  int used_approx=0; // incremented if approximate median calculation used
  if(median_ahead_t<=0 || maxi<3) // need at least 3 points for initial median and need a positive value for the look ahead time
 	return;
- if( (xp[maxi-1]-xp[0])<=median_ahead_t )
+ if( (fnXval(pAGraph,maxi-1)-fnXval(pAGraph,0))<=median_ahead_t )
 	{// range is very large - just take (exact) median and set all values to this
 	 medy=yaMedian(pAGraph->y_vals,maxi);  // this changes the order of y_vals[] but thats not an issue here as we overwrite them all below with medy
 	 rprintf("Median: Exact median=%g: all y values set to this\n",medy);
@@ -1520,12 +2059,12 @@ return (p[12]);
 			 if(callback!=NULL) (*callback)(i,maxi); // give user an update on progress
 			}
 	 // update istart , this is always <= i as x values are in increasing order so doesn't need any special checks
-	 while(xp[istart]<xp[i]-median_ahead_t)
+	 while(fnXval(pAGraph,istart)<fnXval(pAGraph,i)-median_ahead_t)
 		{sum -=yp[istart];    // we need to keep track of the sum
 		 ++istart;
 		}
 	 // update iend, here we do need to make sure we don't go beyond the end of the array
-	 while(iend<maxi-1 &&  xp[iend]< xp[i]+median_ahead_t)
+	 while(iend<maxi-1 &&  fnXval(pAGraph,iend)< fnXval(pAGraph,i)+median_ahead_t)
 		{++iend;
 		 sum +=yp[iend];    // we need to keep track of the sum
 		}
@@ -1537,7 +2076,7 @@ return (p[12]);
 		{// use approximation
 		 // 1st calculate average of values in range
 		 avy=sum/(1+iend-istart);
-		 // rprintf(" CMA i=%zu [x=%g]: istart=%zu [x=%g] iend=%zu [x=%g] gives sum=%g avg=%g\n",i, xp[i],istart,xp[istart],iend,xp[iend],sum,avy);
+		 // rprintf(" CMA i=%zu [x=%g]: istart=%zu [x=%g] iend=%zu [x=%g] gives sum=%g avg=%g\n",i, fnXval(pAGraph,i),istart,fnXval(pAGraph,istart),iend,fnXval(pAGraph,iend),sum,avy);
 		 medy=avy; //  We know the average is between min & max values
 		 if(nowT-startT <  2*CLOCKS_PER_SEC*MED1MAX_T && 1+iend-istart <=183 )
 			{// for a smallish number of elements and execution times between MED1MAX_T & 2*MED1MAX_T , ie for next MED1MAX_T secs use a sampling median - sample 25 values
@@ -1594,15 +2133,16 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
  // callback() is called periodically to let caller know progress. This is done based on time (once/sec).
  time_t lastT;
  size_t i,j,k;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t maxi=pAGraph->nos_vals ;
  float miny,maxy,medy;
  float firstx,tmax;
  float *yp=pAGraph->y_vals;
- float *xp=pAGraph->x_vals;// we know this is already sorted into ascending order
+ // x values are already sorted into ascending order, they are read via fnXval() so implicit x values do not need an array
  if(median_ahead_t<=0 || maxi<3) // need at least 3 points for initial median and need a positive value for the look ahead time
 	return;
- if( (xp[maxi-1]-xp[0])<=median_ahead_t )
+ if( (fnXval(pAGraph,maxi-1)-fnXval(pAGraph,0))<=median_ahead_t )
 	{// just take (exact) median and set all values to this
 	 medy=ya_median(pAGraph->y_vals,maxi);
 	 rprintf("Median1: Exact median=%g: all y values set to this\n",medy);
@@ -1622,22 +2162,22 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
 		}
 	 size_t lasti=0;
 	 // now process the values till x gets to the end
-	 tmax=xp[maxi-1];
+	 tmax=fnXval(pAGraph,maxi-1);
 	 size_t firsti=0;
-	 for(i=0;i<maxi && xp[i]<=tmax;++i)
+	 for(i=0;i<maxi && fnXval(pAGraph,i)<=tmax;++i)
 		{
 		 if(callback!=NULL && (i & 0x3ff)==0 && (clock()-lastT)>= CLOCKS_PER_SEC)
 			{lastT=clock();   // update on progress every second (approximately - use i & 0xff to keep average overhead of time() check very low
 			 (*callback)(i,maxi); // give user an update on progress
 			}
-		 firstx=(float)(xp[i]-(median_ahead_t));
+		 firstx=(float)(fnXval(pAGraph,i)-(median_ahead_t));
 		 // subtract values for bin corresponding to those x values that are now too old
-		 while(firsti<maxi && xp[firsti]<firstx)
+		 while(firsti<maxi && fnXval(pAGraph,firsti)<firstx)
 			{
 			 firsti++;
 			}
 		 // now add in new y value(s)
-		 while(lasti<maxi && xp[lasti]<=xp[i]+(median_ahead_t))
+		 while(lasti<maxi && fnXval(pAGraph,lasti)<=fnXval(pAGraph,i)+(median_ahead_t))
 			{
 			 ++lasti;// value time+med_ahead_t
 			}
@@ -1681,18 +2221,18 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
  size_t lasti=0;
 
  // now process the values till x gets to the end
- tmax=xp[maxi-1];
+ tmax=fnXval(pAGraph,maxi-1);
  // rprintf("Median1: tmax=%g\n",tmax);
  size_t firsti=0;
- for(i=0;i<maxi && xp[i]<=tmax;++i)
+ for(i=0;i<maxi && fnXval(pAGraph,i)<=tmax;++i)
 	{
 	 if(callback!=NULL && (i & 0xffff)==0 && (clock()-lastT)>= CLOCKS_PER_SEC)
 			{lastT=clock();   // update on progress every second (approximately - use i & 0xff to keep average overhead of time() check very low
 			 (*callback)(i,maxi); // give user an update on progress
 			}
-	 firstx=(float)(xp[i]-(median_ahead_t));
+	 firstx=(float)(fnXval(pAGraph,i)-(median_ahead_t));
 	 // subtract values for bin corresponding to those x values that are now too old
-	 while(firsti<maxi && xp[firsti]<firstx)
+	 while(firsti<maxi && fnXval(pAGraph,firsti)<firstx)
 		{size_t bin=(size_t)(((double)yp[firsti]-(double)miny) * scalefactor);
 		 if(bincounts[bin]>0 && nos_vals>0 )
 			{bincounts[bin]--;
@@ -1702,7 +2242,7 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
 		}
 	 //rprintf("firstx=%g firsti=%u about to add in \n",firstx,(unsigned)firsti);
 	 // now add in new y value(s)
-	 while(lasti<maxi && xp[lasti]<=xp[i]+(median_ahead_t))
+	 while(lasti<maxi && fnXval(pAGraph,lasti)<=fnXval(pAGraph,i)+(median_ahead_t))
 		{
 		 bincounts[(size_t)(((double)yp[lasti]-(double)miny) * scalefactor)]++;// new bin value
 		 nos_vals++; // account for the added value into bins
@@ -1755,7 +2295,8 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
  float this_endT,maxy,miny,nearesty,y,m;
  float f,dt; // linear filtered value (range limited based on median limits)
  float k,lastdt=0,x,lastx=0;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  unsigned int maxi=pAGraph->nos_vals ;
  lastT=clock(); // used to keep callbacks at uniform time intervals
  if(median_ahead_t>0 && maxi>=3) // need at least 3 points for initial median and need a positive value for the look ahead time
@@ -1767,12 +2308,12 @@ void TScientificGraph::fnMedian_filt_time1(double median_ahead_t, int iGraphNumb
 						{lastT=clock();   // update on progress every second (approximately - use i & 0xff to keep average overhead of time() check very low
 						 (*callback)(i,maxi);
 						}
-				 this_endT=pAGraph->x_vals[i]+median_ahead_t; // time for the end of the look ahead
-				 if(last_endi!=0) lastx=pAGraph->x_vals[last_endi-1];
-				 for(endi=last_endi;endi<maxi &&pAGraph->x_vals[endi] < this_endT;++endi) // search forward to find i that matches end of look ahead time
+				 this_endT=fnXval(pAGraph,i)+median_ahead_t; // time for the end of the look ahead
+				 if(last_endi!=0) lastx=fnXval(pAGraph,last_endi-1);
+				 for(endi=last_endi;endi<maxi &&fnXval(pAGraph,endi) < this_endT;++endi) // search forward to find i that matches end of look ahead time
 						{ // update linear filter while we do this so it "runs" median_ahead_t in advance of current location so approximately gives average of +/-median_ahead_t around current time
 						 if(i!=0) // if i==0 don't do anything here as we will calculate the actual median below and use this to initialise f
-								{x= pAGraph->x_vals[endi];
+								{x= fnXval(pAGraph,endi);
 								 dt= x - lastx;
 								 lastx=x;
                                  if(dt>0)
@@ -1850,17 +2391,18 @@ void TScientificGraph::fnMedian_filt_time(double median_ahead_t, int iGraphNumbe
  // callback() is called periodically to let caller know progress   . This is done based on time (once/sec).
  time_t lastT;
  size_t i,j,k,lasti=0;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t maxi=pAGraph->nos_vals ;
  unsigned int time_taken_secs=0;
  float miny,maxy,medy;
  size_t miny_pos=0,maxy_pos=0;// positions of min/max
  // float firstx,tmax;
  float *yp=pAGraph->y_vals;
- float *xp=pAGraph->x_vals;// we know this is already sorted into ascending order
+ // x values are already sorted into ascending order, they are read via fnXval() so implicit x values do not need an array
  if(median_ahead_t<=0 || maxi<3) // need at least 3 points for initial median and need a positive value for the look ahead time
 	return;
- if( (xp[maxi-1]-xp[0])<=median_ahead_t )
+ if( (fnXval(pAGraph,maxi-1)-fnXval(pAGraph,0))<=median_ahead_t )
 	{// just take (exact) median and set all values to this
 	 medy=ya_median(pAGraph->y_vals,maxi);
 	 rprintf("Median: Exact median=%g: all y values set to this\n",medy);
@@ -1893,9 +2435,9 @@ void TScientificGraph::fnMedian_filt_time(double median_ahead_t, int iGraphNumbe
 		 lmaxy=lminy=yp[lasti];
 		 lmaxy_pos=lminy_pos=lasti;
 		 start_lasti=lasti;
-		 if(lasti+1<maxi && xp[lasti+1]<=xp[i]+(median_ahead_t) )
+		 if(lasti+1<maxi && fnXval(pAGraph,lasti+1)<=fnXval(pAGraph,i)+(median_ahead_t) )
 			{
-			 for(lasti++;lasti<maxi && xp[lasti]<=xp[i]+(median_ahead_t);++lasti)
+			 for(lasti++;lasti<maxi && fnXval(pAGraph,lasti)<=fnXval(pAGraph,i)+(median_ahead_t);++lasti)
 				{// look ahead from end of previous lookahead, updating min/max if we can
 				 float t=yp[lasti];
 				 if(t>=lmaxy)
@@ -1971,7 +2513,8 @@ void TScientificGraph::fnMedian_filt_time(double median_ahead_t, int iGraphNumbe
  time_t lastT;
  unsigned int i,j,last_endi=0,endi,jinc ;
  float this_endT,maxy,miny,y,m;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  unsigned int maxi=pAGraph->nos_vals ;
  lastT=clock(); // used to keep callbacks at uniform time intervals
  if(median_ahead_t>0 && maxi>=3) // need at least 3 points for initial median and need a positive value for the look ahead time
@@ -1983,8 +2526,8 @@ void TScientificGraph::fnMedian_filt_time(double median_ahead_t, int iGraphNumbe
                         {lastT=clock();   // update on progress every second (approximately - use i & 0xff to keep average overhead of time() check very low
                          (*callback)(i,maxi);
                         }
-				 this_endT=pAGraph->x_vals[i]+median_ahead_t; // time for the end of the look ahead
-				 for(endi=last_endi;endi<maxi && pAGraph->x_vals[endi] < this_endT;++endi); // search forward to find i that matches end of look ahead time
+				 this_endT=fnXval(pAGraph,i)+median_ahead_t; // time for the end of the look ahead
+				 for(endi=last_endi;endi<maxi && fnXval(pAGraph,endi) < this_endT;++endi); // search forward to find i that matches end of look ahead time
 				 if(i==0)
 						{
 						 m=ya_median(pAGraph->y_vals,endi); // calculate median in place (don't change arr).
@@ -2034,15 +2577,16 @@ void TScientificGraph::fnLinear_filt_time(double tc, int iGraphNumberF, void (*c
  if(tc>0)
 		{double m;
 		 double lastx,x,y,k;
-		 SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+		 SGraph *pAGraph = fnGraphData(iGraphNumberF);
+		 if(pAGraph==NULL) return; // not enough RAM to uncompress values
 		 size_t iCount=pAGraph->nos_vals ;
 		 if(iCount<2) return; // not enough data in graph to process
 		 m=pAGraph->y_vals[0]; // initial value
-		 lastx=pAGraph->x_vals[0];
+		 lastx=fnXval(pAGraph,0);
 		 for (unsigned int i=0; i<iCount; i++)  // for all items in list
                 {
 				 y=pAGraph->y_vals[i];
-				 x=pAGraph->x_vals[i];
+				 x=fnXval(pAGraph,i);
                  if(x>lastx)
                         {// above if avoids possible maths error below
                          k=1.0-exp(-(x-lastx)/tc);
@@ -2057,35 +2601,64 @@ void TScientificGraph::fnLinear_filt_time(double tc, int iGraphNumberF, void (*c
 }
 
 size_t TScientificGraph::fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF)
- // allow access to x and y arrays of specified graph, returns nos points
- {SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
-  size_t iCount=pAGraph->nos_vals ;
-  *x_arr=pAGraph->x_vals;
-  *y_arr=pAGraph->y_vals;
-  return iCount;
+ // allow access to x and y arrays of specified graph, returns nos points (0 if out of RAM)
+ // x_arr or y_arr can be NULL if that array is not needed. Only the y values are brought back into RAM (so they can be changed), the x values are read only
+ // and *x_arr may be a temporary copy (eg if x values are implicit) so must be freed with fnFreexarr(). This leaves the x values stored as they were.
+ {if(x_arr!=NULL) *x_arr=NULL;
+  if(y_arr!=NULL) *y_arr=NULL;
+  if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return 0; // invalid graph number
+  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  if(y_arr!=NULL)
+	{if(!fnYData(pAGraph)) return 0; // not enough RAM to uncompress values
+	 *y_arr=pAGraph->y_vals;
+	}
+  if(x_arr!=NULL && (*x_arr=fnXcopy(pAGraph))==NULL) return 0; // not enough ram
+  return pAGraph->nos_vals ;
  }
 
+void TScientificGraph::fnFreexarr(float *x_arr,int iGraphNumberF) // free x array returned by fnGetxyarr() (if it was a temporary copy)
+{ if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return; // invalid graph number
+  fnFreeXcopy((SGraph*) pHistory->Items[iGraphNumberF],x_arr);
+}
+
+#define SG_WINDOW 32 /* points either side of index passed to Savitzky Golay functions by fnSG_filter() when x values are implicit, they use at most +/-24 */
+
+void TScientificGraph::fnSG_filter(SGraph *pAGraph,float *newy,double (*fn)(float *y,float *x,size_t start,size_t end,size_t index,unsigned int order),unsigned int order)
+{ // newy[i]=fn(...,i,order) for all points of graph, fn is one of the Savitzky Golay functions in smooth_diff.c
+  size_t iCount=pAGraph->nos_vals ;
+  float *y_arr=pAGraph->y_vals;
+  if(pAGraph->x_vals!=NULL)
+	{for(size_t i=0;i<iCount;++i)
+		newy[i]=(float)fn(y_arr,pAGraph->x_vals,0,iCount-1,i,order);
+	 return;
+	}
+  // implicit x values (constant step) so there is no array of x values. The Savitzky Golay functions only use points within +/-24 of index (or the first/last 25 points)
+  // so they are given the points within +/-SG_WINDOW of index, with those x values calculated as needed. This gives exactly the same results as using the whole arrays.
+  float xw[2*SG_WINDOW+1];
+  for(size_t i=0;i<iCount;++i)
+	{size_t lo= i>SG_WINDOW ? i-SG_WINDOW : 0;
+	 size_t hi= i+SG_WINDOW<iCount-1 ? i+SG_WINDOW : iCount-1;
+	 for(size_t j=lo;j<=hi;++j)
+		xw[j-lo]=fnXval(pAGraph,j);
+	 newy[i]=(float)fn(y_arr+lo,xw,0,hi-lo,i-lo,order);
+	}
+}
+
 void deriv_trace(int iGraph); // in UDataPlotWindow.cpp
 void TScientificGraph::deriv_filter(unsigned int diff_order,int iGraphNumberF)
 { // take derivative of specified trace .
   //  uses 17 point Savitzky Golay algorithm
   // needs to create a new array for results as uses points either side of index to calculate derivative
-  float *x_arr,*y_arr;
-  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
-  size_t iCount=pAGraph->nos_vals ;
-  float *newy=(float *)malloc(iCount*sizeof(float));
+  SGraph *pAGraph = fnGraphData(iGraphNumberF);
+  if(pAGraph==NULL) return; // not enough RAM to uncompress values
+  float *newy=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float));
   if(newy==NULL)
 		{rprintf("deriv_filter: Not enough ram to calculate filtered derivative, using unfiltered derivative\n");
 		 deriv_trace(iGraphNumberF) ;
 		 return;
 		}
-  x_arr=pAGraph->x_vals;
-  y_arr=pAGraph->y_vals;
-  for(size_t i=0;i<iCount;++i)
-	{
-	 newy[i]=(float)dy_dx17(y_arr, x_arr,0,iCount-1, i,diff_order );  // calculate derivative at point "i"
-	}
-  free(y_arr); // delete original y values
+  fnSG_filter(pAGraph,newy,dy_dx17,diff_order);  // calculate derivative at every point
+  free(pAGraph->y_vals); // delete original y values
   pAGraph->y_vals=newy;// put in new y values
   return; // all done
 }
@@ -2094,25 +2667,19 @@ void TScientificGraph::deriv2_filter(unsigned int diff_order,int iGraphNumberF)
 { // take 2nd derivative of specified trace .
   //  uses 25/17 point Savitzky Golay algorithm
   // needs to create a new array for results as uses points either side of index to calculate derivative
-  float *x_arr,*y_arr;
-  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
-  size_t iCount=pAGraph->nos_vals ;
-  float *newy=(float *)malloc(iCount*sizeof(float));
+  SGraph *pAGraph = fnGraphData(iGraphNumberF);
+  if(pAGraph==NULL) return; // not enough RAM to uncompress values
+  float *newy=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float));
   if(newy==NULL)
 		{rprintf("deriv2_filter: Not enough ram to calculate filtered 2nd derivative - no filter applied\n");
 		 return;
 		}
-  x_arr=pAGraph->x_vals;
-  y_arr=pAGraph->y_vals;
-  for(size_t i=0;i<iCount;++i)
-	{
 #if 1
-	 newy[i]=(float)d2y_d2x25(y_arr, x_arr,0,iCount-1, i,diff_order );  // calculate 2nd derivative at point "i"
+  fnSG_filter(pAGraph,newy,d2y_d2x25,diff_order);  // calculate 2nd derivative at every point
 #else
-	 newy[i]=(float)d2y_d2x17(y_arr, x_arr,0,iCount-1, i,diff_order );  // calculate 2nd derivative at point "i"
+  fnSG_filter(pAGraph,newy,d2y_d2x17,diff_order);  // calculate 2nd derivative at every point
 #endif
-	}
-  free(y_arr); // delete original y values
+  free(pAGraph->y_vals); // delete original y values
   pAGraph->y_vals=newy;// put in new y values
   return; // all done
 }
@@ -2121,41 +2688,40 @@ void TScientificGraph::Savitzky_Golay_smoothing(unsigned int s_order,int iGraphN
 { // Savitzky Golay smoothing of specified trace fitting a polynomial of specified order
   //  uses 25/17 point Savitzky Golay algorithm
   // needs to create a new array for results as uses points either side of index to calculate filtered value
-  float *x_arr,*y_arr;
-  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
-  size_t iCount=pAGraph->nos_vals ;
-  float *newy=(float *)malloc(iCount*sizeof(float));
+  SGraph *pAGraph = fnGraphData(iGraphNumberF);
+  if(pAGraph==NULL) return; // not enough RAM to uncompress values
+  float *newy=(float *)malloc(pAGraph->size_vals_arrays*sizeof(float));
   if(newy==NULL)
 		{rprintf("Savitzky Golay smoothing: Not enough ram to calculate filtered result\n");
 		 return;
 		}
-  x_arr=pAGraph->x_vals;
-  y_arr=pAGraph->y_vals;
-  for(size_t i=0;i<iCount;++i)
-	{
 #if 1
-     newy[i]=(float)Savitzky_Golay_smoothing25(y_arr, x_arr,0,iCount-1, i,s_order );  // calculate smoothed value at point "i"
+  fnSG_filter(pAGraph,newy,Savitzky_Golay_smoothing25,s_order);  // calculate smoothed value at every point
 #else
-	 newy[i]=(float)Savitzky_Golay_smoothing17(y_arr, x_arr,0,iCount-1, i,s_order );  // calculate smoothed value at point "i"
+  fnSG_filter(pAGraph,newy,Savitzky_Golay_smoothing17,s_order);  // calculate smoothed value at every point
 #endif
-	}
-  free(y_arr); // delete original y values
+  free(pAGraph->y_vals); // delete original y values
   pAGraph->y_vals=newy;// put in new y values
   return; // all done
 }
 
 void TScientificGraph::Spline_smoothing(double tc,int iGraphNumberF) // Smoothing spline smoothing "tc" is a number 0..1
 { // Smoothing spline smoothing of specified trace
-  SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+  SGraph *pAGraph = fnGraphData(iGraphNumberF);
+  if(pAGraph==NULL) return; // not enough RAM to uncompress values
   // void SmoothingSpline( s_spline_float *x, s_spline_float *y, s_spline_float *yo, size_t _n, double lambda);
-  SmoothingSpline(pAGraph->x_vals, pAGraph->y_vals,NULL, pAGraph->nos_vals,tc);  // does all the hard work!
+  float *x_arr=fnXcopy(pAGraph); // x values are only read
+  if(x_arr==NULL) return; // not enough ram
+  SmoothingSpline(x_arr, pAGraph->y_vals,NULL, pAGraph->nos_vals,tc);  // does all the hard work!
+  fnFreeXcopy(pAGraph,x_arr);
   return; // all done
 }
 
 void TScientificGraph::fnLinreg_origin( int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt))
 { // straight line passing through origin    y=m*x
   // underlying equation for the best straight line through the origin=sum(XiYi)/sum(Xi^2) from Yang Feng (Columbia Univ) Simultaneous Inferences, pp 18/20.
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  double meanx2=0,meanxy=0; /* mean x^2 , mean x*y */
  double xi,yi;
@@ -2166,7 +2732,7 @@ void TScientificGraph::fnLinreg_origin( int iGraphNumberF, void (*callback)(size
  if(iCount<2) return; // not enough data in graph to process
  for(i=0;i<iCount;++i) /* only use 1 pass here - to calculate means directly */
 		{++N;
-		 xi=pAGraph->x_vals[i];
+		 xi=fnXval(pAGraph,i);
 		 yi=pAGraph->y_vals[i];
 		 meanx2+= (xi*xi-meanx2)/(double) N;
 		 meanxy+= (xi*yi-meanxy)/(double) N;
@@ -2184,7 +2750,7 @@ void TScientificGraph::fnLinreg_origin( int iGraphNumberF, void (*callback)(size
  // now put new y values back, calculated as y=m*x+c
  for(i=0;i<iCount;++i)
 	{yi=pAGraph->y_vals[i];
-	 xi=pAGraph->x_vals[i];
+	 xi=fnXval(pAGraph,i);
 	 try{ // code below has tests for common issues, but use try to catch anything else
 		 pAGraph->y_vals[i]=(float)(m*xi);
 		 e=fabs(yi-pAGraph->y_vals[i]);
@@ -2202,13 +2768,15 @@ void TScientificGraph::fnLinreg_origin( int iGraphNumberF, void (*callback)(size
 
 void TScientificGraph::fnLinreg_abs(bool rel, int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt))
 {  // fit y=mx+c with either min abs error or min abs rel error
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  if(iCount<2) return; // not enough data in graph to process
  size_t i;
  double m,c,best_err;
  double yi,xi,e,maxe=0;
- float *x_arr=pAGraph->x_vals ; // x values
+ float *x_arr=fnXcopy(pAGraph) ; // x values (only read)
+ if(x_arr==NULL) return; // not enough ram
  float *y_arr=pAGraph->y_vals; // y values
 
  // void fit_min_abs_err_line(float *x, float *y,unsigned int nos_vals,bool rel_error,double *m_out, double *c_out,double *best_err_out)
@@ -2232,6 +2800,7 @@ void TScientificGraph::fnLinreg_abs(bool rel, int iGraphNumberF, void (*callback
   else
 	rprintf("Best min abs error straight line is Y=%g*X%+g (error=%g)\n",m,c,best_err);
  rprintf("  Max abs error of above curve is %g\n",maxe);
+ fnFreeXcopy(pAGraph,x_arr);
 }
 
 static double fun_x(float xparam)
@@ -2245,12 +2814,14 @@ static double fun_sqrt(float xparam)
 
 void TScientificGraph::fnLinreg_3(int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt))
 { // fit y=a*x+b*sqrt(x)+c
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  if(iCount<2) return; // not enough data in graph to process
  unsigned int i;
  double yi,xi,e,maxe=0;
- float *x_arr=pAGraph->x_vals ; // x values
+ float *x_arr=fnXcopy(pAGraph) ; // x values (only read)
+ if(x_arr==NULL) return; // not enough ram
  float *y_arr=pAGraph->y_vals; // y values
  double a,b,c;     // coefficients of equation
  // void leastsquares_reg3(float *y,float *x,int start, int end,double (*f)(float xparam),double (*g)(float xparam), double *a, double *b, double *c)
@@ -2272,17 +2843,20 @@ void TScientificGraph::fnLinreg_3(int iGraphNumberF, void (*callback)(size_t cnt
 	}
  rprintf("Best fit found is Y=%g*X%+g*sqrt(X)%+g\n",a,b,c);    // %+g always prints sign [+-]
  rprintf("  Max abs error of above curve is %g\n",maxe);
+ fnFreeXcopy(pAGraph,x_arr);
 }
 
 
 void TScientificGraph::fnrat_3(int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt))
 { // fits y=(a+bx)/(1+cx)
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  if(iCount<2) return; // not enough data in graph to process
  unsigned int i;
  double yi,xi,e,maxe=0;
- float *x_arr=pAGraph->x_vals ; // x values
+ float *x_arr=fnXcopy(pAGraph) ; // x values (only read)
+ if(x_arr==NULL) return; // not enough ram
  float *y_arr=pAGraph->y_vals; // y values
  double a,b,c;     // coefficients of equation
  // void leastsquares_rat3(float *y,float *x,int start, int end, double *a, double *b, double *c); /* fits y=(a+bx)/(1+cx) */
@@ -2304,6 +2878,7 @@ void TScientificGraph::fnrat_3(int iGraphNumberF, void (*callback)(size_t cnt,si
 	}
  rprintf("Best fit found is Y=(%g%+g*X)/(1.0%+g*X)\n",a,b,c);    // %+g always prints sign [+-]
  rprintf("  Max abs error of above curve is %g\n",maxe);
+ fnFreeXcopy(pAGraph,x_arr);
 }
 
 void TScientificGraph::fnLinreg(enum LinregType type, int iGraphNumberF, void (*callback)(size_t cnt,size_t maxcnt))
@@ -2312,7 +2887,8 @@ void TScientificGraph::fnLinreg(enum LinregType type, int iGraphNumberF, void (*
  // enum LinregType  {LinLin,LogLin,LinLog,LogLog,RecipLin,LinRecip,RecipRecip,SqrtLin}; defines preprocessing of variables before linear regression 1st is X 2nd is Y
  // results checked using csvfun3.csv. R^2 values (and coefficients) also checked against Excel for the fits excel can do.
 {// to save copying data this is done inline
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  double meanx=0,meany=0; /* initial values set to mean that N=0 or N=1 do not need to be treated as special cases below */
  double meanx2=0,meanxy=0,meany2=0; /* mean x^2 , mean x*y and mean y^2 */
@@ -2324,7 +2900,7 @@ void TScientificGraph::fnLinreg(enum LinregType type, int iGraphNumberF, void (*
  if(iCount<2) return; // not enough data in graph to process
  for(i=0;i<iCount;++i) /* only use 1 pass here - to calculate means directly */
 		{
-		 xi=pAGraph->x_vals[i];
+		 xi=fnXval(pAGraph,i);
 		 yi=pAGraph->y_vals[i];
 		 // apply "preprocessing"
 		 if(type== LogLin || type== LogLog)
@@ -2440,7 +3016,7 @@ void TScientificGraph::fnLinreg(enum LinregType type, int iGraphNumberF, void (*
  // now put new y values back, calculated as y=m*x+c
  for(i=0;i<iCount;++i)
 	{yi=pAGraph->y_vals[i];
-	 xi=pAGraph->x_vals[i];
+	 xi=fnXval(pAGraph,i);
 	 try{ // code below has tests for common issues, but use try to catch anything else
 	  switch(type)
 		{ // enum LinregType  {LinLin,LogLin,LinLog,LogLog,RecipLin,LinRecip,RecipRecip,SqrtLin};
@@ -2508,7 +3084,8 @@ bool TScientificGraph::fnPolyreg(unsigned int order,int iGraphNumberF, void (*ca
 	//  - uses "symbolic execution" to get coefficients for conventional polynomial
 	// returns true if works, false if an issue found
 {
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return false; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  double x,y;  // need to be double as we scale floats
  long double divisor,previous;
@@ -2531,8 +3108,8 @@ bool TScientificGraph::fnPolyreg(unsigned int order,int iGraphNumberF, void (*ca
 	{order=(unsigned int)(iCount>>1); // imperical observation is order > 1/2 total number of points then bad things happen numerically, so trap that here
 	}
  try{ /* the code below may fail if given a high enough order so trap that here */
-	minx=pAGraph->x_vals[0];   // xvalues are sorted into order
-	maxx=pAGraph->x_vals[iCount-1];
+	minx=fnXval(pAGraph,0);   // xvalues are sorted into order
+	maxx=fnXval(pAGraph,iCount-1);
 	miny=maxy=pAGraph->y_vals[0];
 	for(i=0;i<iCount;++i)
 		{y=pAGraph->y_vals[i];
@@ -2564,7 +3141,7 @@ bool TScientificGraph::fnPolyreg(unsigned int order,int iGraphNumberF, void (*ca
 		 if(callback!=NULL)
 			(*callback)(j,order+1); // update on progress
 		 for(i=0;i<iCount;++i)
-			{x=pAGraph->x_vals[i];
+			{x=fnXval(pAGraph,i);
 			 y=pAGraph->y_vals[i];
 			 // scale x,y
 			 x=x*xm+xc;
@@ -2585,7 +3162,7 @@ bool TScientificGraph::fnPolyreg(unsigned int order,int iGraphNumberF, void (*ca
 			{previous=divisor;
 			 divisor=0;
 			 for(i=0;i<iCount;++i) // calculate orthogonal polynomials for next order
-				{x=pAGraph->x_vals[i];
+				{x=fnXval(pAGraph,i);
 				 // scale x
 				 x=x*xm+xc;
 				 pv=0;
@@ -2684,7 +3261,7 @@ bool TScientificGraph::fnPolyreg(unsigned int order,int iGraphNumberF, void (*ca
  double maxe=0,maxep=0;  // max abs error found between poly approximation and original data points
  long double meane2=0,meane2p=0;  // mean (error^2)
  for(i=0;i<iCount;++i)
-	{x= pAGraph->x_vals[i];
+	{x= fnXval(pAGraph,i);
 	 y= pAGraph->y_vals[i];
 	 if(horner_poly)
 		{
@@ -2748,7 +3325,8 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
  // if dBV is true returns result in dBV (ie 20*log10(magnitude))
  // if Window is true use a Nuttall Fig 12 Window
  //  Note we still need to create a copy for rin as its size can be larger than y_vals[]
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return false; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  double x,y;
  float lastx,xmin,xmax,xinc_min,xinc_max;
@@ -2761,6 +3339,11 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
  kiss_fft_scalar *rin;
  kiss_fft_cpx *sout;
  if(iCount<=2) return false; // need more than 2 points to be able to do an fft
+ bool implicit_x=pAGraph->x_vals==NULL; // if x values are implicit the frequencies (which are evenly spaced) can be too
+ if(!implicit_x && !fnPrivateX(pAGraph))
+	{rprintf("Sorry- not enough ram for FFT\n"); // x values are changed to frequencies, so need a copy if they are shared with other traces
+	 return false;
+	}
  rin=(kiss_fft_scalar *)calloc(nfft+2,sizeof(kiss_fft_scalar)); // kiss_fft_scalar is float by default
  sout=(kiss_fft_cpx *)calloc(nfft,sizeof(kiss_fft_cpx));     // output is complex
  if(sout==NULL)
@@ -2778,16 +3361,16 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
 	 return false;
 	}
   // get "stats" from input data
-  lastx=xmin= pAGraph->x_vals[0]; // x values are sorted
-  xmax=pAGraph->x_vals[iCount-1];
-  xinc=pAGraph->x_vals[1] -xmin;
+  lastx=xmin= fnXval(pAGraph,0); // x values are sorted
+  xmax=fnXval(pAGraph,iCount-1);
+  xinc=fnXval(pAGraph,1) -xmin;
   xinc_min=xinc_max=(float)xinc;
   xinc_av=xinc;
   y_av=pAGraph->y_vals[0];
   y2_av=y_av*y_av;
   for (i=1;i<iCount;++i)
 	{
-	 x=pAGraph->x_vals[i];
+	 x=fnXval(pAGraph,i);
 	 y=pAGraph->y_vals[i];
 	 xinc=x-lastx;
 	 if(xinc>xinc_max) xinc_max=(float)xinc;
@@ -2797,6 +3380,7 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
 	 y2_av+=(y*y-y2_av)/(double)(i+1);
 	 lastx=(float)x;
 	}
+  if(implicit_x) xinc_av=pAGraph->x_step; // exact value
   freq_step=(1.0/xinc_av)/nfft; //  1/xinc_av = max freq so divide by nfft to get step
   rprintf("fft(nfft=%u,iCount=%u): xsteps from %g to %g average %g secs so frequency step after fft=%g Hz.\n y average=%g, rms=%g\n",nfft,iCount,xinc_min,xinc_max,xinc_av,freq_step,y_av,(double)sqrt(y2_av));
   if(callback!=NULL)
@@ -2891,7 +3475,11 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
 		 y=20*log10(y);// convert result to dBV
 		}
 	 pAGraph->y_vals[i]=(float)y;  // |result|
-	 pAGraph->x_vals[i]=(float)freq; // freq in Hz, starting at DC
+	 if(!implicit_x) pAGraph->x_vals[i]=(float)freq; // freq in Hz, starting at DC
+	}
+ if(implicit_x)
+	{pAGraph->x_start=0; // freq in Hz, starting at DC
+	 pAGraph->x_step=freq_step;
 	}
  free(rin);    // free up dynamic memory used
  free(sout);
@@ -2900,7 +3488,8 @@ bool TScientificGraph::fnFFT(bool dBV_result,bool Window,int iGraphNumberF, void
  if((nfft/2)+1<iCount)
 	{
 	 pAGraph->nos_vals=(nfft/2)+1; // shrink array to number of values put back (this does NOT actually change size of arrays).
-	 pAGraph->x_vals=(float *)realloc(pAGraph->x_vals,sizeof(float)*pAGraph->nos_vals);  // resize arrays
+	 if(!implicit_x)
+		pAGraph->x_vals=(float *)realloc(pAGraph->x_vals,sizeof(float)*pAGraph->nos_vals);  // resize arrays
 	 pAGraph->y_vals=(float *)realloc(pAGraph->y_vals,sizeof(float)*pAGraph->nos_vals);
 	 pAGraph->size_vals_arrays =pAGraph->nos_vals; // new size of arrays
 	}
@@ -2923,7 +3512,8 @@ bool TScientificGraph::fnCepstrum(int iGraphNumberF, void (*callback)(size_t cnt
  //  Note we still need to create a copy for rin as its size can be larger than y_vals[]
 
 
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return false; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  double x,y;
  double y_av;
@@ -3059,7 +3649,8 @@ bool TScientificGraph::fnCepstrum(int iGraphNumberF, void (*callback)(size_t cnt
  if((nfft/2)+1<iCount)
 	{
 	 pAGraph->nos_vals=(nfft/2)+1; // shrink array to number of values put back (this does NOT actually change size of arrays).
-	 pAGraph->x_vals=(float *)realloc(pAGraph->x_vals,sizeof(float)*pAGraph->nos_vals);  // resize arrays
+	 if(pAGraph->pSharedX==NULL && pAGraph->x_vals!=NULL) // x values are unchanged, so shared (or implicit) x values can stay as they are
+		pAGraph->x_vals=(float *)realloc(pAGraph->x_vals,sizeof(float)*pAGraph->nos_vals);  // resize arrays
 	 pAGraph->y_vals=(float *)realloc(pAGraph->y_vals,sizeof(float)*pAGraph->nos_vals);
 	 pAGraph->size_vals_arrays =pAGraph->nos_vals; // new size of arrays
 	}
@@ -3073,11 +3664,16 @@ void TScientificGraph::compress_y(int iGraphNumberF) // compress by deleting poi
  // makes just 1 pass over the array of points, with 2 pointers i (to the item being tested) and j (j<=i) where items will be moved to (current end of compressed list)
  // at end items >=j need to be deleted (that is done at the end of this function)
  double lasty,lastx,x,y;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  size_t i,j;
  bool skipy=false; // set to true while we are skipping equal y values
  if(iCount<2) return; // not enough data in graph to process
+ if(!fnPrivateX(pAGraph))
+	{rprintf("compress_y: Not enough ram for a copy of the x values - trace not compressed\n");
+	 return;
+	}
  y=lasty=pAGraph->y_vals[0];
  x=lastx=pAGraph->x_vals[0];
  for (i=j=1; i<iCount; i++)  // for all items in list except 1st, i is where we read from, j is where we write to
@@ -3125,11 +3721,16 @@ void TScientificGraph::fix_dupx(int iGraphNumberF) // if we have duplicate x val
  // ordering decisions must give consistent results between traces (we might save the traces as a csv file)
  // This code does NOT achieve this (it can delete sets of x values and re-order the remainder) - so this code is **** NOT **** currently used
  double x,y,miny=0,maxy=0;
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  size_t i,j;
  bool skipx=false; // set to true while we are skipping equal x values
  if(iCount<2) return; // not enough data in graph to process
+ if(!fnPrivateX(pAGraph))
+	{rprintf("fix_dupx: Not enough ram for a copy of the x values - duplicate x values not changed\n");
+	 return;
+	}
 
  for (j=0,i=0; i<iCount; i++)  // for all items in list, i is where we read from, j is where we write to
 		{
@@ -3204,11 +3805,22 @@ void TScientificGraph::fix_dupx(int iGraphNumberF) // if we have duplicate x val
 
 void TScientificGraph::sortx( int iGraphNumberF) // sort ordered on x values  (makes x values increasing)
 {
- SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ SGraph *pAGraph = fnGraphData(iGraphNumberF);
+ if(pAGraph==NULL) return; // not enough RAM to uncompress values
  size_t iCount=pAGraph->nos_vals ;
  time_t start_t=clock();
   /* sort using yasort2() */
-
+ if(pAGraph->x_vals==NULL) return; // implicit x values are always in order
+ size_t i;
+ for(i=1;i<iCount && pAGraph->x_vals[i-1]<=pAGraph->x_vals[i];++i); // check if x values are already in order
+ if(i>=iCount)
+	{rprintf(" sort: x values already in order\n");
+	 return; // nothing to do, and x values can stay shared with other traces
+	}
+ if(!fnPrivateX(pAGraph))
+	{rprintf("sortx: Not enough ram for a copy of the x values - trace not sorted\n");
+	 return;
+	}
  float *xa=pAGraph->x_vals;
  float *ya=pAGraph->y_vals;
  yasort2(xa,ya,iCount);
@@ -3546,7 +4158,9 @@ void TScientificGraph::fnDeleteGraph(int iGraphNumberF)     //deletes graph
 {
   if ((iGraphNumberF<iNumberOfGraphs)&&(iGraphNumberF>=0))
   { SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
-	if(pAGraph->x_vals !=NULL) free(pAGraph->x_vals);    // delete all data points
+	fnFreeScratch(pAGraph); // must be before fnReleaseX() as x_vals may be in a scratch file
+	fnReleaseX(pAGraph);    // delete all data points
+	fnFreeCompressed(pAGraph);
 	if(pAGraph->y_vals !=NULL) free(pAGraph->y_vals);
 	delete (SGraph*) pHistory->Items[iGraphNumberF]; //  delete SGraph structure (see fnAddgraph() below)
     pHistory->Delete(iGraphNumberF); // remove item from list
@@ -3556,7 +4170,8 @@ void TScientificGraph::fnDeleteGraph(int iGraphNumberF)     //deletes graph
 }
 //------------------------------------------------------------------------------
 
-int TScientificGraph::fnAddGraph(size_t max_points)              //insert new graph with nos_points datapoints (at most), return -1 on error
+int TScientificGraph::fnAddGraph(size_t max_points,int iShareXGraph)              //insert new graph with space for max_points datapoints (arrays will grow if more are added), return -1 on error
+ // if iShareXGraph is a valid graph number the x values are shared with that graph, fnAddDataPoint() gives this graph its own copy if its x values turn out to be different
 {
   SGraph *pGraph;
 
@@ -3573,10 +4188,31 @@ int TScientificGraph::fnAddGraph(size_t max_points)              //insert new gr
   pGraph->Caption="";
   pGraph->iTextSize=10;
   // now create space for data points
+  if(max_points<GRAPH_MIN_GROW) max_points=GRAPH_MIN_GROW; // max_points is only an estimate (it may even be 0), arrays grow as required in fnAddDataPoint()
   pGraph->nos_vals=0; // currently no data points
   pGraph->size_vals_arrays=max_points;
-  pGraph->x_vals=(float *)calloc(max_points,sizeof(float));
-  pGraph->y_vals=(float *)calloc(max_points,sizeof(float));
+  pGraph->pSharedX=NULL;
+  pGraph->pComp=NULL;
+  pGraph->pScratch=NULL;
+  pGraph->x_start=pGraph->x_step=0; // only used for implicit x values
+  pGraph->y_vals=(float *)malloc(max_points*sizeof(float)); // no need to zero arrays as only the first nos_vals values are ever used
+  if(pGraph->y_vals!=NULL && iShareXGraph>=0 && iShareXGraph<iNumberOfGraphs && ((SGraph*) pHistory->Items[iShareXGraph])->x_vals!=NULL &&
+	 (((SGraph*) pHistory->Items[iShareXGraph])->pScratch==NULL || ((SGraph*) pHistory->Items[iShareXGraph])->pScratch->x==NULL)) // x values in a scratch file cannot be shared
+	{SGraph *pXGraph = ((SGraph*) pHistory->Items[iShareXGraph]);
+	 if(pXGraph->pSharedX==NULL)
+		{// x values currently belong just to pXGraph, make them shareable
+		 pXGraph->pSharedX=new SSharedX;
+		 pXGraph->pSharedX->x_vals=pXGraph->x_vals;
+		 pXGraph->pSharedX->size_x_vals=pXGraph->size_vals_arrays;
+		 pXGraph->pSharedX->nos_vals=pXGraph->nos_vals;
+		 pXGraph->pSharedX->refs=1;
+		}
+	 pGraph->pSharedX=pXGraph->pSharedX;
+	 pGraph->pSharedX->refs++;
+	 pGraph->x_vals=pGraph->pSharedX->x_vals;
+	}
+  else
+	pGraph->x_vals=(float *)malloc(max_points*sizeof(float));
   if(pGraph->y_vals==NULL && pGraph->x_vals!=NULL)
 	{ // out of space, but x_vals allocated ok
 	 free(pGraph->x_vals);
@@ -3585,6 +4221,7 @@ int TScientificGraph::fnAddGraph(size_t max_points)              //insert new gr
   if(pGraph->x_vals==NULL)
 	{pGraph->size_vals_arrays=0; // no space allocated
 	 rprintf(" Warning: not enought ram for %.0f datapoints\n",(double)max_points);
+	 delete pGraph;
 	 return -1; // error
 	}
   pHistory->Add(pGraph);                       //add to history
@@ -3661,24 +4298,57 @@ void TScientificGraph::fnAutoScale()
 	aGraph=(SGraph*) pHistory->Items[i];
 	if(aGraph->nos_vals==0) continue; // if no values for this graph skip further processing
  /* know x values are sorted so can move finding xmin/max outside of the loop for speed */
-	if (aGraph->x_vals[0]<dXMin)
-		{dXMin=aGraph->x_vals[0];
+	if (fnXval(aGraph,0)<dXMin)
+		{dXMin=fnXval(aGraph,0);
         }
-	if (aGraph->x_vals[aGraph->nos_vals-1]>dXMax)
-		{dXMax=aGraph->x_vals[aGraph->nos_vals-1];
+	if (fnXval(aGraph,aGraph->nos_vals-1)>dXMax)
+		{dXMax=fnXval(aGraph,aGraph->nos_vals-1);
         }
+	if(aGraph->pComp!=NULL && aGraph->pComp->y!=NULL)
+		{// compressed y values, the block headers hold the min/max values so there is no need to decode them
+		 fc_array *pY=aGraph->pComp->y;
+		 for (j=0; j<fc_nos_blocks(pY); j++)
+			{const fc_block *pBlock=fc_block_info(pY,j);
+			 if (pBlock->min<dYMin)
+				{dYMin=pBlock->min;
+				 min_graph=i;
+				 X_for_minY= fnXval(aGraph,j*FC_BLOCK_SIZE+pBlock->min_i);
+				}
+			 if (pBlock->max>dYMax)
+				{dYMax=pBlock->max;
+				 max_graph=i;
+				 X_for_maxY= fnXval(aGraph,j*FC_BLOCK_SIZE+pBlock->max_i);
+				}
+			}
+		 continue;
+		}
+	if(aGraph->pScratch!=NULL && aGraph->pScratch->y!=NULL)
+		{// y values in a scratch file, min/max values were found when they were moved there so there is no need to read them all again
+		 SScratch *pScratch=aGraph->pScratch;
+		 if (pScratch->y_min<dYMin)
+			{dYMin=pScratch->y_min;
+			 min_graph=i;
+			 X_for_minY= fnXval(aGraph,pScratch->y_min_i);
+			}
+		 if (pScratch->y_max>dYMax)
+			{dYMax=pScratch->y_max;
+			 max_graph=i;
+			 X_for_maxY= fnXval(aGraph,pScratch->y_max_i);
+			}
+		 continue;
+		}
 	// now loop over all elemnts to find y min/max
 	for (j=0; j<aGraph->nos_vals; j++)
 	{ float y=aGraph->y_vals[j];
 	  if (y<dYMin)
         {dYMin=y;
          min_graph=i;
-		 X_for_minY= aGraph->x_vals[j];
+		 X_for_minY= fnXval(aGraph,j);
 		}
       if (y>dYMax)
         {dYMax=y;
 		 max_graph=i;
-		 X_for_maxY= aGraph->x_vals[j];
+		 X_for_maxY= fnXval(aGraph,j);
         }
 	}
   }
@@ -3711,6 +4381,20 @@ size_t TScientificGraph::fnGetNumberOfDataPoints(int iGraphNumberF)
 {if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return 0; // invalid graph number
  return ((SGraph*) pHistory->Items[iGraphNumberF])->nos_vals ;
 }
+
+float TScientificGraph::fnGetXval(size_t i,int iGraphNumberF) // returns x value i of graph without changing how its values are stored, 0 if i is invalid
+{if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return 0; // invalid graph number
+ SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ if(i>=pAGraph->nos_vals) return 0;
+ return fnXval(pAGraph,i);
+}
+
+float TScientificGraph::fnGetYval(size_t i,int iGraphNumberF) // returns y value i of graph without changing how its values are stored, 0 if i is invalid
+{if(iGraphNumberF<0 || iGraphNumberF >=iNumberOfGraphs) return 0; // invalid graph number
+ SGraph *pAGraph = ((SGraph*) pHistory->Items[iGraphNumberF]);
+ if(i>=pAGraph->nos_vals) return 0;
+ return fnYval(pAGraph,i);
+}
 //------------------------------------------------------------------------------
 double TScientificGraph::fnGetDataPointYValue(size_t iChannelF,
 												   int iGraphNumberF)
@@ -3718,7 +4402,7 @@ double TScientificGraph::fnGetDataPointYValue(size_t iChannelF,
   if ((pHistory->Count-1)>=iGraphNumberF && iGraphNumberF>=0)
   { aGraph=(SGraph*) pHistory->Items[iGraphNumberF];
 	if(aGraph->nos_vals-1 >=iChannelF)
-		{return aGraph->x_vals[iChannelF];
+		{return fnXval(aGraph,iChannelF);
 		}
   }
   return 0; // default value on error
@@ -4017,20 +4701,20 @@ bool TScientificGraph::SaveCSV(char *filename,char *x_axis_name, double xmin, do
 		 Form1->pPlotWindow->StatusText->Caption=cstr;
 		 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
 		}
-	  xj= xGraph->x_vals[j];
+	  xj= fnXval(xGraph,j);
 	  if(xj<xmin || xj>xmax) continue; // outside of range to save
 	  lp=lbuf; // line pointer/buffer
 	  lp=ya_shortf(lp,xj); // x value
 	  for (int i=0; i<iNumberOfGraphs; i++)  // now print y values for all traces
 		{aGraph=(SGraph*) pHistory->Items[i];
 		*lp++=','; // comma before each value
-		 if(i==0)  lp=ya_shortf(lp,aGraph->y_vals[j]); // trace 0: can always just print 1st y value as that trace provides x values
-		 else if(j<aGraph->nos_vals && aGraph->x_vals[j]==xj)
-			lp=ya_shortf(lp,aGraph->y_vals[j]);// if x value matches trace 0 then just print matching y value (this is faster than always interpolating)
+		 if(i==0)  lp=ya_shortf(lp,fnYval(aGraph,j)); // trace 0: can always just print 1st y value as that trace provides x values
+		 else if(j<aGraph->nos_vals && fnXval(aGraph,j)==xj)
+			lp=ya_shortf(lp,fnYval(aGraph,j));// if x value matches trace 0 then just print matching y value (this is faster than always interpolating)
 		 else
 			{// need to interpolate to get correct y value
 			 // float interp1D(float *xa, float *ya, int size, float x, bool clip);
-			 float yj=interp1D_f(aGraph->x_vals,aGraph->y_vals,aGraph->nos_vals,xj,true);
+			 float yj=fnInterpY(aGraph,xj,true);
 			 lp=ya_shortf(lp,yj); // interpolated value
 			}
 		}
@@ -4052,7 +4736,7 @@ bool TScientificGraph::SaveCSV(char *filename,char *x_axis_name, double xmin, do
 		 Form1->pPlotWindow->StatusText->Caption=cstr;
 		 Application->ProcessMessages(); /* allow windows to update (but not go idle) */
 		}
-	  xj= xGraph->x_vals[j];
+	  xj= fnXval(xGraph,j);
 	  if(xj<xmin || xj>xmax) continue; // outside of range to save
 	  if(roundf(xj)==xj && xj>=-100000000 && xj<=100000000 )
 		{// x value is an integer with a reasonable number of sf - print it as such
@@ -4062,13 +4746,13 @@ bool TScientificGraph::SaveCSV(char *filename,char *x_axis_name, double xmin, do
 		fprintf(fp,"%.7g",xj);    // printf x value first. %.9g (9sf) gives max resolution for a float    27/8/2025 changed to %.7g as 7sf is abs max for float as 2^24=16,777,216  (8sf starts introducing round loop errors)
 	  for (int i=0; i<iNumberOfGraphs; i++)  // now print y values for all traces
 		{aGraph=(SGraph*) pHistory->Items[i];
-		 if(i==0)  fprintf(fp,",%.7g",aGraph->y_vals[j]); // trace 0: can always just print 1st y value as that trace provides x values
-		 else if(j<aGraph->nos_vals && aGraph->x_vals[j]==xj)
-			fprintf(fp,",%.7g",aGraph->y_vals[j]);// if x value matches trace 0 then just print matching y value (this is faster than always interpolating)
+		 if(i==0)  fprintf(fp,",%.7g",fnYval(aGraph,j)); // trace 0: can always just print 1st y value as that trace provides x values
+		 else if(j<aGraph->nos_vals && fnXval(aGraph,j)==xj)
+			fprintf(fp,",%.7g",fnYval(aGraph,j));// if x value matches trace 0 then just print matching y value (this is faster than always interpolating)
 		 else
 			{// need to interpolate to get correct y value
 			 // float interp1D(float *xa, float *ya, int size, float x, bool clip);
-			 float yj=interp1D_f(aGraph->x_vals,aGraph->y_vals,aGraph->nos_vals,xj,true);
+			 float yj=fnInterpY(aGraph,xj,true);
 			 fprintf(fp,",%.7g",yj); // interpolated value
 			}
 		}
@@ -7,10 +7,14 @@
 #define UScientificGraphH
 
 #include <Graphics.hpp>
+#include "float-compress.h"
+#include "scratch-file.h"
 // #define CHECK_DEPTH /* if defined check depth of recursion in myqsort() */
 
 enum LinregType  {LinLin,LinLin_GMR,LogLin,LinLog,LogLog,RecipLin,LinRecip,RecipRecip,SqrtLin,Nlog2nLin};
 
+#define GRAPH_MIN_GROW 65536 /* min number of points that arrays for a graph grow by when they are full */
+#define SCRATCH_MIN_POINTS (16*GRAPH_MIN_GROW) /* if scratch files are being used, graphs are moved into them when this many points have been added */
 // class for scientific plots
 
 class TScientificGraph
@@ -25,11 +29,39 @@ protected:
     double dMax;
   };
 
+  struct SSharedX                     // x values shared by several graphs (eg traces read from the same csv file)
+  {
+	float *x_vals;                    // x values
+	size_t size_x_vals;               // actual size of x_vals array (in floats)
+	size_t nos_vals;                  // how many items currently in x_vals array (the most used by any of the graphs sharing it)
+	int refs;                         // number of graphs using these x values
+  };
+
+  struct SCompressed                  // compressed x and/or y values of a graph (see fnCompress() )
+  {
+	fc_array *x,*y;                   // compressed values (NULL if x_vals/y_vals are not compressed)
+	float *x_block,*y_block;          // last block of values decoded (so values can be read one at a time without decoding a whole block for each one)
+	size_t x_blockn,y_blockn;         // which block is in x_block/y_block, (size_t)-1 if none
+  };
+
+  struct SScratch                     // x and/or y values of a graph held in memory mapped scratch files (see fnToScratch() )
+  {
+	scratch_file *x,*y;               // NULL if x_vals/y_vals are not in a scratch file (otherwise x_vals/y_vals point to the values in the mapped file)
+	unsigned int last_used;           // value of uScratchClock when values were last used, the least recently used graphs are removed from RAM first
+	bool in_ram;                      // true if values may be in RAM (they have been used since they were last removed from RAM)
+	float y_min,y_max;                // min and max y values (found when values were moved to scratch files and updated as points are added, so fnAutoScale() does not need to read them all)
+	size_t y_min_i,y_max_i;           // index of 1st min and max y values
+  };
+
   struct SGraph                       //structure for single graph
   {
-	float *x_vals;                    // x values for this graph
-	float *y_vals;                    // y values for this graph
-	size_t size_vals_arrays;    // actual size of above arrays (in floats)
+	float *x_vals;                    // x values for this graph (pSharedX->x_vals if x values are shared, NULL if x values are implicit or compressed)
+	SSharedX *pSharedX;               // NULL if x_vals belongs only to this graph
+	double x_start,x_step;            // if x_vals is NULL (and x values are not compressed) x value i is (float)(x_start+i*x_step) - see fnImplicitX()
+	float *y_vals;                    // y values for this graph (NULL if y values are compressed)
+	SCompressed *pComp;               // NULL if values are not compressed
+	SScratch *pScratch;               // NULL if values are not in scratch files
+	size_t size_vals_arrays;    // actual size of above arrays (in floats), for shared x values this is just the size of y_vals
 	size_t nos_vals;            // how many items currently in x/y_vals arrays
     TColor ColDataPoint;              //color data points
     TColor ColErrorBar;               //color error bars
@@ -58,6 +90,7 @@ protected:
   int iNumberOfGraphs;                //number of initialized graphs
 
   TList *pHistory;                    //container for graphs
+  unsigned int uScratchClock;         // incremented each time values in scratch files are used (see fnScratchUse() )
 
   SInterval sSizeX;                   //Scales
   SInterval sSizeY;
@@ -78,6 +111,34 @@ protected:
   void fnPaintTickX(double dADoub, double dScaling);
   void fnPaintTickY(double dADoub, double dScaling);
   void fnPaintDataPoint(TRect Rect, unsigned char ucStyle);  //paints data point
+  bool fnGrowGraph(SGraph *pAGraph);  // make arrays for graph bigger, returns false if out of RAM
+  bool fnResizeArray(SGraph *pAGraph,bool x,size_t n); // change size of x or y values array of graph (in RAM or in a scratch file), returns false if out of RAM or disk space
+  bool fnGrowSharedX(SSharedX *pShared); // make shared x values array bigger, returns false if out of RAM
+  void fnMovedSharedX(SSharedX *pShared); // update x_vals of all graphs using pShared after its array has been reallocated
+  bool fnPrivateX(SGraph *pAGraph);   // give graph its own copy of its x values (if they are shared) so they can be changed, returns false if out of RAM
+  void fnReleaseX(SGraph *pAGraph);   // free x values of graph (or its reference to shared x values)
+  float *fnXarray(SGraph *pAGraph);   // returns x_vals, creating it first if x values are implicit. Returns NULL if out of RAM
+  float *fnXcopy(SGraph *pAGraph);    // returns x values to be read: x_vals, or a temporary copy if x values are implicit (so they stay implicit). Returns NULL if out of RAM
+  void fnFreeXcopy(SGraph *pAGraph,float *x); // free array returned by fnXcopy()
+  void fnSG_filter(SGraph *pAGraph,float *newy,double (*fn)(float *y,float *x,size_t start,size_t end,size_t index,unsigned int order),unsigned int order); // newy[i]=fn() (a Savitzky Golay function) for all points, without needing an array of x values
+  float fnXval(SGraph *pAGraph,size_t i) // returns x value i of graph (works for implicit and compressed x values)
+	{return pAGraph->x_vals!=NULL ? pAGraph->x_vals[i] : (pAGraph->pComp!=NULL && pAGraph->pComp->x!=NULL) ? fnCompVal(pAGraph,i,true) : (float)(pAGraph->x_start+(double)i*pAGraph->x_step);}
+  float fnYval(SGraph *pAGraph,size_t i) // returns y value i of graph (works for compressed y values)
+	{return pAGraph->y_vals!=NULL ? pAGraph->y_vals[i] : fnCompVal(pAGraph,i,false);}
+  float fnCompVal(SGraph *pAGraph,size_t i,bool x); // returns value i of compressed x (x=true) or y values
+  size_t fnYBlockBefore(SGraph *pAGraph,size_t i,double x,const fc_block **ppBlock); // if i is the start of a block of compressed y values whose x values are all < x returns number of values in block (and sets *ppBlock to its header), otherwise returns 0
+  bool fnUncompress(SGraph *pAGraph); // expand compressed values back into x_vals/y_vals, returns false if out of RAM
+  void fnFreeCompressed(SGraph *pAGraph); // free compressed values of graph
+  bool fnFromScratch(SGraph *pAGraph); // copy values in scratch files back into RAM (so they can be changed), returns false if out of RAM
+  void fnFreeScratch(SGraph *pAGraph); // close scratch files of graph
+  bool fnMoveToScratch(SGraph *pAGraph); // move values of graph into scratch files, returns true if values are now in scratch files
+  void fnDropScratch(SGraph *pAGraph,bool x); // close scratch file holding x (x=true) or y values of graph once they have been replaced
+  void fnScratchUse(SGraph *pAGraph,size_t start,size_t end); // values start..end-1 of graph are about to be read
+  void fnScratchEvict(SGraph *pKeep); // remove values in scratch files of the least recently used graphs from RAM till the rest fit in scratch_ram_bytes
+  SGraph *fnGraphData(int iGraphNumberF); // returns graph with its values uncompressed and in RAM (so x_vals/y_vals can be used directly and changed), NULL if out of RAM
+  bool fnYData(SGraph *pAGraph); // copy just the y values of graph into RAM (so they can be changed), returns false if out of RAM
+  float fnInterpY(SGraph *pAGraph,float x,bool clip); // y value at x, interpolated if required (as interp1D_f() )
+  size_t fnFindX(SGraph *pAGraph,double key); // returns index of point just before key (or at key if its an exact match)
 
 public:
   Graphics::TBitmap *pBitmap;         //Bitmap
@@ -172,7 +233,13 @@ public:
   void Savitzky_Golay_smoothing(unsigned int s_order,int iGraphNumberF); // Savitzky Golay smoothing
   void Spline_smoothing(double tc,int iGraphNumberF); // Smoothing spline smoothing
   void sortx( int iGraphNumberF); // sort ordered on x values
-  int fnAddGraph(size_t max_points) ;  // create new line for graph with at most max_points
+  int fnAddGraph(size_t max_points,int iShareXGraph=-1) ;  // create new line for graph with space for max_points (an estimate, arrays grow as required), x values are shared with graph iShareXGraph while they are the same (-1 => not shared)
+  void fnShrinkGraph(int iGraphNumberF); // free unused space at the end of the arrays for this graph (use when all points have been added)
+  bool fnImplicitX(int iGraphNumberF); // stop storing x values if they are evenly spaced, returns true if x values are now implicit
+  bool fnCompress(int iGraphNumberF,float y_max_err=0); // compress x and y values of graph to save RAM, y values may change by up to y_max_err (0 => no change). Returns true if graph is now compressed
+  size_t fnGraphBytes(int iGraphNumberF); // returns RAM used by x and y values of graph (shared x values and values in scratch files are not included)
+  bool fnToScratch(int iGraphNumberF); // move x and y values of graph into memory mapped scratch files (see scratch-file.c), returns true if values are now in scratch files
+  size_t scratch_ram_bytes;           // max bytes of values in scratch files to keep in RAM, when more are used the least recently used graphs are removed from RAM
 
   //Scale Functions
   void fnResize();
@@ -202,7 +269,11 @@ public:
 
   //Get functions
   size_t fnGetNumberOfDataPoints(int iGraphNumberF = 0);
-  size_t fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF = 0); // allow access to x and y arrays, returns nos points
+  int fnGetNumberOfGraphs() {return iNumberOfGraphs;}
+  size_t fnGetxyarr(float **x_arr,float **y_arr,int iGraphNumberF = 0); // allow access to x and y arrays (either can be NULL if not needed), returns nos points. y values can be changed, x values are read only
+  void fnFreexarr(float *x_arr,int iGraphNumberF = 0); // free x array returned by fnGetxyarr()
+  float fnGetXval(size_t i,int iGraphNumberF = 0); // read x value i of graph (without copying values into RAM)
+  float fnGetYval(size_t i,int iGraphNumberF = 0); // read y value i of graph (without copying values into RAM)
   double fnGetDataPointYValue(size_t iChannelF, int iGraphNumberF = 0);
   double fnGetScaleXMin() {return sScaleX.dMin;}
   double fnGetScaleXMax() {return sScaleX.dMax;}
@@ -6,6 +6,11 @@
     
 	 The code should be robust to anything thrown at it (lots of leading of trailing zeros, extremely large numbers of digits, etc ).
 	 As well as floating point numbers this also accepts NAN and INF (case does not matter).
+
+	 17/10/2026 - added a fast path for "simple" numbers (eg 123.456 or -1.5e-3) that reads 8 digits at a time (SWAR), and fast_strtof_array() to convert lots of numbers in one call.
+	 17/10/2026 - added fast_strtod() which gives a correctly rounded double (used for x values where the extra resolution is needed before they are offset).
+	 17/10/2026 - fast_strtod() passes hex numbers (eg 0x10) to strtod(), previously it returned 0 for these.
+	 17/10/2026 - added fast_strtof_int() for columns that only hold integers.
  				  
  */   
 // #define AFormatSupport /* if defined then support hex floating point numbers (as created by printf with %A */
@@ -39,6 +44,8 @@
 #include <stdbool.h> /* for bool */
 #include <stdint.h>  /* for int64_t etc */
 #include <math.h>    /* for NAN, INFINITY */
+#include <string.h>  /* for memcpy() */
+#include <float.h>   /* for FLT_EVAL_METHOD */
 //#define NAN (0.0/0.0)
 //define INFINITY (1.0/0.0)
 /* ieee floating point maths limits:
@@ -56,6 +63,9 @@ Also note that 0x0fff ffff ffff ffff =  1,152,921,504,606,846,975  	, so 18 digi
 
 */   					
 float fast_strtof(const char *s,char **endptr); // if endptr != NULL returns 1st character thats not in the number
+void fast_strtof_array(char * const s[],float f[],char *endptr[],size_t n); // f[i]=fast_strtof(s[i],&endptr[i]) for i=0..n-1 (endptr may be NULL)
+double fast_strtod(const char *s,char **endptr); // as strtod() (so correctly rounded) but faster for "simple" numbers
+float fast_strtof_int(const char *s,char **endptr); // as fast_strtof() but faster for integers
 static const int maxfExponent = 38;	/* Largest possible base 10 for a float exponent. (must match array below) */
 static double const dblpowersOf10[] = /* always double */
                 {
@@ -113,6 +123,136 @@ static uint32_t u32powersOf10[]=
 					UINT32_C(100000000),// 8
 					UINT32_C(1000000000),// 9   [ largest possible 10^10 gives compiler error (overflow) ]
 				};
+#if (defined(__clang__) || defined(__GNUC__)) && (defined(__x86_64__) || defined(__i386__)) /* needs a little endian CPU and __builtin_ctzll() */
+ /* fast path for "simple" numbers of the form [+-]digits[.digits][e[+-]digits] with at most 9 significant digits (and at most 7 digits before and after the decimal point).
+	Digits are read 8 at a time using "SIMD within a register" (SWAR) on a uint64, see https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits/
+	Anything else (NAN, INF, leading whitespace, long mantissas, very big or small exponents) is left for the general code in fast_strtof().
+	The result is identical (bit for bit) to that from the general code.
+ */
+#define FAST_STRTOF_SWAR
+static inline int swar_nos_digits(uint64_t x) // x is 8 characters xor'ed with '0's, returns number of leading digits (0..8)
+{uint64_t m=(x | (x+UINT64_C(0x7676767676767676))) & UINT64_C(0x8080808080808080); // top bit of each byte set if its not a digit (carries only go to later bytes, so do not change the 1st non-digit found)
+ if(m==0) return 8;
+ return __builtin_ctzll(m)>>3;
+}
+
+static inline int swar_nos_leading_zeros(uint64_t x,int n) // x is 8 characters xor'ed with '0's, the 1st n of which are digits. returns number of leading '0' characters
+{uint64_t m=(x+UINT64_C(0x7f7f7f7f7f7f7f7f)) & UINT64_C(0x8080808080808080); // top bit of each byte set if its not '0' (will always be 1 bit set as character after last digit is not a digit)
+ int z=__builtin_ctzll(m)>>3;
+ return z<n ? z : n;
+}
+
+static inline uint32_t swar_digits(uint64_t x,int n) // x is 8 characters xor'ed with '0's, the 1st n (1..7) of which are digits. Returns value of digits
+{x<<=8*(8-n); // get rid of characters after the digits, which means we now have 8 digits with leading zeros
+ x=(x*10)+(x>>8); // combine pairs of digits
+ x=(((x & UINT64_C(0x000000FF000000FF))*UINT64_C(0x000F424000000064)) + (((x>>16) & UINT64_C(0x000000FF000000FF))*UINT64_C(0x0000271000000001)))>>32; // then combine these into 8 digits
+ return (uint32_t)x;
+}
+
+static inline bool fast_strtof_simple(const char *s,char **endptr,float *f) // if s is a "simple" number sets *f and *endptr (if not NULL) and returns true, otherwise returns false
+{const char *p=s,*se;
+ bool sign=false,expsign=false;
+ uint64_t x;
+ int n1,n2=0;
+ uint32_t r32;
+ int_fast16_t exp=0,rexp=0,nos_mant_digits;
+ double dr;
+ if(((uintptr_t)s & 4095) > 4096-24) return false; // need to be able to read 24 bytes without crossing a page boundary (as next page might not be readable)
+ if(*p=='-')
+	{sign=true;
+	 ++p;
+	}
+ else if(*p=='+') ++p;
+ memcpy(&x,p,8);
+ x^=UINT64_C(0x3030303030303030); // digits are now 0..9 in each byte
+ n1=swar_nos_digits(x);
+ if(n1==8) return false; // too many digits for this function
+ r32= n1==0 ? 0 : swar_digits(x,n1);
+ nos_mant_digits=(int_fast16_t)(n1-swar_nos_leading_zeros(x,n1)); // leading zeros are not counted
+ p+=n1;
+ if(*p=='.')
+	{++p;
+	 memcpy(&x,p,8);
+	 x^=UINT64_C(0x3030303030303030);
+	 n2=swar_nos_digits(x);
+	 if(n2==8) return false; // too many digits for this function
+	 if(n2>0)
+		{if(r32==0)
+			nos_mant_digits=(int_fast16_t)(n2-swar_nos_leading_zeros(x,n2)); // number is zero so far, so leading zeros in fractional bit of mantissa are not counted either
+		 else
+			nos_mant_digits+=n2;
+		 if(nos_mant_digits>9) return false; // too many digits for a uint32
+		 r32=r32*u32powersOf10[n2]+swar_digits(x,n2);
+		 exp=(int_fast16_t)(-n2);
+		 p+=n2;
+		}
+	}
+ if(n1==0 && n2==0) return false; // not a number, let general code deal with this
+ se=p; // end of a valid mantissa
+ if(*p=='e' || *p=='E')
+	{// have exponent, optional sign is 1st
+	 ++p ; // skip 'e'
+	 if(*p=='+') ++p;
+	 else if(*p=='-')
+		{expsign=true;
+		 ++p;
+		}
+	 while(isdigit(*p))
+		{if(rexp<=2*maxfExponent)
+		   rexp=rexp*10+(int_fast16_t)(*p - '0');  // if statement clips at a value that will result in +/-inf but will not overflow int
+		 ++p;
+		 se=p; // update to reflect end of a valid exponent (e[+-]digit+)
+		}
+	}
+ if(expsign) rexp=(-rexp);
+ rexp+=exp; // add in correct to exponent from mantissa processing
+ if(rexp>2*maxfExponent || rexp< -2*maxfExponent) return false; // leave silly exponents to the general code
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+ if(endptr!=NULL) *endptr=(char *)se;
+#pragma GCC diagnostic pop
+ /* from here on this is the same calculation as at the end of fast_strtof() when the mantissa fits in a uint32 */
+ if(rexp>0 && rexp+nos_mant_digits<=9)
+	{// can do all calculations using uint32 which is exact and fast
+	 r32*=u32powersOf10[rexp];
+	 *f= sign ? -((float)r32) : (float)r32;
+	 return true;
+	}
+ if(rexp<0 && rexp >= -7 && nos_mant_digits<=7 )
+	{// float is exact here
+	 *f= sign ? -((float)r32/fltpowersOf10[-rexp]) : (float)r32/fltpowersOf10[-rexp];
+	 return true;
+	}
+ if(rexp>0)
+	{if(rexp>maxfExponent)
+		{*f= sign ? -INFINITY : INFINITY; // we have defininaly overflowed
+		 return true;
+		}
+	 dr=(double)r32*dblpowersOf10[rexp];
+	}
+ else if(rexp<0)
+	{rexp=( -rexp);
+	 exp=rexp;
+	 if(rexp>maxfExponent)
+		{rexp=maxfExponent;
+		 exp-=maxfExponent; // any excess which we will also need to divide by (if its > 0)
+		}
+	 else exp=0;
+	 dr=(double)r32/dblpowersOf10[rexp];
+	 if(exp>0)
+		dr/=dblpowersOf10[exp];
+	}
+ else
+	{// rexp==0
+	 *f= sign ? -((float)r32) : (float)r32;
+	 return true;
+	}
+ if(sign) dr= -dr;
+ *f=(float)dr;
+ return true;
+}
+#endif
+
 /*
  *----------------------------------------------------------------------
  *
@@ -152,6 +292,11 @@ float fast_strtof(const char *s,char **endptr) // if endptr != NULL returns 1st
 #ifdef DEBUG
   fprintf(stderr,"strtof(%s):\n",s);
 #endif    
+#ifdef FAST_STRTOF_SWAR
+  {float f;
+   if(fast_strtof_simple(s,endptr,&f)) return f; // quick path for "simple" numbers
+  }
+#endif
   while(isspace(*s)) ++s; // skip initial whitespace	
   // deal with leading sign
   if(*s=='+') ++s;
@@ -401,5 +546,115 @@ float fast_strtof(const char *s,char **endptr) // if endptr != NULL returns 1st
 }
 #pragma GCC diagnostic pop
 
+void fast_strtof_array(char * const s[],float f[],char *endptr[],size_t n) // f[i]=fast_strtof(s[i],&endptr[i]) for i=0..n-1 (endptr may be NULL)
+{for(size_t i=0;i<n;++i)
+	f[i]=fast_strtof(s[i],endptr==NULL ? NULL : &endptr[i]);
+}
 
+/* fast_strtof_int() - used for columns that only contained integers when the file was opened.
+   An integer of up to 9 digits (with an optional sign) fits in a uint32 which is converted to a float with a single rounding, so this gives the same result as fast_strtof().
+   Anything else (including leading whitespace, a decimal point, an exponent or more digits) is converted by fast_strtof(), so it is always safe to use this.
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+float fast_strtof_int(const char *s,char **endptr) // as fast_strtof() but faster for integers
+{const char *p=s;
+ bool sign=false;
+ uint32_t r=0;
+ int nos_digits=0;
+ if(*p=='-')
+	{sign=true;
+	 ++p;
+	}
+ else if(*p=='+') ++p;
+ while((unsigned)(*p-'0')<10 && nos_digits<9)
+	{r=r*10+(uint32_t)(*p++ -'0');
+	 ++nos_digits;
+	}
+ if(nos_digits==0 || (unsigned)(*p-'0')<10 || *p=='.' || *p=='e' || *p=='E')
+	return fast_strtof(s,endptr); // not an integer with at most 9 digits
+ if(endptr!=NULL) *endptr=(char *)p;
+ return sign ? -(float)r : (float)r;
+}
+#pragma GCC diagnostic pop
 
+/* fast_strtod() - correctly rounded conversion of a string to a double.
+   Numbers of the form [+-]digits[.digits][e[+-]digits] with at most 19 significant digits are converted directly when the result is guaranteed to be exact:
+	- an integer is converted via an int64 (so there is only 1 rounding), this includes nanosecond counters (19 digits)
+	- if the mantissa fits in 53 bits and the power of 10 is at most 22 then both are exact doubles, so a single multiply or divide gives a correctly rounded result (Clinger's fast path).
+	  This needs double maths to be done as double (FLT_EVAL_METHOD==0) as rounding to long double 1st could give a different answer.
+   Anything else (NAN, INF, hex numbers eg 0x10, more digits, bigger exponents) is converted by strtod().
+*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+double fast_strtod(const char *s,char **endptr) // as strtod() (so correctly rounded) but faster for "simple" numbers
+{const char *p=s,*se;
+ bool sign=false,expsign=false,got_digits=false;
+ uint64_t m=0; // mantissa
+ int nos_digits=0; // significant digits in m
+ int exp=0,rexp=0;
+ double d;
+ while(isspace(*p)) ++p; // skip initial whitespace
+ if(*p=='-')
+	{sign=true;
+	 ++p;
+	}
+ else if(*p=='+') ++p;
+ if(p[0]=='0' && (p[1]=='x' || p[1]=='X')) return strtod(s,endptr); // hex number (otherwise the leading 0 would be read as a number on its own)
+ while(*p=='0')
+	{++p; // leading zeros are not significant
+	 got_digits=true;
+	}
+ while(isdigit(*p))
+	{if(nos_digits>=19) return strtod(s,endptr); // too many digits for a uint64
+	 m=m*10+(uint64_t)(*p++ -'0');
+	 ++nos_digits;
+	 got_digits=true;
+	}
+ if(*p=='.')
+	{++p;
+	 if(nos_digits==0)
+		while(*p=='0')
+			{++p; // leading zeros after the decimal point are not significant either
+			 --exp;
+			 got_digits=true;
+			}
+	 while(isdigit(*p))
+		{if(nos_digits>=19) return strtod(s,endptr);
+		 m=m*10+(uint64_t)(*p++ -'0');
+		 ++nos_digits;
+		 --exp;
+		 got_digits=true;
+		}
+	}
+ if(!got_digits) return strtod(s,endptr); // not a simple number (eg NAN or INF)
+ se=p; // end of a valid mantissa
+ if(*p=='e' || *p=='E')
+	{++p;
+	 if(*p=='-')
+		{expsign=true;
+		 ++p;
+		}
+	 else if(*p=='+') ++p;
+	 while(isdigit(*p))
+		{if(rexp<10000) rexp=rexp*10+(*p-'0'); // clip so a silly exponent does not overflow an int
+		 ++p;
+		 se=p; // exponent is only valid if it has at least 1 digit
+		}
+	 if(se!=p) rexp=0; // no digits after e, so "e" is not part of the number
+	}
+ exp+= expsign ? -rexp : rexp;
+ if(m==0)
+	d=0.0;
+ else if(exp==0 && m<=(uint64_t)INT64_MAX)
+	d=(double)(int64_t)m; // integer
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD==0
+ else if(m<=(UINT64_C(1)<<53) && exp>=-22 && exp<=22)
+	d= exp<0 ? (double)m/dblpowersOf10[-exp] : (double)m*dblpowersOf10[exp];
+#endif
+ else
+	return strtod(s,endptr);
+ if(endptr!=NULL) *endptr=(char *)se;
+ return sign ? -d : d;
+}
+#pragma GCC diagnostic pop
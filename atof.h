@@ -35,10 +35,14 @@
  *--------------------------------------------------------------------------*/
 #ifndef _atof_h
  #define _atof_h
+ #include <stddef.h> /* for size_t */
  #ifdef __cplusplus
  extern "C" {
  #endif 
   float fast_strtof(const char *s,char **endptr); // if endptr != NULL returns 1st character thats not in the number
+  void fast_strtof_array(char * const s[],float f[],char *endptr[],size_t n); // f[i]=fast_strtof(s[i],&endptr[i]) for i=0..n-1 (endptr may be NULL) - for converting a lot of numbers at once
+  double fast_strtod(const char *s,char **endptr); // as strtod() (so correctly rounded) but faster for "simple" numbers
+  float fast_strtof_int(const char *s,char **endptr); // as fast_strtof() but faster for integers (anything else is passed to fast_strtof() )
  #ifdef __cplusplus
     }
  #endif
@@ -0,0 +1,495 @@
+/* csv-cache.c
+
+ Keep a "sidecar" file (csv filename + ".csvgraph-cache") next to a csv file that holds the values read from columns of the csv file as floats,
+ along with any converted x values (eg from times). The next time the same columns are read they are taken from the memory mapped sidecar file
+ which is much faster than parsing the csv file again.
+
+ The sidecar is only used if the size and last modification time of the csv file, and a hash of its header line, match those stored in the sidecar,
+ otherwise the sidecar is ignored and a new one is written when the csv file has been read again.
+ When columns are added to an up to date sidecar file the columns already in it are kept.
+ While the csv file is being read the values are written to a ".part" file in blocks of CSV_CACHE_BLOCK_LINES lines, so only one block of values
+ for each column is held in RAM. When all the file has been read the sidecar file is written by copying each column in turn from the ".part" file.
+
+ Sidecar file format (native byte order - its only intended to be read by the program that wrote it):
+	struct cache_header
+	struct cache_col [nos_cols]
+	nos_lines floats for each column (each column starts on an 8 byte boundary)
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h> /* for malloc() and free() */
+#include <string.h> /* for memcmp() etc */
+#include <math.h> /* for NAN */
+#include "csv-cache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#define cache_fseek _fseeki64
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define cache_fseek fseeko
+#endif
+
+#define CSV_CACHE_EXT L".csvgraph-cache" /* added to csv filename to give name of sidecar file */
+#define CSV_CACHE_TMP_EXT L".csvgraph-cache.tmp" /* sidecar is written to this file, then renamed so a partly written sidecar is never used */
+#define CSV_CACHE_PART_EXT L".csvgraph-cache.part" /* values are written to this file in blocks while the csv file is read */
+#define CSV_CACHE_MAGIC "CSVGC\x02\x00\x00" /* 8 bytes, last 3 are the version number (2 => src_mtime has full resolution) */
+#define CSV_CACHE_BLOCK_LINES 65536 /* number of lines of values for each column held in RAM while the csv file is read */
+#define CSV_CACHE_MAX_COLS 4096 /* max columns in a sidecar file (limits the effects of a "silly" file) */
+
+struct cache_header
+	{char magic[8];         // CSV_CACHE_MAGIC
+	 int64_t src_size;      // size of csv file in bytes
+	 int64_t src_mtime;     // time csv file was last modified (FILETIME ie 100ns units under Windows, ns otherwise)
+	 uint64_t nos_lines;    // number of lines of data in csv file (lines after the header)
+	 uint32_t hdr_hash;     // hash of header line of csv file
+	 uint32_t skip_lines;   // number of lines skipped before the header line
+	 uint32_t nos_cols;     // number of struct cache_col that follow this header
+	 uint32_t spare;        // set to 0
+	};
+
+struct cache_col
+	{uint32_t kind;         // CSV_CACHE_Y or CSV_CACHE_X
+	 uint32_t key;          // column number for CSV_CACHE_Y, key set by caller for CSV_CACHE_X
+	 uint32_t xkey;         // 0 if every line has a value, otherwise key for x values in use when column was read (lines with invalid x values were skipped, so values on these lines are NAN)
+	 uint32_t spare;        // set to 0
+	 uint64_t offset;       // offset in sidecar file of nos_lines floats
+	};
+
+struct s_csv_cache
+	{
+#ifdef _WIN32
+	 HANDLE hFile,hMap;
+#else
+	 int fd;
+#endif
+	 char *base;            // start of mapped sidecar file
+	 size_t size;           // size of sidecar file (in bytes)
+	 struct cache_header *hdr;
+	 struct cache_col *cols;
+	};
+
+struct cache_wcol
+	{uint32_t kind;
+	 uint32_t key;
+	 float *data;           // CSV_CACHE_BLOCK_LINES values for lines block_start onwards
+	};
+
+struct s_csv_cache_writer
+	{struct cache_wcol *cols;
+	 int nos_cols;
+	 size_t block_start;    // line of 1st value in data[] of each column
+	 uint64_t nos_blocks;   // number of blocks written to part file
+	 FILE *fp;              // ".part" file, each block is CSV_CACHE_BLOCK_LINES values of each column in turn
+	 wchar_t *part_fn;      // name of ".part" file
+	 bool failed;           // set if we run out of RAM (or disk space), in which case no sidecar is written
+	};
+
+static wchar_t *cache_filename(const wchar_t *csv_filename,const wchar_t *ext) /* returns malloc'ed filename for sidecar, NULL if out of RAM */
+{size_t len=wcslen(csv_filename)+wcslen(ext)+1;
+ wchar_t *fn=(wchar_t *)malloc(len*sizeof(wchar_t));
+ if(fn==NULL) return NULL;
+ wcscpy(fn,csv_filename);
+ wcscat(fn,ext);
+ return fn;
+}
+
+#ifndef _WIN32
+static char *to_cfilename(const wchar_t *filename) /* returns malloc'ed multibyte version of filename, NULL on error */
+{char *cfilename;
+ size_t len=wcstombs(NULL,filename,0);
+ if(len==(size_t)-1 || (cfilename=(char *)malloc(len+1))==NULL)
+	return NULL;
+ wcstombs(cfilename,filename,len+1);
+ return cfilename;
+}
+#endif
+
+static bool src_file_info(const wchar_t *csv_filename,int64_t *size,int64_t *mtime) /* get size and modification time of the csv file, returns false on error */
+{
+#ifdef _WIN32
+ WIN32_FILE_ATTRIBUTE_DATA fad;
+ if(!GetFileAttributesExW(csv_filename,GetFileExInfoStandard,&fad)) return false;
+ *size=(int64_t)(((uint64_t)fad.nFileSizeHigh<<32) | fad.nFileSizeLow);
+ *mtime=(int64_t)(((uint64_t)fad.ftLastWriteTime.dwHighDateTime<<32) | fad.ftLastWriteTime.dwLowDateTime);
+ return true;
+#else
+ struct stat st;
+ char *cfilename=to_cfilename(csv_filename);
+ if(cfilename==NULL) return false;
+ if(stat(cfilename,&st)!=0)
+	{free(cfilename);
+	 return false;
+	}
+ free(cfilename);
+ *size=(int64_t)st.st_size;
+ *mtime=(int64_t)st.st_mtim.tv_sec*1000000000+(int64_t)st.st_mtim.tv_nsec; // st_mtime only has a resolution of 1 sec, and the csv file could be rewritten within a second
+ return true;
+#endif
+}
+
+csv_cache *csv_cache_open(const wchar_t *csv_filename,uint32_t hdr_hash,uint32_t skip_lines) /* map sidecar file for csv_filename if it exists and matches the csv file, returns NULL otherwise */
+{int64_t src_size,src_mtime;
+ wchar_t *fn;
+ csv_cache *c;
+ if(!src_file_info(csv_filename,&src_size,&src_mtime)) return NULL;
+ fn=cache_filename(csv_filename,CSV_CACHE_EXT);
+ if(fn==NULL) return NULL;
+ c=(csv_cache *)calloc(1,sizeof(csv_cache));
+ if(c==NULL)
+	{free(fn);
+	 return NULL;
+	}
+#ifdef _WIN32
+ c->hFile=CreateFileW(fn,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+ free(fn);
+ if(c->hFile==INVALID_HANDLE_VALUE)
+	{free(c);
+	 return NULL;
+	}
+ LARGE_INTEGER size;
+ if(!GetFileSizeEx(c->hFile,&size) || size.QuadPart<(LONGLONG)sizeof(struct cache_header) || (uint64_t)size.QuadPart>(uint64_t)SIZE_MAX)
+	{CloseHandle(c->hFile);
+	 free(c);
+	 return NULL;
+	}
+ c->size=(size_t)size.QuadPart;
+ c->hMap=CreateFileMappingW(c->hFile,NULL,PAGE_READONLY,0,0,NULL);
+ if(c->hMap!=NULL)
+	c->base=(char *)MapViewOfFile(c->hMap,FILE_MAP_READ,0,0,0); // map whole file, this can fail for big files with a 32 bit program in which case the csv file will just be read
+ if(c->base==NULL)
+	{if(c->hMap!=NULL) CloseHandle(c->hMap);
+	 CloseHandle(c->hFile);
+	 free(c);
+	 return NULL;
+	}
+#else
+ char *cfilename=to_cfilename(fn);
+ free(fn);
+ if(cfilename==NULL)
+	{free(c);
+	 return NULL;
+	}
+ c->fd=open(cfilename,O_RDONLY);
+ free(cfilename);
+ if(c->fd== -1)
+	{free(c);
+	 return NULL;
+	}
+ struct stat st;
+ if(fstat(c->fd,&st)!=0 || st.st_size<(off_t)sizeof(struct cache_header))
+	{close(c->fd);
+	 free(c);
+	 return NULL;
+	}
+ c->size=(size_t)st.st_size;
+ void *p=mmap(NULL,c->size,PROT_READ,MAP_SHARED,c->fd,0);
+ if(p==MAP_FAILED)
+	{close(c->fd);
+	 free(c);
+	 return NULL;
+	}
+ c->base=(char *)p;
+#endif
+ c->hdr=(struct cache_header *)c->base;
+ c->cols=(struct cache_col *)(c->base+sizeof(struct cache_header));
+ // now check sidecar matches the csv file and is not corrupt
+ if(memcmp(c->hdr->magic,CSV_CACHE_MAGIC,sizeof(c->hdr->magic))!=0 || c->hdr->src_size!=src_size || c->hdr->src_mtime!=src_mtime ||
+	c->hdr->hdr_hash!=hdr_hash || c->hdr->skip_lines!=skip_lines || c->hdr->nos_cols>CSV_CACHE_MAX_COLS ||
+	c->hdr->nos_lines>c->size/sizeof(float) ||
+	sizeof(struct cache_header)+c->hdr->nos_cols*sizeof(struct cache_col)>c->size)
+	{csv_cache_close(c);
+	 return NULL;
+	}
+ for(uint32_t i=0;i<c->hdr->nos_cols;++i)
+	{if(c->cols[i].offset>c->size || c->size-c->cols[i].offset<c->hdr->nos_lines*sizeof(float))
+		{csv_cache_close(c); // sidecar file has been truncated
+		 return NULL;
+		}
+	}
+ return c;
+}
+
+size_t csv_cache_nos_lines(csv_cache *c) /* returns number of lines of data (lines after the header) in the csv file */
+{return (size_t)c->hdr->nos_lines;
+}
+
+static const struct cache_col *find_col(csv_cache *c,uint32_t kind,uint32_t key,uint32_t xkey) /* returns column (NULL if not found) */
+{for(uint32_t i=0;i<c->hdr->nos_cols;++i)
+	{const struct cache_col *cp=&c->cols[i];
+	 if(cp->kind==kind && cp->key==key && (cp->xkey==0 || cp->xkey==xkey))
+		return cp;
+	}
+ return NULL;
+}
+
+const float *csv_cache_column(csv_cache *c,uint32_t kind,uint32_t key,uint32_t xkey) /* returns values for column (NULL if not in sidecar), xkey is the key of the x values in use */
+{const struct cache_col *cp=find_col(c,kind,key,xkey);
+ if(cp==NULL) return NULL;
+ return (const float *)(c->base+cp->offset);
+}
+
+void csv_cache_close(csv_cache *c) /* unmap sidecar and free all memory used. c may be NULL */
+{if(c==NULL) return;
+#ifdef _WIN32
+ UnmapViewOfFile(c->base);
+ CloseHandle(c->hMap);
+ CloseHandle(c->hFile);
+#else
+ munmap(c->base,c->size);
+ close(c->fd);
+#endif
+ free(c);
+}
+
+static FILE *open_wfile(const wchar_t *filename,const char *mode) /* fopen() for a wchar_t filename, returns NULL on error */
+{
+#ifdef _WIN32
+ wchar_t wmode[8];
+ size_t i;
+ for(i=0;mode[i]!=0 && i<7;++i) wmode[i]=(wchar_t)mode[i];
+ wmode[i]=0;
+ return _wfopen(filename,wmode);
+#else
+ FILE *fp;
+ char *cfilename=to_cfilename(filename);
+ fp= cfilename==NULL ? NULL : fopen(cfilename,mode);
+ free(cfilename);
+ return fp;
+#endif
+}
+
+static void remove_wfile(const wchar_t *filename) /* delete file */
+{
+#ifdef _WIN32
+ DeleteFileW(filename);
+#else
+ char *cfilename=to_cfilename(filename);
+ if(cfilename!=NULL) remove(cfilename);
+ free(cfilename);
+#endif
+}
+
+csv_cache_writer *csv_cache_writer_new(const wchar_t *csv_filename) /* start collecting values to write a sidecar file for csv_filename, returns NULL on error (eg out of RAM, or the directory is read only) */
+{csv_cache_writer *w=(csv_cache_writer *)calloc(1,sizeof(csv_cache_writer));
+ if(w==NULL) return NULL;
+ w->part_fn=cache_filename(csv_filename,CSV_CACHE_PART_EXT);
+ if(w->part_fn==NULL || (w->fp=open_wfile(w->part_fn,"w+b"))==NULL)
+	{free(w->part_fn);
+	 free(w);
+	 return NULL;
+	}
+ return w;
+}
+
+int csv_cache_writer_column(csv_cache_writer *w,uint32_t kind,uint32_t key) /* returns index of column to use with csv_cache_set() (adding it if required), -1 on error. All columns must be added before any values are set */
+{struct cache_wcol *new_cols;
+ if(w->failed) return -1;
+ for(int i=0;i<w->nos_cols;++i)
+	if(w->cols[i].kind==kind && w->cols[i].key==key)
+		return i; // already have this column
+ if(w->nos_cols>=CSV_CACHE_MAX_COLS || w->nos_blocks>0) return -1; // blocks already written do not have space for another column
+ new_cols=(struct cache_wcol *)realloc(w->cols,(size_t)(w->nos_cols+1)*sizeof(struct cache_wcol));
+ if(new_cols==NULL)
+	{w->failed=true;
+	 return -1;
+	}
+ w->cols=new_cols;
+ w->cols[w->nos_cols].kind=kind;
+ w->cols[w->nos_cols].key=key;
+ w->cols[w->nos_cols].data=(float *)malloc(CSV_CACHE_BLOCK_LINES*sizeof(float));
+ if(w->cols[w->nos_cols].data==NULL)
+	{w->failed=true;
+	 return -1;
+	}
+ for(size_t i=0;i<CSV_CACHE_BLOCK_LINES;++i)
+	w->cols[w->nos_cols].data[i]=NAN;
+ return w->nos_cols++;
+}
+
+static bool flush_cache_block(csv_cache_writer *w) /* write current block of values to the part file and start the next block, returns false on error */
+{if(w->failed) return false;
+ for(int i=0;i<w->nos_cols;++i)
+	{if(fwrite(w->cols[i].data,sizeof(float),CSV_CACHE_BLOCK_LINES,w->fp)!=CSV_CACHE_BLOCK_LINES)
+		{w->failed=true; // eg disk full
+		 return false;
+		}
+	 for(size_t j=0;j<CSV_CACHE_BLOCK_LINES;++j)
+		w->cols[i].data[j]=NAN; // lines without a value are NAN
+	}
+ w->block_start+=CSV_CACHE_BLOCK_LINES;
+ ++w->nos_blocks;
+ return true;
+}
+
+void csv_cache_set(csv_cache_writer *w,int col,size_t line,float v) /* set value on line (0=1st line after the header) for col. Lines must be set in order (earlier lines cannot be set once a later block has been started) */
+{if(col<0 || col>=w->nos_cols || w->failed || line<w->block_start) return;
+ while(line>=w->block_start+CSV_CACHE_BLOCK_LINES)
+	if(!flush_cache_block(w))
+		return; // w->failed is now set so no sidecar will be written
+ w->cols[col].data[line-w->block_start]=v;
+}
+
+static bool copy_cache_col(csv_cache_writer *w,int col,size_t nos_lines,FILE *fp) /* copy nos_lines values of column col from the part file to fp, returns false on error */
+{for(size_t line=0;line<nos_lines;line+=CSV_CACHE_BLOCK_LINES)
+	{uint64_t b=line/CSV_CACHE_BLOCK_LINES;
+	 size_t n=nos_lines-line;
+	 if(n>CSV_CACHE_BLOCK_LINES) n=CSV_CACHE_BLOCK_LINES;
+	 if(b<w->nos_blocks)
+		{// part file has blocks of all columns in turn, so use the data array of col as a buffer
+		 if(cache_fseek(w->fp,(b*(uint64_t)w->nos_cols+(uint64_t)col)*CSV_CACHE_BLOCK_LINES*sizeof(float),SEEK_SET)!=0 ||
+			fread(w->cols[col].data,sizeof(float),n,w->fp)!=n)
+			return false;
+		}
+	 else
+		{for(size_t i=0;i<n;++i)
+			w->cols[col].data[i]=NAN; // lines after the last value was set
+		}
+	 if(fwrite(w->cols[col].data,sizeof(float),n,fp)!=n)
+		return false;
+	}
+ return true;
+}
+
+static bool write_zeros(FILE *fp,uint64_t n) /* write n (<8) zero bytes, returns false on error */
+{static const char zeros[8]={0};
+ return n==0 || fwrite(zeros,1,(size_t)n,fp)==n;
+}
+
+bool csv_cache_write(csv_cache_writer *w,const wchar_t *csv_filename,uint32_t hdr_hash,uint32_t skip_lines,size_t nos_lines,uint32_t y_xkey) /* write sidecar file (keeping up to date columns already in it), returns true if OK */
+ /* y_xkey is 0 if CSV_CACHE_Y columns have a value for every line, otherwise its the key for the x values whose errors caused lines to be skipped */
+{struct cache_header hdr;
+ struct cache_col *cols;
+ const float **data; // values for each column in cols[] (NULL for columns in w, which are copied from the part file)
+ csv_cache *old;
+ wchar_t *fn,*tmp_fn;
+ FILE *fp;
+ uint32_t nos_cols=0;
+ uint64_t offset,col_bytes;
+ bool ok=true;
+ if(w->failed || w->nos_cols==0) return false;
+ if(nos_lines>w->block_start && !flush_cache_block(w)) return false; // write the last block (which may only be partly used)
+ if(fflush(w->fp)!=0) return false;
+ memset(&hdr,0,sizeof(hdr));
+ memcpy(hdr.magic,CSV_CACHE_MAGIC,sizeof(hdr.magic));
+ if(!src_file_info(csv_filename,&hdr.src_size,&hdr.src_mtime)) return false;
+ hdr.nos_lines=nos_lines;
+ hdr.hdr_hash=hdr_hash;
+ hdr.skip_lines=skip_lines;
+ old=csv_cache_open(csv_filename,hdr_hash,skip_lines); // columns already in an up to date sidecar file are kept
+ if(old!=NULL && old->hdr->nos_lines!=nos_lines)
+	{csv_cache_close(old); // should not happen as csv file has not changed, but just in case...
+	 old=NULL;
+	}
+ cols=(struct cache_col *)calloc((size_t)w->nos_cols+(old==NULL ? 0 : old->hdr->nos_cols),sizeof(struct cache_col));
+ data=(const float **)malloc(((size_t)w->nos_cols+(old==NULL ? 0 : old->hdr->nos_cols))*sizeof(float *));
+ fn=cache_filename(csv_filename,CSV_CACHE_EXT);
+ tmp_fn=cache_filename(csv_filename,CSV_CACHE_TMP_EXT);
+ if(cols==NULL || data==NULL || fn==NULL || tmp_fn==NULL)
+	{ok=false;
+	 goto done;
+	}
+ for(int i=0;i<w->nos_cols;++i)
+	{cols[nos_cols].kind=w->cols[i].kind;
+	 cols[nos_cols].key=w->cols[i].key;
+	 cols[nos_cols].xkey= w->cols[i].kind==CSV_CACHE_Y ? y_xkey : 0;
+	 data[nos_cols++]=NULL;
+	}
+ if(old!=NULL)
+	{for(uint32_t i=0;i<old->hdr->nos_cols;++i)
+		{const struct cache_col *cp=&old->cols[i];
+		 bool have_col=false;
+		 for(uint32_t j=0;j<(uint32_t)w->nos_cols;++j)
+			if(cols[j].kind==cp->kind && cols[j].key==cp->key && (cols[j].xkey==0 || cols[j].xkey==cp->xkey))
+				{have_col=true; // new column replaces old one
+				 break;
+				}
+		 if(!have_col && nos_cols<CSV_CACHE_MAX_COLS)
+			{cols[nos_cols]= *cp;
+			 data[nos_cols++]=(const float *)(old->base+cp->offset);
+			}
+		}
+	}
+ hdr.nos_cols=nos_cols;
+ col_bytes=((uint64_t)nos_lines*sizeof(float)+7) & ~(uint64_t)7; // each column starts on an 8 byte boundary
+ offset=(sizeof(struct cache_header)+nos_cols*sizeof(struct cache_col)+7) & ~(uint64_t)7;
+ for(uint32_t i=0;i<nos_cols;++i)
+	{cols[i].spare=0;
+	 cols[i].offset=offset;
+	 offset+=col_bytes;
+	}
+ fp=open_wfile(tmp_fn,"wb");
+ if(fp==NULL)
+	{ok=false; // cannot write sidecar (eg directory is read only)
+	 goto done;
+	}
+ ok= fwrite(&hdr,sizeof(hdr),1,fp)==1 && fwrite(cols,sizeof(struct cache_col),nos_cols,fp)==nos_cols &&
+	 write_zeros(fp,cols[0].offset-(sizeof(struct cache_header)+nos_cols*sizeof(struct cache_col)));
+ for(uint32_t i=0;ok && i<nos_cols;++i)
+	ok= (data[i]==NULL ? copy_cache_col(w,(int)i,nos_lines,fp) : fwrite(data[i],sizeof(float),nos_lines,fp)==nos_lines) &&
+		write_zeros(fp,col_bytes-(uint64_t)nos_lines*sizeof(float));
+ if(fclose(fp)!=0) ok=false;
+ csv_cache_close(old); // must be closed before its replaced
+ old=NULL;
+#ifdef _WIN32
+ if(!ok || !MoveFileExW(tmp_fn,fn,MOVEFILE_REPLACE_EXISTING))
+	{ok=false;
+	 DeleteFileW(tmp_fn);
+	}
+#else
+ {char *c_tmp_fn=to_cfilename(tmp_fn),*c_fn=to_cfilename(fn);
+  if(!ok || c_tmp_fn==NULL || c_fn==NULL || rename(c_tmp_fn,c_fn)!=0)
+	{ok=false;
+	 if(c_tmp_fn!=NULL) remove(c_tmp_fn);
+	}
+  free(c_tmp_fn);
+  free(c_fn);
+ }
+#endif
+done:
+ csv_cache_close(old);
+ free(cols);
+ free(data);
+ free(fn);
+ free(tmp_fn);
+ return ok;
+}
+
+void csv_cache_writer_free(csv_cache_writer *w) /* delete part file and free all memory used by w. w may be NULL */
+{if(w==NULL) return;
+ fclose(w->fp);
+ remove_wfile(w->part_fn);
+ free(w->part_fn);
+ for(int i=0;i<w->nos_cols;++i)
+	free(w->cols[i].data);
+ free(w->cols);
+ free(w);
+}
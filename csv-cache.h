@@ -0,0 +1,62 @@
+/* csv-cache.h
+ header file for csv-cache.c
+
+ Keeps a "sidecar" file next to a csv file that holds the values read from columns of the csv file (as floats), so
+ when the same columns are read again they can be taken from the (memory mapped) sidecar file rather than parsing the csv file.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#ifndef _csv_cache_h
+ #define _csv_cache_h
+ #include <stdbool.h> /* as bool used below */
+ #include <stdint.h> /* for uint32_t */
+ #include <stddef.h> /* for size_t */
+ #include <wchar.h> /* for wchar_t */
+ #ifdef __cplusplus
+  extern "C" {
+ #endif
+#define CSV_CACHE_Y 0 /* column holds the values in a column of the csv file, key is the column number (1=1st column) */
+#define CSV_CACHE_X 1 /* column holds converted x values (eg times), key is set by caller to identify how they were converted */
+ /* values are NAN for lines where the column did not contain a valid number */
+
+typedef struct s_csv_cache csv_cache;
+csv_cache *csv_cache_open(const wchar_t *csv_filename,uint32_t hdr_hash,uint32_t skip_lines); /* map sidecar file for csv_filename if it exists and matches the csv file, returns NULL otherwise */
+size_t csv_cache_nos_lines(csv_cache *c); /* returns number of lines of data (lines after the header) in the csv file */
+const float *csv_cache_column(csv_cache *c,uint32_t kind,uint32_t key,uint32_t xkey); /* returns values for column (NULL if not in sidecar), xkey is the key of the x values in use */
+void csv_cache_close(csv_cache *c); /* unmap sidecar and free all memory used. c may be NULL */
+
+typedef struct s_csv_cache_writer csv_cache_writer;
+csv_cache_writer *csv_cache_writer_new(const wchar_t *csv_filename); /* start collecting values to write a sidecar file for csv_filename, returns NULL on error (eg out of RAM, or the directory is read only) */
+int csv_cache_writer_column(csv_cache_writer *w,uint32_t kind,uint32_t key); /* returns index of column to use with csv_cache_set() (adding it if required), -1 on error. All columns must be added before any values are set */
+void csv_cache_set(csv_cache_writer *w,int col,size_t line,float v); /* set value on line (0=1st line after the header) for col. Lines must be set in order (earlier lines cannot be set once a later block has been started) */
+bool csv_cache_write(csv_cache_writer *w,const wchar_t *csv_filename,uint32_t hdr_hash,uint32_t skip_lines,size_t nos_lines,uint32_t y_xkey); /* write sidecar file (keeping up to date columns already in it), returns true if OK */
+ /* y_xkey is 0 if CSV_CACHE_Y columns have a value for every line, otherwise its the key for the x values whose errors caused lines to be skipped */
+void csv_cache_writer_free(csv_cache_writer *w); /* delete temporary file and free all memory used by w. w may be NULL */
+
+ #ifdef __cplusplus
+    }
+ #endif
+#endif
@@ -0,0 +1,444 @@
+/* csv-decompress.c
+
+ Decompress a gzip (.gz) or zstd (.zst) compressed csv file "on the fly".
+
+ A separate thread reads the compressed file and decompresses it into a ring of CSV_DECOMP_BLOCKS blocks, while the caller
+ (csv_readline() in csv-reader.c) splits the blocks already decompressed into lines, so decompression and parsing overlap.
+ The type of compression is found from the "magic" bytes at the start of the file, not from the file extension.
+ gzip files may contain multiple "members" (eg from cat a.gz b.gz > c.gz) and zstd files multiple frames, these are all decompressed.
+
+ The same thread and ring of blocks are used to "read ahead" in files that are not compressed (type CSV_DECOMP_NONE, see csv_read_ahead_open() ),
+ so the disk is reading the next blocks of the file while the caller parses the current one.
+
+ zlib and zstd are loaded at run time (zlib1.dll & libzstd.dll on windows) so they are only needed if a compressed file is read.
+ Only the small parts of zlib.h and zstd.h that are needed are copied below, so their header files are not needed to compile this file.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h> /* for malloc() and free() */
+#include <string.h>
+#include <stdbool.h>
+#include "csv-decompress.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h> /* for _beginthreadex */
+#define ZLIB_DLL "zlib1.dll"
+#define ZSTD_DLL "libzstd.dll"
+typedef HMODULE lib_t;
+#define lib_open(name) LoadLibraryA(name)
+#define lib_fn(lib,name) ((void *)GetProcAddress(lib,name))
+#else
+#include <pthread.h>
+#include <dlfcn.h>
+#include <fcntl.h> /* for posix_fadvise() */
+#define ZLIB_DLL "libz.so.1"
+#define ZSTD_DLL "libzstd.so.1"
+typedef void *lib_t;
+#define lib_open(name) dlopen(name,RTLD_NOW)
+#define lib_fn(lib,name) dlsym(lib,name)
+#endif
+
+#define CSV_DECOMP_BLOCKS 4 /* number of blocks of decompressed data, the thread can be decompressing 1 block while the caller is using another and 2 more are ready to use */
+#define CSV_DECOMP_BLOCK_SIZE (4*1024*1024) /* size of each block of decompressed data */
+#define CSV_DECOMP_IN_SIZE (256*1024) /* size of buffer for compressed data read from the file */
+#define CSV_READ_AHEAD_BLOCK_SIZE (8*1024*1024) /* default size of each block when reading ahead in a file that is not compressed */
+
+/* from zlib.h */
+typedef struct
+	{const unsigned char *next_in; unsigned int avail_in; unsigned long total_in;
+	 unsigned char *next_out; unsigned int avail_out; unsigned long total_out;
+	 const char *msg; void *state;
+	 void *zalloc,*zfree,*opaque; /* NULL means zlib uses malloc() and free() */
+	 int data_type; unsigned long adler; unsigned long reserved;
+	} z_stream_t; /* same layout as z_stream */
+#define Z_OK 0
+#define Z_STREAM_END 1
+#define Z_NO_FLUSH 0
+#define Z_WINDOW_BITS (15+32) /* max window size, +32 automatically detects gzip or zlib headers */
+static int (*p_inflateInit2_)(z_stream_t *strm,int windowBits,const char *version,int stream_size);
+static int (*p_inflate)(z_stream_t *strm,int flush);
+static int (*p_inflateReset)(z_stream_t *strm);
+static int (*p_inflateEnd)(z_stream_t *strm);
+
+/* from zstd.h */
+typedef struct {const void *src; size_t size; size_t pos;} zstd_in_t; /* ZSTD_inBuffer */
+typedef struct {void *dst; size_t size; size_t pos;} zstd_out_t; /* ZSTD_outBuffer */
+static void *(*p_ZSTD_createDStream)(void);
+static size_t (*p_ZSTD_initDStream)(void *zds);
+static size_t (*p_ZSTD_decompressStream)(void *zds,zstd_out_t *output,zstd_in_t *input);
+static unsigned (*p_ZSTD_isError)(size_t code);
+static const char *(*p_ZSTD_getErrorName)(size_t code);
+static size_t (*p_ZSTD_freeDStream)(void *zds);
+
+struct s_csv_decomp
+	{FILE *fp;
+	 int type;            // CSV_DECOMP_GZIP or CSV_DECOMP_ZSTD, or CSV_DECOMP_NONE to just read ahead
+	 size_t block_size;   // size of each block[]
+	 const char *error;   // NULL if no error
+	 unsigned char *in_buf; // compressed data read from the file
+	 char *block[CSV_DECOMP_BLOCKS]; // decompressed data
+	 size_t block_len[CSV_DECOMP_BLOCKS];
+	 int64_t block_in_end[CSV_DECOMP_BLOCKS]; // compressed bytes used to give all data up to the end of this block
+	 int nos_full;        // number of blocks the thread has filled that the caller has not yet finished with (includes the block the caller is using)
+	 int fill;            // block the thread fills next
+	 int current;         // block the caller is given next (or is using if in_use is true)
+	 bool in_use;         // true if the caller is using block[current]
+	 int64_t used_in;     // compressed bytes used to give all the blocks the caller has finished with
+	 bool done;           // thread has finished (all of file decompressed, or an error)
+	 bool stop;           // set to ask the thread to stop
+	 bool thread_running;
+#ifdef _WIN32
+	 CRITICAL_SECTION lock;
+	 CONDITION_VARIABLE cond; // signalled whenever any of the variables above changes
+	 HANDLE th;
+#else
+	 pthread_mutex_t lock;
+	 pthread_cond_t cond;
+	 pthread_t th;
+#endif
+	};
+
+#ifdef _WIN32
+#define d_lock(d) EnterCriticalSection(&(d)->lock)
+#define d_unlock(d) LeaveCriticalSection(&(d)->lock)
+#define d_wait(d) SleepConditionVariableCS(&(d)->cond,&(d)->lock,INFINITE)
+#define d_signal(d) WakeAllConditionVariable(&(d)->cond)
+#else
+#define d_lock(d) pthread_mutex_lock(&(d)->lock)
+#define d_unlock(d) pthread_mutex_unlock(&(d)->lock)
+#define d_wait(d) pthread_cond_wait(&(d)->cond,&(d)->lock)
+#define d_signal(d) pthread_cond_broadcast(&(d)->cond)
+#endif
+
+int csv_decomp_type(const unsigned char *magic,size_t len) /* returns CSV_DECOMP_xxx depending on the 1st len bytes of a file (4 bytes are needed to detect zstd) */
+{if(len>=2 && magic[0]==0x1f && magic[1]==0x8b) return CSV_DECOMP_GZIP;
+ if(len>=4 && magic[0]==0x28 && magic[1]==0xb5 && magic[2]==0x2f && magic[3]==0xfd) return CSV_DECOMP_ZSTD;
+ return CSV_DECOMP_NONE;
+}
+
+static const char *load_lib(int type) /* load dll needed for type of compression if not already loaded, returns NULL if OK or an error message */
+{static bool tried_zlib=false,tried_zstd=false; // only try to load each dll once
+ lib_t lib;
+ if(type==CSV_DECOMP_GZIP)
+	{if(!tried_zlib)
+		{tried_zlib=true;
+		 if((lib=lib_open(ZLIB_DLL))!=NULL)
+			{*(void **)&p_inflateInit2_=lib_fn(lib,"inflateInit2_");
+			 *(void **)&p_inflate=lib_fn(lib,"inflate");
+			 *(void **)&p_inflateReset=lib_fn(lib,"inflateReset");
+			 *(void **)&p_inflateEnd=lib_fn(lib,"inflateEnd");
+			}
+		}
+	 if(p_inflateInit2_==NULL || p_inflate==NULL || p_inflateReset==NULL || p_inflateEnd==NULL)
+		return "file is gzip compressed but " ZLIB_DLL " was not found";
+	}
+ else
+	{if(!tried_zstd)
+		{tried_zstd=true;
+		 if((lib=lib_open(ZSTD_DLL))!=NULL)
+			{*(void **)&p_ZSTD_createDStream=lib_fn(lib,"ZSTD_createDStream");
+			 *(void **)&p_ZSTD_initDStream=lib_fn(lib,"ZSTD_initDStream");
+			 *(void **)&p_ZSTD_decompressStream=lib_fn(lib,"ZSTD_decompressStream");
+			 *(void **)&p_ZSTD_isError=lib_fn(lib,"ZSTD_isError");
+			 *(void **)&p_ZSTD_getErrorName=lib_fn(lib,"ZSTD_getErrorName");
+			 *(void **)&p_ZSTD_freeDStream=lib_fn(lib,"ZSTD_freeDStream");
+			}
+		}
+	 if(p_ZSTD_createDStream==NULL || p_ZSTD_initDStream==NULL || p_ZSTD_decompressStream==NULL || p_ZSTD_isError==NULL || p_ZSTD_getErrorName==NULL || p_ZSTD_freeDStream==NULL)
+		return "file is zstd compressed but " ZSTD_DLL " was not found";
+	}
+ return NULL;
+}
+
+static bool wait_for_free_block(csv_decomp *d) /* wait till there is a block the thread can fill, returns false if the thread has been asked to stop */
+{bool stop;
+ d_lock(d);
+ while(d->nos_full==CSV_DECOMP_BLOCKS && !d->stop)
+	d_wait(d);
+ stop=d->stop;
+ d_unlock(d);
+ return !stop;
+}
+
+static void block_filled(csv_decomp *d,size_t len,int64_t in_end,bool finished,const char *error) /* pass a block the thread has filled to the caller */
+{d_lock(d);
+ if(len>0)
+	{d->block_len[d->fill]=len;
+	 d->block_in_end[d->fill]=in_end;
+	 d->fill=(d->fill+1)%CSV_DECOMP_BLOCKS;
+	 d->nos_full++;
+	}
+ if(finished)
+	{d->error=error;
+	 d->done=true;
+	}
+ d_signal(d);
+ d_unlock(d);
+}
+
+static void read_ahead(csv_decomp *d) /* fill blocks with data read from the file (type CSV_DECOMP_NONE) */
+{int64_t in_total=0; // bytes read from the file
+ bool finished=false;
+ while(!finished && wait_for_free_block(d))
+	{size_t len=fread(d->block[d->fill],1,d->block_size,d->fp); // only this thread changes d->fill so its safe to use it without a lock
+	 in_total+=(int64_t)len;
+	 finished= len<d->block_size;
+	 block_filled(d,len,in_total,finished,finished && ferror(d->fp) ? "error reading file" : NULL);
+	}
+ if(!finished) block_filled(d,0,0,true,NULL); // asked to stop
+}
+
+#ifdef _WIN32
+static unsigned __stdcall decomp_thread(void *arg) /* thread that decompresses the file */
+#else
+static void *decomp_thread(void *arg) /* thread that decompresses the file */
+#endif
+{csv_decomp *d=(csv_decomp *)arg;
+ const char *error=NULL;
+ z_stream_t zs;
+ void *zds=NULL;
+ size_t in_len=0,in_pos=0; // in_buf[in_pos..in_len-1] has not been decompressed yet
+ bool in_eof=false;
+ int64_t in_total=0;      // bytes read from the file
+ bool end_of_stream=false; // true if at the end of a gzip member or zstd frame (so its OK if the file ends here)
+ bool new_stream=false;   // true if a new gzip member has just been started
+ bool finished=false;
+ if(d->type==CSV_DECOMP_NONE)
+	{read_ahead(d);
+	 return 0;
+	}
+ if(d->type==CSV_DECOMP_GZIP)
+	{memset(&zs,0,sizeof(zs));
+	 if(p_inflateInit2_(&zs,Z_WINDOW_BITS,"1.2.11",(int)sizeof(zs))!=Z_OK) // zlib only checks the 1st digit of the version
+		error="cannot initialise zlib";
+	}
+ else
+	{zds=p_ZSTD_createDStream();
+	 if(zds==NULL || p_ZSTD_isError(p_ZSTD_initDStream(zds)))
+		error="cannot initialise zstd";
+	}
+ finished= error!=NULL;
+ while(!finished && wait_for_free_block(d))
+	{char *out=d->block[d->fill]; // only this thread changes d->fill so its safe to use it without a lock
+	 size_t out_len=0;
+	 while(out_len<CSV_DECOMP_BLOCK_SIZE)
+		{if(in_pos==in_len && !in_eof)
+			{in_len=fread(d->in_buf,1,CSV_DECOMP_IN_SIZE,d->fp);
+			 in_pos=0;
+			 in_total+=(int64_t)in_len;
+			 if(in_len<CSV_DECOMP_IN_SIZE)
+				{in_eof=true;
+				 if(ferror(d->fp)) error="error reading compressed file";
+				}
+			}
+		 if(in_pos==in_len || error!=NULL)
+			{// all of file decompressed
+			 if(error==NULL && !end_of_stream) error="compressed file is truncated";
+			 finished=true;
+			 break;
+			}
+		 size_t old_in_pos=in_pos,old_out_len=out_len;
+		 if(d->type==CSV_DECOMP_GZIP)
+			{int ret;
+			 if(end_of_stream)
+				{// more data after the end of a gzip member, so expect another member
+				 p_inflateReset(&zs);
+				 end_of_stream=false;
+				 new_stream=true;
+				}
+			 zs.next_in=d->in_buf+in_pos;
+			 zs.avail_in=(unsigned int)(in_len-in_pos);
+			 zs.next_out=(unsigned char *)out+out_len;
+			 zs.avail_out=(unsigned int)(CSV_DECOMP_BLOCK_SIZE-out_len);
+			 ret=p_inflate(&zs,Z_NO_FLUSH);
+			 in_pos=in_len-zs.avail_in;
+			 out_len=CSV_DECOMP_BLOCK_SIZE-zs.avail_out;
+			 if(ret==Z_STREAM_END)
+				end_of_stream=true;
+			 else if(ret<0 && new_stream && out_len==old_out_len)
+				{// not a valid gzip header after the end of a member, ignore the rest of the file (as gzip does with "trailing garbage", eg zeros added by tape drives)
+				 end_of_stream=true;
+				 in_pos=in_len;
+				 in_eof=true;
+				 continue;
+				}
+			 else if(ret<0)
+				{error= zs.msg!=NULL ? zs.msg : "corrupt gzip compressed data";
+				 finished=true;
+				 break;
+				}
+			 if(out_len!=old_out_len) new_stream=false;
+			}
+		 else
+			{zstd_in_t in={d->in_buf,in_len,in_pos};
+			 zstd_out_t zout={out,CSV_DECOMP_BLOCK_SIZE,out_len};
+			 size_t ret=p_ZSTD_decompressStream(zds,&zout,&in);
+			 in_pos=in.pos;
+			 out_len=zout.pos;
+			 if(p_ZSTD_isError(ret))
+				{error=p_ZSTD_getErrorName(ret);
+				 finished=true;
+				 break;
+				}
+			 end_of_stream= ret==0; // 0 means a frame has been completely decoded and all its data returned
+			}
+		 if(in_pos==old_in_pos && out_len==old_out_len && out_len<CSV_DECOMP_BLOCK_SIZE)
+			{error="compressed file is corrupt"; // no progress possible
+			 finished=true;
+			 break;
+			}
+		}
+	 block_filled(d,out_len,in_total-(int64_t)(in_len-in_pos),finished,error);
+	}
+ if(d->type==CSV_DECOMP_GZIP)
+	p_inflateEnd(&zs);
+ else if(zds!=NULL)
+	p_ZSTD_freeDStream(zds);
+ if(!finished) block_filled(d,0,0,true,NULL); // asked to stop
+ return 0;
+}
+
+static csv_decomp *start_thread(FILE *fp,int type,size_t block_size) /* start thread to decompress (or just read ahead in) fp, returns NULL if out of RAM */
+{csv_decomp *d=(csv_decomp *)calloc(1,sizeof(csv_decomp)); // calloc so all pointers start as NULL
+ if(d==NULL) return NULL;
+ d->fp=fp;
+ d->type=type;
+ d->block_size=block_size;
+ if(type!=CSV_DECOMP_NONE)
+	{d->in_buf=(unsigned char *)malloc(CSV_DECOMP_IN_SIZE);
+	 if(d->in_buf==NULL)
+		{free(d);
+		 return NULL;
+		}
+	}
+ for(int i=0;i<CSV_DECOMP_BLOCKS;++i)
+	{d->block[i]=(char *)malloc(block_size);
+	 if(d->block[i]==NULL)
+		{csv_decomp_close(d);
+		 return NULL;
+		}
+	}
+#ifdef _WIN32
+ InitializeCriticalSection(&d->lock);
+ InitializeConditionVariable(&d->cond);
+#else
+ pthread_mutex_init(&d->lock,NULL);
+ pthread_cond_init(&d->cond,NULL);
+ posix_fadvise(fileno(fp),0,0,POSIX_FADV_SEQUENTIAL); // file is read sequentially, so ask the OS for more aggressive readahead
+#endif
+ if(type!=CSV_DECOMP_NONE) d->error=load_lib(type);
+ if(d->error==NULL)
+	{
+#ifdef _WIN32
+	 d->th=(HANDLE)(uintptr_t)_beginthreadex(NULL,0,decomp_thread,d,0,NULL);
+	 d->thread_running= d->th!=0;
+#else
+	 d->thread_running= pthread_create(&d->th,NULL,decomp_thread,d)==0;
+#endif
+	 if(!d->thread_running) d->error="cannot start thread to decompress file";
+	}
+ if(d->error!=NULL) d->done=true; // nothing to read
+ return d;
+}
+
+csv_decomp *csv_decomp_open(FILE *fp,int type) /* start decompressing fp (which must be at the start of the file and open in binary mode), returns NULL if out of RAM. fp is not closed by csv_decomp_close() */
+{return start_thread(fp,type,CSV_DECOMP_BLOCK_SIZE);
+}
+
+csv_decomp *csv_read_ahead_open(FILE *fp,size_t block_size) /* start reading fp (open in binary mode) from its current position in blocks of block_size bytes (0 gives a default size) */
+{return start_thread(fp,CSV_DECOMP_NONE,block_size==0 ? CSV_READ_AHEAD_BLOCK_SIZE : block_size);
+}
+
+size_t csv_decomp_read(csv_decomp *d,char **buf) /* sets *buf to the next block of decompressed data (which may be changed by the caller) and returns its length, or 0 at EOF or on an error. The block is only valid till the next call */
+{size_t len=0;
+ d_lock(d);
+ if(d->in_use)
+	{// finished with current block so thread can refill it
+	 d->used_in=d->block_in_end[d->current];
+	 d->current=(d->current+1)%CSV_DECOMP_BLOCKS;
+	 d->nos_full--;
+	 d->in_use=false;
+	 d_signal(d);
+	}
+ while(d->nos_full==0 && !d->done)
+	d_wait(d);
+ if(d->nos_full>0)
+	{d->in_use=true;
+	 len=d->block_len[d->current];
+	 *buf=d->block[d->current];
+	}
+ d_unlock(d);
+ return len;
+}
+
+int64_t csv_decomp_tell(csv_decomp *d,size_t used) /* returns the number of bytes of the compressed file used to give the data returned so far, where used is the number of bytes of the last block returned that have been used */
+{int64_t r;
+ d_lock(d);
+ r=d->used_in;
+ if(d->in_use && d->block_len[d->current]>0) // assume compression ratio is constant over a block
+	r+=(int64_t)((double)(d->block_in_end[d->current]-d->used_in)*(double)used/(double)d->block_len[d->current]);
+ d_unlock(d);
+ return r;
+}
+
+const char *csv_decomp_error(csv_decomp *d) /* returns NULL if no error, otherwise a description of the error (eg the dll needed was not found, or the file is corrupt) */
+{const char *r;
+ d_lock(d);
+ r=d->error;
+ d_unlock(d);
+ return r;
+}
+
+void csv_decomp_close(csv_decomp *d) /* stop decompressing and free all memory used. d may be NULL */
+{if(d==NULL) return;
+ if(d->thread_running)
+	{d_lock(d);
+	 d->stop=true;
+	 d_signal(d);
+	 d_unlock(d);
+#ifdef _WIN32
+	 WaitForSingleObject(d->th,INFINITE);
+	 CloseHandle(d->th);
+#else
+	 pthread_join(d->th,NULL);
+#endif
+	}
+ if(d->block[CSV_DECOMP_BLOCKS-1]!=NULL)
+	{// all blocks allocated so lock etc were initialised
+#ifdef _WIN32
+	 DeleteCriticalSection(&d->lock);
+#else
+	 pthread_mutex_destroy(&d->lock);
+	 pthread_cond_destroy(&d->cond);
+#endif
+	}
+ for(int i=0;i<CSV_DECOMP_BLOCKS;++i)
+	if(d->block[i]!=NULL) free(d->block[i]);
+ if(d->in_buf!=NULL) free(d->in_buf);
+ free(d);
+}
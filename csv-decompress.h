@@ -0,0 +1,58 @@
+/* csv-decompress.h
+ header file for csv-decompress.c
+
+ Decompresses gzip (.gz) and zstd (.zst) compressed csv files "on the fly" using a separate thread, so decompression and
+ reading (parsing) the lines of the csv file overlap.
+ zlib1.dll and libzstd.dll are loaded when first needed, so csvgraph still runs without them (but cannot then read compressed files).
+ The same thread is used to read ahead in files that are not compressed (csv_read_ahead_open() ), so disk reads and parsing overlap.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#ifndef _csv_decompress_h
+ #define _csv_decompress_h
+ #include <stdio.h> /* for FILE */
+ #include <stdint.h> /* for int64_t */
+ #include <stddef.h> /* for size_t */
+ #ifdef __cplusplus
+  extern "C" {
+ #endif
+#define CSV_DECOMP_NONE 0 /* not compressed */
+#define CSV_DECOMP_GZIP 1 /* gzip (zlib) compressed */
+#define CSV_DECOMP_ZSTD 2 /* zstd compressed */
+
+typedef struct s_csv_decomp csv_decomp;
+int csv_decomp_type(const unsigned char *magic,size_t len); /* returns CSV_DECOMP_xxx depending on the 1st len bytes of a file (4 bytes are needed to detect zstd) */
+csv_decomp *csv_decomp_open(FILE *fp,int type); /* start decompressing fp (which must be at the start of the file and open in binary mode), returns NULL if out of RAM. fp is not closed by csv_decomp_close() */
+csv_decomp *csv_read_ahead_open(FILE *fp,size_t block_size); /* as csv_decomp_open() for a file that is not compressed, blocks of block_size bytes (0 gives a default size) are read from the current position of fp by another thread */
+size_t csv_decomp_read(csv_decomp *d,char **buf); /* sets *buf to the next block of decompressed data (which may be changed by the caller) and returns its length, or 0 at EOF or on an error. The block is only valid till the next call */
+int64_t csv_decomp_tell(csv_decomp *d,size_t used); /* returns the number of bytes of the compressed file used to give the data returned so far, where used is the number of bytes of the last block returned that have been used (for csv_read_ahead_open() this is relative to where reading started) */
+const char *csv_decomp_error(csv_decomp *d); /* returns NULL if no error, otherwise a description of the error (eg the dll needed was not found, or the file is corrupt) */
+void csv_decomp_close(csv_decomp *d); /* stop decompressing and free all memory used. d may be NULL */
+
+ #ifdef __cplusplus
+    }
+ #endif
+#endif
@@ -0,0 +1,853 @@
+/* csv-reader.c
+
+ Read a csv file a line at a time.
+
+ If possible the file is memory mapped (using "copy on write" so the caller can change the line eg via parsecsv() without changing the file),
+ this means there is no copy of each line (as there is with fgets() in readline() ). To allow very large files to be read by 32 bit programs
+ the file is mapped as a series of "views" of CSV_VIEW_SIZE bytes.
+ A memory mapped file can also be read in parts (via csv_open_part() ) so that multiple threads can each read a part of the same file.
+ If the file cannot be mapped (eg its empty) then it is read by another thread in big blocks (csv_read_ahead_open() in csv-decompress.c) so reading
+ the disk overlaps splitting the blocks into lines, or if that is not possible buffered reads via readline() are used instead.
+ gzip or zstd compressed files (found from the "magic" bytes at the start of the file) are decompressed on the fly by csv-decompress.c,
+ lines are returned from within the blocks of decompressed data where possible (so again there is no copy of each line).
+ stdin (filename "-") and pipes cannot be seeked or mapped, so they are read as a "stream". The lines read from a stream are kept until
+ csv_seek(r,0) is used to read them again (this allows the headers to be read when the stream is opened, and then again when its columns are read).
+ A "filename" that is a list of files separated by | or that contains wildcards (eg run_*.csv) is read as one file made by joining the files together
+ (in the natural order of their names, so run_2.csv is before run_10.csv). The 1st line (header) of each file after the 1st must be the same as the 1st line
+ of the 1st file, and is skipped. Offsets in the set are as if the files had been joined together with cat (headers included).
+
+ Written by Peter Miller 17/10/2026
+
+ */
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h> /* for malloc() and free() */
+#include <string.h> /* for memchr() etc */
+#include <wctype.h> /* for iswdigit() */
+#include "csv-reader.h"
+#include "expr-code.h" /* for readline() */
+#include "csv-decompress.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h> /* for _open_osfhandle() */
+#include <fcntl.h> /* for _O_RDONLY etc */
+#define csv_fseek _fseeki64
+#define csv_ftell _ftelli64
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glob.h> /* to expand wildcards in a set of files */
+#define csv_fseek fseeko
+#define csv_ftell ftello
+#endif
+
+#define CSV_VIEW_SIZE (64*1024*1024) /* size of each memory mapped view of the file, must be a multiple of the allocation granularity (64K on windows, the pagesize on linux) */
+#define CSV_READ_BUF_SIZE (128*1024) /* buffer size when file is not mapped. Testing showed 4K is the min for moderate performance, and after 256k performance gets slightly worse */
+  /* times to read 2 columns from a 2BG file are no buf 126secs, 4k 78s, 8k 72s, 16k 71s, 32k 70s, 64k 69s, 128k 68s, 256k 68s, 512k 69s, 1024k 69s, 4096k 71s */
+#define CSV_MAX_LINE_SIZE 1048576 /* same as MAX_LIN_SIZE in readline(), longer lines are truncated (avoids a "silly" file causing issues) */
+
+struct s_csv_reader
+	{bool mapped;         // true if file is memory mapped
+	 int64_t filesize;
+	 int64_t end;         // only lines that start before this offset are returned (normally filesize, but set by csv_open_part() )
+	 /* used when the file is not memory mapped */
+	 FILE *fp;
+	 char *read_buf;      // buffer for setvbuf()
+	 csv_decomp *decomp;  // not NULL if file is compressed (or read_ahead is true), view, view_len and pos are then used for the current block of decompressed data
+	 bool read_ahead;     // true if decomp is just reading ahead in a file that is not compressed
+	 int64_t read_ahead_start; // offset in file where read ahead started
+	 /* used when the file is memory mapped */
+#ifdef _WIN32
+	 HANDLE hFile,hMap;
+#else
+	 int fd;
+#endif
+	 size_t granularity;  // views must start at a multiple of this
+	 char *view;          // start of current view of the file (NULL if none)
+	 int64_t view_offset; // offset in file of view[0]
+	 size_t view_len;     // number of bytes in current view
+	 size_t pos;          // offset in view of the start of the next line
+	 bool skip_to_nl;     // true if the last line was too long and was truncated, so the rest of it needs to be skipped
+	 char *line_buf;      // only used for the last line in the file if it does not end with a \n (as there may not be space to add a \0 in the view), or for lines split over 2 blocks of a compressed file
+	 /* used when reading a stream (stdin or a pipe) */
+	 bool stream;         // true if file is a stream (which cannot be seeked)
+	 int64_t stream_pos;  // bytes read from the stream so far
+	 char *kept;          // lines read so far (each ends with a \0) so they can be read again, NULL once they are no longer kept
+	 size_t kept_len,kept_size; // bytes used in kept[] and its size
+	 size_t kept_pos;     // offset in kept[] of the next line to return if replaying is true
+	 bool replaying;      // true if lines are being returned from kept[]
+	 /* used when reading a set of files as one file */
+	 bool is_set;         // true if this is a set of files (set may still be NULL if it could not be opened)
+	 struct csv_set_file *set; // files in the set (in the order they are read), NULL if not a set
+	 int set_nos;         // number of files in set[]
+	 int set_cur;         // index in set[] of the file being read by set_r
+	 csv_reader *set_r;   // reader for set[set_cur], NULL at the end of the set
+	 bool set_mapped;     // true if all the files in the set are memory mapped (so csv_open_part() can be used)
+	 bool set_compressed; // true if any of the files in the set are compressed
+	 bool set_part;       // true if set opened by csv_open_part() (end is then used)
+	 char *set_hdr;       // 1st line of the 1st file
+	 const char *set_error; // NULL if no error
+	 char set_msg[256];   // set_error may point here
+	};
+
+struct csv_set_file
+	{wchar_t *name;
+	 int64_t start;       // offset of this file in the set (the sum of the sizes of the files before it)
+	 int64_t size;
+	};
+
+static csv_reader *set_open(const wchar_t *filename);
+static bool set_open_file(csv_reader *r,int k,int64_t offset);
+
+static void unmap_view(csv_reader *r)
+{if(r->view==NULL) return;
+#ifdef _WIN32
+ UnmapViewOfFile(r->view);
+#else
+ munmap(r->view,r->view_len);
+#endif
+ r->view=NULL;
+}
+
+static bool map_view(csv_reader *r,int64_t offset) /* map a view of the file that includes offset, sets r->pos to point to offset. returns false on error */
+{unmap_view(r);
+ r->view_offset=offset & ~(int64_t)(r->granularity-1);
+ r->view_len= (r->filesize-r->view_offset) > CSV_VIEW_SIZE ? CSV_VIEW_SIZE : (size_t)(r->filesize-r->view_offset);
+ r->pos=(size_t)(offset-r->view_offset);
+#ifdef _WIN32
+ r->view=(char *)MapViewOfFile(r->hMap,FILE_MAP_COPY,(DWORD)((uint64_t)r->view_offset>>32),(DWORD)(r->view_offset & 0xffffffff),r->view_len);
+#else
+ void *p=mmap(NULL,r->view_len,PROT_READ|PROT_WRITE,MAP_PRIVATE,r->fd,(off_t)r->view_offset);
+ r->view= p==MAP_FAILED ? NULL : (char *)p;
+ if(r->view!=NULL) madvise(p,r->view_len,MADV_WILLNEED); // start reading the view from disk now, rather than a page at a time as its used
+#endif
+ return r->view!=NULL;
+}
+
+static csv_reader *stream_open(csv_reader *r,FILE *fp) /* finish opening r to read stream fp (stdin or a pipe), returns NULL (after freeing r) on error */
+{r->fp=fp;
+ if(r->fp==NULL)
+	{free(r);
+	 return NULL;
+	}
+ r->stream=true;
+ r->filesize=0; // size of a stream is unknown
+ r->kept_size=64*1024; // grows if required
+ r->kept=(char *)malloc(r->kept_size);
+ r->read_buf=(char *)malloc(CSV_READ_BUF_SIZE);
+ if(r->read_buf!=NULL)
+	setvbuf(r->fp,r->read_buf,_IOFBF,CSV_READ_BUF_SIZE); // buffer input if we have free RAM
+ return r;
+}
+
+static void start_read_ahead(csv_reader *r) /* start reading ahead in a file that is not compressed from the current position of r->fp, if this fails readline() is used */
+{r->view_len=0; // no block read yet
+ r->pos=0;
+ r->skip_to_nl=false;
+ r->read_ahead_start=csv_ftell(r->fp);
+ if(r->line_buf==NULL) r->line_buf=(char *)malloc(CSV_MAX_LINE_SIZE);
+ if(r->line_buf!=NULL && (r->decomp=csv_read_ahead_open(r->fp,0))!=NULL && csv_decomp_error(r->decomp)!=NULL)
+	{csv_decomp_close(r->decomp); // thread could not be started
+	 r->decomp=NULL;
+	}
+ r->read_ahead= r->decomp!=NULL;
+}
+
+static void stop_read_ahead(csv_reader *r) /* stop reading ahead, so the file can be seeked */
+{if(!r->read_ahead) return;
+ csv_decomp_close(r->decomp);
+ r->decomp=NULL;
+ r->read_ahead=false;
+}
+
+csv_reader *csv_open(const wchar_t *filename) /* open filename for reading, returns NULL on error */
+{csv_reader *r;
+ if(wcspbrk(filename,L"|*?")!=NULL) return set_open(filename); // a list of files, or a wildcard pattern
+ r=(csv_reader *)calloc(1,sizeof(csv_reader)); // calloc so all pointers start as NULL
+ if(r==NULL) return NULL;
+#ifdef _WIN32
+ SYSTEM_INFO si;
+ GetSystemInfo(&si);
+ r->granularity=si.dwAllocationGranularity;
+ if(wcscmp(filename,L"-")==0)
+	{// stdin, as csvgraph is a gui program use the windows handle as stdin may not be set up
+	 HANDLE h=GetStdHandle(STD_INPUT_HANDLE);
+	 int fd= (h==NULL || h==INVALID_HANDLE_VALUE) ? -1 : _open_osfhandle((intptr_t)h,_O_RDONLY|_O_BINARY);
+	 return stream_open(r,fd== -1 ? NULL : _fdopen(fd,"rb"));
+	}
+ r->hFile=CreateFileW(filename,               // file to open
+					  GENERIC_READ,          // open for reading
+					  FILE_SHARE_READ|FILE_SHARE_WRITE, // same sharing as _wfopen() (file may still be being written by a logger)
+					  NULL,                  // default security
+					  OPEN_EXISTING,         // existing file only
+					  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, // normal file  , will be read sequentially
+					  NULL);                 // no attr. template
+ if(r->hFile!=INVALID_HANDLE_VALUE && GetFileType(r->hFile)!=FILE_TYPE_DISK)
+	{// a pipe (or similar) which cannot be mapped or seeked. The handle must be kept as closing it would disconnect a pipe
+	 int fd=_open_osfhandle((intptr_t)r->hFile,_O_RDONLY|_O_BINARY);
+	 FILE *fp=NULL;
+	 if(fd== -1) CloseHandle(r->hFile);
+	 else if((fp=_fdopen(fd,"rb"))==NULL) _close(fd); // this also closes r->hFile
+	 return stream_open(r,fp);
+	}
+ if(r->hFile!=INVALID_HANDLE_VALUE)
+	{LARGE_INTEGER size;
+	 if(GetFileSizeEx(r->hFile,&size) && size.QuadPart>0)  // cannot map an empty file
+		{r->filesize=size.QuadPart;
+		 r->hMap=CreateFileMappingW(r->hFile,NULL,PAGE_WRITECOPY,0,0,NULL);
+		 if(r->hMap!=NULL && map_view(r,0) && csv_decomp_type((unsigned char *)r->view,r->view_len)==CSV_DECOMP_NONE)
+			{r->mapped=true;
+			 r->end=r->filesize;
+			 return r;
+			}
+		 unmap_view(r);
+		 if(r->hMap!=NULL) CloseHandle(r->hMap);
+		}
+	 CloseHandle(r->hFile);
+	}
+ // cannot map file (or its compressed), so use buffered reads instead
+ r->fp=_wfopen(filename,L"rb");
+#else
+ char *cfilename;
+ size_t len=wcstombs(NULL,filename,0);
+ if(len==(size_t)-1 || (cfilename=(char *)malloc(len+1))==NULL)
+	{free(r);
+	 return NULL;
+	}
+ wcstombs(cfilename,filename,len+1);
+ r->granularity=(size_t)sysconf(_SC_PAGESIZE);
+ if(strcmp(cfilename,"-")==0)
+	{free(cfilename);
+	 return stream_open(r,stdin);
+	}
+ r->fd=open(cfilename,O_RDONLY);
+ if(r->fd!= -1)
+	{struct stat st;
+	 if(fstat(r->fd,&st)==0 && !S_ISREG(st.st_mode))
+		{// a pipe (fifo) or similar which cannot be mapped or seeked
+		 FILE *fp=fdopen(r->fd,"rb");
+		 free(cfilename);
+		 if(fp==NULL) close(r->fd);
+		 return stream_open(r,fp);
+		}
+	 if(fstat(r->fd,&st)==0 && st.st_size>0)  // cannot map an empty file
+		{r->filesize=(int64_t)st.st_size;
+		 if(map_view(r,0) && csv_decomp_type((unsigned char *)r->view,r->view_len)==CSV_DECOMP_NONE)
+			{r->mapped=true;
+			 r->end=r->filesize;
+			 free(cfilename);
+			 return r;
+			}
+		 unmap_view(r);
+		}
+	 close(r->fd);
+	}
+ // cannot map file (or its compressed), so use buffered reads instead
+ r->fp=fopen(cfilename,"rb");
+ free(cfilename);
+#endif
+ if(r->fp==NULL)
+	{free(r);
+	 return NULL;
+	}
+ csv_fseek(r->fp, 0, SEEK_END);  // seek to end of file
+ r->filesize=csv_ftell(r->fp); // get size of file
+ csv_fseek(r->fp,0,SEEK_SET); // back to start of file
+ unsigned char magic[4];
+ int type=CSV_DECOMP_NONE;
+ if(fread(magic,1,sizeof(magic),r->fp)>=2) type=csv_decomp_type(magic,sizeof(magic));
+ csv_fseek(r->fp,0,SEEK_SET); // back to start of file
+ if(type!=CSV_DECOMP_NONE)
+	{// compressed file, decompress it (in another thread) as its read
+	 r->view_len=0; // no block of decompressed data yet (view_len may have been set when trying to map the file)
+	 r->pos=0;
+	 r->line_buf=(char *)malloc(CSV_MAX_LINE_SIZE);
+	 if(r->line_buf==NULL || (r->decomp=csv_decomp_open(r->fp,type))==NULL)
+		{csv_close(r);
+		 return NULL;
+		}
+	 return r;
+	}
+ r->read_buf=(char *)malloc(CSV_READ_BUF_SIZE);
+ if(r->read_buf!=NULL)
+	setvbuf(r->fp,r->read_buf,_IOFBF,CSV_READ_BUF_SIZE); // buffer input if we have free RAM (still used by readline() after csv_seek_line() )
+ start_read_ahead(r);
+ return r;
+}
+
+csv_reader *csv_open_part(const wchar_t *filename,int64_t start,int64_t end) /* as csv_open() but only returns lines that start at offsets start..end-1 in the file. File must be memory mapped (returns NULL otherwise) */
+{csv_reader *r=csv_open(filename);
+ if(r==NULL) return NULL;
+ if(r->set!=NULL && r->set_mapped)
+	{// each thread reads the lines of the set that start in start..end-1, which may be in several files
+	 int k=0;
+	 r->set_part=true;
+	 if(end<r->end) r->end=end;
+	 while(k+1<r->set_nos && r->set[k+1].start<=start) ++k;
+	 if(start<r->end && set_open_file(r,k,start>r->set[k].start ? start-r->set[k].start : 0)) return r;
+	 csv_close(r->set_r); // nothing to read (or an error)
+	 r->set_r=NULL;
+	 return r;
+	}
+ if(!r->mapped)
+	{csv_close(r); // cannot read parts of a file if its not memory mapped
+	 return NULL;
+	}
+ if(end<r->end) r->end=end;
+ if(start>=r->end)
+	r->end=0; // nothing to read
+ else if(start>0)
+	{// start is probably in the middle of a line (which belongs to the previous part) so skip to the start of the next line
+	 // start from the character before start so if that is a \n the line that starts at start is returned
+	 if(!map_view(r,start-1))
+		{csv_close(r);
+		 return NULL;
+		}
+	 r->skip_to_nl=true;
+	}
+ return r;
+}
+
+static char *mapped_readline(csv_reader *r) /* get next line from memory mapped file */
+{char *start,*nl;
+ size_t left;
+ while(1)
+	{if(r->view_offset+(int64_t)r->pos>=r->end)
+		return NULL; // EOF (or end of this part of the file)
+	 if(r->pos>=r->view_len)
+		{// at end of this view, map the next one
+		 if(!map_view(r,r->view_offset+(int64_t)r->pos))
+			return NULL;
+		}
+	 start=r->view+r->pos;
+	 left=r->view_len-r->pos;
+	 nl=(char *)memchr(start,'\n',left);
+	 if(r->skip_to_nl)
+		{// skip the rest of a line that was too long
+		 r->pos= nl==NULL ? r->view_len : (size_t)(nl-r->view)+1;
+		 if(nl!=NULL) r->skip_to_nl=false;
+		 continue;
+		}
+	 if(nl!=NULL)
+		{// normal case - whole line is in the current view
+		 if(nl-start>=CSV_MAX_LINE_SIZE)
+			start[CSV_MAX_LINE_SIZE-1]=0; // truncate very long lines (as readline() does)
+		 *nl=0; // replace \n with end of string, the view is "copy on write" so this does not change the file
+		 r->pos=(size_t)(nl-r->view)+1;
+		 return start;
+		}
+	 if(r->view_offset+(int64_t)r->view_len>=r->filesize)
+		{// last line in file does not end with a \n, take a copy so we can add a \0 at the end
+		 size_t len= left>=CSV_MAX_LINE_SIZE ? CSV_MAX_LINE_SIZE-1 : left;
+		 char *new_buf=(char *)realloc(r->line_buf,len+1);
+		 if(new_buf==NULL) return NULL;
+		 r->line_buf=new_buf;
+		 memcpy(new_buf,start,len);
+		 new_buf[len]=0;
+		 r->pos=r->view_len;
+		 return new_buf;
+		}
+	 if(r->pos>=r->granularity)
+		{// line goes past the end of the view, remap so view starts with this line
+		 if(!map_view(r,r->view_offset+(int64_t)r->pos))
+			return NULL;
+		 continue;
+		}
+	 // line is longer than the view (which is much bigger than CSV_MAX_LINE_SIZE), truncate it and skip the rest of it next time
+	 start[CSV_MAX_LINE_SIZE-1]=0;
+	 r->pos=r->view_len;
+	 r->skip_to_nl=true;
+	 return start;
+	}
+}
+
+static char *decomp_readline(csv_reader *r) /* get next line from a compressed file */
+{char *start,*nl;
+ size_t left,len;
+ size_t copied=0; // length of line copied into line_buf so far (when a line is split over 2 or more blocks)
+ bool copying=false;
+ while(1)
+	{if(r->pos>=r->view_len)
+		{// used all of this block, get the next one
+		 r->view_len=csv_decomp_read(r->decomp,&r->view);
+		 r->pos=0;
+		 if(r->view_len==0)
+			{// EOF (or an error, which is found by csv_error() )
+			 if(!copying) return NULL;
+			 r->line_buf[copied]=0; // last line in file does not end with a \n
+			 return r->line_buf;
+			}
+		}
+	 start=r->view+r->pos;
+	 left=r->view_len-r->pos;
+	 nl=(char *)memchr(start,'\n',left);
+	 len= nl==NULL ? left : (size_t)(nl-start);
+	 r->pos+= nl==NULL ? left : len+1;
+	 if(r->skip_to_nl)
+		{// skip the rest of a line that was too long
+		 if(nl!=NULL) r->skip_to_nl=false;
+		 continue;
+		}
+	 if(!copying && nl!=NULL)
+		{// normal case - whole line is in the current block
+		 if(len>=CSV_MAX_LINE_SIZE)
+			start[CSV_MAX_LINE_SIZE-1]=0; // truncate very long lines (as readline() does)
+		 *nl=0; // replace \n with end of string
+		 return start;
+		}
+	 // line continues in the next block, so it needs to be copied
+	 copying=true;
+	 if(copied+len>=CSV_MAX_LINE_SIZE)
+		{// line is too long, truncate it (and skip the rest of it next time if we have not yet found its end)
+		 len=CSV_MAX_LINE_SIZE-1-copied;
+		 memcpy(r->line_buf+copied,start,len);
+		 r->line_buf[CSV_MAX_LINE_SIZE-1]=0;
+		 if(nl==NULL) r->skip_to_nl=true;
+		 return r->line_buf;
+		}
+	 memcpy(r->line_buf+copied,start,len);
+	 copied+=len;
+	 if(nl!=NULL)
+		{r->line_buf[copied]=0;
+		 return r->line_buf;
+		}
+	}
+}
+
+static char *stream_readline(csv_reader *r) /* get next line from a stream */
+{char *line;
+ size_t len;
+ if(r->replaying)
+	{if(r->kept_pos<r->kept_len)
+		{// return a copy of a kept line (as the caller may change it)
+		 len=strlen(r->kept+r->kept_pos);
+		 if(r->line_buf==NULL && (r->line_buf=(char *)malloc(CSV_MAX_LINE_SIZE))==NULL) return NULL;
+		 memcpy(r->line_buf,r->kept+r->kept_pos,len+1); // kept lines come from readline() so are less than CSV_MAX_LINE_SIZE long
+		 r->kept_pos+=len+1;
+		 r->stream_pos+=(int64_t)len;
+		 return r->line_buf;
+		}
+	 // all kept lines have been read again, from now on lines are not kept (so all of a big stream is not saved in RAM)
+	 r->replaying=false;
+	 free(r->kept);
+	 r->kept=NULL;
+	}
+ line=readline(r->fp);
+ if(line==NULL) return NULL;
+ len=strlen(line);
+ r->stream_pos+=(int64_t)len; // readline() leaves the \n at the end of the line
+ if(r->kept!=NULL)
+	{if(r->kept_len+len+1>r->kept_size)
+		{size_t new_size=2*(r->kept_len+len+1);
+		 char *new_kept=(char *)realloc(r->kept,new_size);
+		 if(new_kept==NULL)
+			{free(r->kept); // cannot keep all the lines, so csv_seek() will fail
+			 r->kept=NULL;
+			 return line;
+			}
+		 r->kept=new_kept;
+		 r->kept_size=new_size;
+		}
+	 memcpy(r->kept+r->kept_len,line,len+1);
+	 r->kept_len+=len+1;
+	}
+ return line;
+}
+
+static int natural_cmp(const wchar_t *a,const wchar_t *b) /* compare filenames with numbers in them compared as numbers (so run_2.csv is before run_10.csv) */
+{while(*a && *b)
+	{if(iswdigit(*a) && iswdigit(*b))
+		{const wchar_t *ea,*eb;
+		 while(*a==L'0' && iswdigit(a[1])) ++a; // ignore leading zeros
+		 while(*b==L'0' && iswdigit(b[1])) ++b;
+		 for(ea=a;iswdigit(*ea);++ea);
+		 for(eb=b;iswdigit(*eb);++eb);
+		 if(ea-a!=eb-b) return ea-a<eb-b ? -1 : 1; // more digits is a bigger number
+		 for(;a<ea;++a,++b)
+			if(*a!=*b) return *a<*b ? -1 : 1;
+		 continue;
+		}
+	 if(towlower(*a)!=towlower(*b)) return towlower(*a)<towlower(*b) ? -1 : 1;
+	 ++a;
+	 ++b;
+	}
+ return *a ? 1 : (*b ? -1 : 0);
+}
+
+static int set_file_cmp(const void *a,const void *b) /* for qsort() */
+{const wchar_t *na=((const struct csv_set_file *)a)->name,*nb=((const struct csv_set_file *)b)->name;
+ int c=natural_cmp(na,nb);
+ return c!=0 ? c : wcscmp(na,nb);
+}
+
+static bool set_add(csv_reader *r,const wchar_t *dir,size_t dir_len,const wchar_t *name) /* add file dir[0..dir_len-1]name to the set, returns false if out of RAM */
+{size_t len=wcslen(name);
+ wchar_t *n=(wchar_t *)malloc((dir_len+len+1)*sizeof(wchar_t));
+ struct csv_set_file *new_set=(struct csv_set_file *)realloc(r->set,(size_t)(r->set_nos+1)*sizeof(struct csv_set_file));
+ if(new_set!=NULL) r->set=new_set;
+ if(n==NULL || new_set==NULL)
+	{if(n!=NULL) free(n);
+	 return false;
+	}
+ memcpy(n,dir,dir_len*sizeof(wchar_t));
+ memcpy(n+dir_len,name,(len+1)*sizeof(wchar_t));
+ r->set[r->set_nos].name=n;
+ r->set[r->set_nos].start=0;
+ r->set[r->set_nos].size=0;
+ r->set_nos++;
+ return true;
+}
+
+static bool set_add_pattern(csv_reader *r,const wchar_t *pattern) /* add files matching pattern (which may contain wildcards) to the set, returns false if out of RAM */
+{bool ok=true;
+ if(wcspbrk(pattern,L"*?")==NULL) return set_add(r,L"",0,pattern); // just a filename
+#ifdef _WIN32
+ WIN32_FIND_DATAW fd;
+ size_t dir_len=wcslen(pattern);
+ HANDLE h=FindFirstFileW(pattern,&fd);
+ while(dir_len>0 && pattern[dir_len-1]!=L'\\' && pattern[dir_len-1]!=L'/' && pattern[dir_len-1]!=L':') --dir_len; // FindFirstFileW() only gives the filename, so keep the directory from pattern
+ if(h==INVALID_HANDLE_VALUE) return true; // no matching files
+ do
+	{if(!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		ok=set_add(r,pattern,dir_len,fd.cFileName);
+	} while(ok && FindNextFileW(h,&fd));
+ FindClose(h);
+#else
+ glob_t g;
+ char *cpattern;
+ size_t len=wcstombs(NULL,pattern,0);
+ if(len==(size_t)-1 || (cpattern=(char *)malloc(len+1))==NULL) return false;
+ wcstombs(cpattern,pattern,len+1);
+ if(glob(cpattern,0,NULL,&g)==0)
+	{for(size_t i=0;ok && i<g.gl_pathc;++i)
+		{size_t wlen=mbstowcs(NULL,g.gl_pathv[i],0);
+		 wchar_t *wname;
+		 if(wlen==(size_t)-1) continue;
+		 if((wname=(wchar_t *)malloc((wlen+1)*sizeof(wchar_t)))==NULL)
+			{ok=false;
+			 break;
+			}
+		 mbstowcs(wname,g.gl_pathv[i],wlen+1);
+		 ok=set_add(r,L"",0,wname);
+		 free(wname);
+		}
+	 globfree(&g);
+	}
+ free(cpattern);
+#endif
+ return ok;
+}
+
+static void set_starts(csv_reader *r) /* set the offset of each file in the set, and the size of the set */
+{int64_t start=0;
+ for(int i=0;i<r->set_nos;++i)
+	{r->set[i].start=start;
+	 start+=r->set[i].size;
+	}
+ r->filesize=start;
+ r->end=start;
+}
+
+static csv_reader *set_open(const wchar_t *filename) /* open a list of files separated by | (each of which may contain wildcards) as one file, returns NULL on error */
+{csv_reader *r=(csv_reader *)calloc(1,sizeof(csv_reader)); // calloc so all pointers start as NULL
+ const wchar_t *p=filename;
+ bool ok=true;
+ if(r==NULL) return NULL;
+ r->is_set=true;
+ while(ok && *p)
+	{// split filename at each |
+	 size_t len=wcscspn(p,L"|");
+	 if(len>0)
+		{wchar_t *pattern=(wchar_t *)malloc((len+1)*sizeof(wchar_t));
+		 if(pattern==NULL)
+			ok=false;
+		 else
+			{memcpy(pattern,p,len*sizeof(wchar_t));
+			 pattern[len]=0;
+			 ok=set_add_pattern(r,pattern);
+			 free(pattern);
+			}
+		}
+	 p+=len;
+	 if(*p==L'|') ++p;
+	}
+ if(!ok || r->set_nos==0)
+	{csv_close(r);
+	 return NULL;
+	}
+ if(r->set_nos==1)
+	{// just 1 file, so no need for a set
+	 csv_reader *r1=csv_open(r->set[0].name);
+	 csv_close(r);
+	 return r1;
+	}
+ qsort(r->set,(size_t)r->set_nos,sizeof(struct csv_set_file),set_file_cmp);
+ r->set_mapped=true;
+ for(int i=0;i<r->set_nos;++i)
+	{// find the size and type of every file
+	 csv_reader *f=csv_open(r->set[i].name);
+	 if(f==NULL || f->stream || f->set!=NULL)
+		{csv_close(f);
+		 csv_close(r);
+		 return NULL;
+		}
+	 r->set[i].size=f->filesize;
+	 if(!f->mapped) r->set_mapped=false;
+	 if(csv_is_compressed(f)) r->set_compressed=true;
+	 if(i==0)
+		{char *hdr=csv_readline(f);
+		 if(hdr==NULL) hdr=(char *)"";
+		 if((r->set_hdr=(char *)malloc(strlen(hdr)+1))!=NULL) strcpy(r->set_hdr,hdr);
+		}
+	 csv_close(f);
+	}
+ set_starts(r);
+ if(r->set_hdr==NULL || !set_open_file(r,0,0))
+	{csv_close(r);
+	 return NULL;
+	}
+ return r;
+}
+
+static bool set_open_file(csv_reader *r,int k,int64_t offset) /* start reading set[k] at offset in it (which must be the start of a line, unless the set was opened by csv_open_part() ).
+																   The 1st line of each file after the 1st is checked and skipped. Returns false at the end of the set or on an error */
+{csv_reader *f=NULL;
+ if(r->set_r!=NULL && r->set_cur==k && !r->set_part && csv_seek(r->set_r,offset))
+	f=r->set_r; // same file, just move in it
+ else
+	{csv_close(r->set_r);
+	 r->set_r=NULL;
+	 r->set_cur=k;
+	 if(k>=r->set_nos || r->set[k].start>=r->end) return false; // end of the set (or of this part of it)
+	 if(r->set_part)
+		f=csv_open_part(r->set[k].name,offset,r->end-r->set[k].start);
+	 else if((f=csv_open(r->set[k].name))!=NULL && offset>0 && !csv_seek(f,offset))
+		{csv_close(f);
+		 f=NULL;
+		}
+	 if(f==NULL)
+		{snprintf(r->set_msg,sizeof(r->set_msg),"cannot read file %ls",r->set[k].name);
+		 r->set_error=r->set_msg;
+		 return false;
+		}
+	 r->set_r=f;
+	}
+ if(k>0 && offset==0)
+	{// skip header line, which must be the same as the header of the 1st file
+	 char *hdr=csv_readline(f);
+	 if(hdr!=NULL && strcmp(hdr,r->set_hdr)!=0)
+		{snprintf(r->set_msg,sizeof(r->set_msg),"the 1st line of %ls is not the same as the 1st line of %ls",r->set[k].name,r->set[0].name);
+		 r->set_error=r->set_msg;
+		 csv_close(f);
+		 r->set_r=NULL;
+		 return false;
+		}
+	}
+ return true;
+}
+
+static char *set_readline(csv_reader *r) /* get next line from a set of files */
+{char *line;
+ while(r->set_r!=NULL)
+	{if((line=csv_readline(r->set_r))!=NULL) return line;
+	 if(csv_error(r->set_r)!=NULL)
+		{snprintf(r->set_msg,sizeof(r->set_msg),"%ls: %s",r->set[r->set_cur].name,csv_error(r->set_r));
+		 r->set_error=r->set_msg;
+		 return NULL;
+		}
+	 if(!set_open_file(r,r->set_cur+1,0)) return NULL; // move on to the next file
+	}
+ return NULL;
+}
+
+static int set_find(csv_reader *r,int64_t offset) /* returns index of the file in the set that contains offset */
+{int lo=0,hi=r->set_nos-1;
+ while(lo<hi)
+	{int mid=lo+(hi-lo+1)/2;
+	 if(r->set[mid].start<=offset) lo=mid;
+	 else hi=mid-1;
+	}
+ return lo;
+}
+
+char *csv_readline(csv_reader *r) /* returns next line from file (which may be changed by caller eg by parsecsv() ), or NULL at EOF. The line is only valid till the next call */
+{if(r->set!=NULL) return set_readline(r);
+ if(r->mapped) return mapped_readline(r);
+ if(r->decomp!=NULL) return decomp_readline(r);
+ if(r->stream) return stream_readline(r);
+ return readline(r->fp);
+}
+
+bool csv_seek(csv_reader *r,int64_t offset) /* move to offset in file, which must be the start of a line (eg found by count_lines() ). Returns false on error */
+{if(r->set!=NULL)
+	{int k;
+	 if(offset<0 || offset>=r->filesize) return false;
+	 k=set_find(r,offset);
+	 r->set_error=NULL;
+	 return set_open_file(r,k,offset-r->set[k].start);
+	}
+ if(r->stream)
+	{// can only go back to the start of a stream, and only while all the lines read are still kept
+	 if(offset!=0 || r->kept==NULL) return false;
+	 r->replaying=true;
+	 r->kept_pos=0;
+	 r->stream_pos=0;
+	 return true;
+	}
+ if(offset<0 || offset>=r->filesize || (r->decomp!=NULL && !r->read_ahead)) return false; // cannot seek in a compressed file
+ if(r->mapped)
+	{int64_t old_offset=r->view_offset+(int64_t)r->pos;
+	 if(!map_view(r,offset))
+		{map_view(r,old_offset); // try to leave position unchanged
+		 return false;
+		}
+	 r->skip_to_nl=false;
+	 return true;
+	}
+ stop_read_ahead(r);
+ if(csv_fseek(r->fp,offset,SEEK_SET)!=0) return false;
+ start_read_ahead(r); // the file will normally be read sequentially from here
+ return true;
+}
+
+bool csv_seek_line(csv_reader *r,int64_t offset) /* move to the start of the 1st line that starts at or after offset (which can be anywhere in the file). Returns false on error or if there is no such line */
+{if(offset<=0) return csv_seek(r,0);
+ if(r->set!=NULL)
+	{int k;
+	 if(offset>=r->filesize) return false;
+	 k=set_find(r,offset);
+	 if(!csv_seek(r,r->set[k].start)) return false; // start of file k (after its header if k>0)
+	 if(offset==r->set[k].start || csv_tell(r)>=offset) return true;
+	 if(csv_seek_line(r->set_r,offset-r->set[k].start)) return true;
+	 return set_open_file(r,k+1,0); // no line starts in the rest of file k
+	}
+ if(!r->mapped && !r->stream && (r->decomp==NULL || r->read_ahead))
+	{// used to read samples from a file, so reading ahead would waste time reading data that is not used - use readline() till the next csv_seek()
+	 stop_read_ahead(r);
+	 if(offset>r->filesize || csv_fseek(r->fp,offset-1,SEEK_SET)!=0) return false;
+	}
+ else if(!csv_seek(r,offset-1)) return false;
+ return csv_readline(r)!=NULL; // skip rest of line containing offset-1 (which is just its '\n' if offset is the start of a line)
+}
+
+int64_t csv_tell(csv_reader *r) /* returns current position in file (in bytes) - used to show progress. For a compressed file this is the position in the compressed file */
+{if(r->set!=NULL) return r->set_r!=NULL ? r->set[r->set_cur].start+csv_tell(r->set_r) : r->end;
+ if(r->mapped) return r->view_offset+(int64_t)r->pos;
+ if(r->read_ahead) return r->read_ahead_start+csv_decomp_tell(r->decomp,r->pos);
+ if(r->decomp!=NULL) return csv_decomp_tell(r->decomp,r->pos);
+ if(r->stream) return r->stream_pos;
+ return csv_ftell(r->fp);
+}
+
+int64_t csv_filesize(csv_reader *r) /* returns size of file in bytes */
+{return r->filesize;
+}
+
+bool csv_is_mapped(csv_reader *r) /* returns true if file is memory mapped, false if its being read via buffered i/o */
+{if(r->set!=NULL) return r->set_mapped;
+ return r->mapped;
+}
+
+bool csv_is_compressed(csv_reader *r) /* returns true if file is compressed (so csv_seek() cannot be used and its size is unknown till its all been read) */
+{if(r->set!=NULL) return r->set_compressed;
+ return r->decomp!=NULL && !r->read_ahead;
+}
+
+bool csv_is_stream(csv_reader *r) /* returns true if file is stdin or a pipe (so csv_seek() can only be used to go back to the start, csv_filesize() returns 0 and the file cannot be opened again) */
+{return r->stream;
+}
+
+int csv_nos_files(csv_reader *r) /* returns the number of files being read (more than 1 for a set of files) */
+{return r->set!=NULL ? r->set_nos : 1;
+}
+
+const wchar_t *csv_file_name(csv_reader *r,int i) /* returns the name of file i (0..csv_nos_files(r)-1) of a set in the order they are read, or NULL if r is not a set */
+{if(r->set==NULL || i<0 || i>=r->set_nos) return NULL;
+ return r->set[i].name;
+}
+
+bool csv_order_files(csv_reader *r,const int order[]) /* read the files of a set in the order given by order[] (a permutation of 0..csv_nos_files(r)-1), r is then at the start of the set. Returns false on error */
+{struct csv_set_file *new_set;
+ if(r->set==NULL || r->set_part) return false;
+ new_set=(struct csv_set_file *)calloc((size_t)r->set_nos,sizeof(struct csv_set_file));
+ if(new_set==NULL) return false;
+ for(int i=0;i<r->set_nos;++i)
+	{if(order[i]<0 || order[i]>=r->set_nos || r->set[order[i]].name==NULL)
+		{// not a permutation, put back the files already moved
+		 for(int j=0;j<i;++j)
+			r->set[order[j]]=new_set[j];
+		 free(new_set);
+		 return false;
+		}
+	 new_set[i]=r->set[order[i]];
+	 r->set[order[i]].name=NULL; // so a repeated entry in order[] is found
+	}
+ free(r->set);
+ r->set=new_set;
+ set_starts(r);
+ csv_close(r->set_r); // file being read has moved
+ r->set_r=NULL;
+ return csv_seek(r,0);
+}
+
+const char *csv_error(csv_reader *r) /* returns NULL if no error, otherwise a description of why csv_readline() returned NULL before the end of the file */
+{if(r->set!=NULL) return r->set_error;
+ if(r->decomp!=NULL) return csv_decomp_error(r->decomp);
+ return NULL;
+}
+
+void csv_close(csv_reader *r) /* close file and free all memory used */
+{if(r==NULL) return;
+ if(r->is_set)
+	{// a set of files
+	 csv_close(r->set_r);
+	 for(int i=0;i<r->set_nos;++i)
+		free(r->set[i].name);
+	 if(r->set!=NULL) free(r->set);
+	 if(r->set_hdr!=NULL) free(r->set_hdr);
+	 free(r);
+	 return;
+	}
+ csv_decomp_close(r->decomp); // must be before fclose() as decompression thread reads from the file. csv_decomp_close(NULL) is OK
+ if(r->mapped)
+	{unmap_view(r);
+#ifdef _WIN32
+	 CloseHandle(r->hMap);
+	 CloseHandle(r->hFile);
+#else
+	 close(r->fd);
+#endif
+	}
+ else
+	{fclose(r->fp);
+	 if(r->read_buf!=NULL) free(r->read_buf); // must be after fclose() as its used by the FILE
+	}
+ if(r->line_buf!=NULL) free(r->line_buf);
+ if(r->kept!=NULL) free(r->kept);
+ free(r);
+}
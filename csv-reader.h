@@ -0,0 +1,64 @@
+/* csv-reader.h
+ header file for csv-reader.c
+
+ Reads a csv file a line at a time using a memory mapped "view" into the file if possible (so there is no copy of each line),
+ falling back to buffered reads via readline() if the file cannot be mapped.
+ gzip and zstd compressed files are decompressed as they are read.
+ stdin (filename "-") and pipes are read as a stream which cannot be seeked (except back to the start, to read the header again).
+ A list of files separated by | , or a filename with wildcards (eg run_*.csv), is read as one file (a "set" of files), skipping the header line of all but the 1st file.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#ifndef _csv_reader_h
+ #define _csv_reader_h
+ #include <stdbool.h> /* as bool used below */
+ #include <stdint.h> /* for int64_t */
+ #include <wchar.h> /* for wchar_t */
+ #ifdef __cplusplus
+  extern "C" {
+ #endif
+typedef struct s_csv_reader csv_reader;
+
+csv_reader *csv_open(const wchar_t *filename); /* open filename for reading, returns NULL on error */
+csv_reader *csv_open_part(const wchar_t *filename,int64_t start,int64_t end); /* as csv_open() but only returns lines that start at offsets start..end-1 in the file. File must be memory mapped (returns NULL otherwise) */
+char *csv_readline(csv_reader *r); /* returns next line from file (which may be changed by caller eg by parsecsv() ), or NULL at EOF. The line is only valid till the next call */
+bool csv_seek(csv_reader *r,int64_t offset); /* move to offset in file, which must be the start of a line (eg found by count_lines() ). Returns false on error. For a stream offset must be 0 (the lines already read are returned again) */
+bool csv_seek_line(csv_reader *r,int64_t offset); /* move to the 1st line that starts at or after offset (which does not need to be the start of a line). Returns false on error or at EOF */
+int64_t csv_tell(csv_reader *r); /* returns current position in file (in bytes) - used to show progress. For a compressed file this is the position in the compressed file */
+int64_t csv_filesize(csv_reader *r); /* returns size of file in bytes */
+bool csv_is_mapped(csv_reader *r); /* returns true if file is memory mapped, false if its being read via buffered i/o */
+bool csv_is_compressed(csv_reader *r); /* returns true if file is compressed (so csv_seek() cannot be used and its size is unknown till its all been read) */
+bool csv_is_stream(csv_reader *r); /* returns true if file is stdin or a pipe (so csv_seek() can only be used to go back to the start, csv_filesize() returns 0 and the file cannot be opened again) */
+int csv_nos_files(csv_reader *r); /* returns the number of files being read (more than 1 for a set of files) */
+const wchar_t *csv_file_name(csv_reader *r,int i); /* returns the name of file i (0..csv_nos_files(r)-1) of a set in the order they are read, or NULL if r is not a set */
+bool csv_order_files(csv_reader *r,const int order[]); /* read the files of a set in the order given by order[] (a permutation of 0..csv_nos_files(r)-1), r is then at the start of the set. Returns false on error */
+const char *csv_error(csv_reader *r); /* returns NULL if no error, otherwise a description of why csv_readline() returned NULL before the end of the file */
+void csv_close(csv_reader *r); /* close file and free all memory used */
+
+ #ifdef __cplusplus
+    }
+ #endif
+#endif
@@ -90,6 +90,14 @@ int WINAPI _tWinMain(HINSTANCE, HINSTANCE, LPTSTR, int)
 				  {
 				   proces_open_filename( Utf8Of(szArglist[1])); // open filename supplied on command line - just to peek at header row
 				  }
+		else if(szArglist != nullptr && nArgs>2)  // several filenames, read them as one file (a "set" of files, names are separated by | )
+				  {AnsiString names="";
+				   for(int i=1;i<nArgs;++i)
+						{if(i>1) names+="|";
+						 names+=Utf8Of(szArglist[i]);
+						}
+				   proces_open_filename(names.c_str());
+				  }
 		 Application->Run();
 		}
  catch (Exception &exception)
@@ -67,6 +67,7 @@ double get_dollar_var_value(pnlist p); /* get value of $ variable */
 long double gethms(char *s); /* read a time of format hh:mm:ss.s , returns time in seconds */
 void reset_days(void);  /* reset static variables for gethms_days() - should be used before using gethms_days() to read times from a file  */
 long double gethms_days(char *s); /* read time in format hh:mm:ss.s , assumed to be called in sequence and accounts for days when time wraps around. Returns secs */
+long double gethms_days_fast(char *s); /* same as gethms_days(), but faster for hh:mm:ss and hh:mm:ss.s */
 
 
 double s_to_double(char *s); /* converts s to double if its a number, otherwise returns NAN */
@@ -77,6 +78,11 @@ bool last_expression_ok(void); /* returns true if last expression was correct in
 void print_rpn(void); /* for debugging - print out rpn "code" created by last call to to_rpn() or optimise_rpn() */
 void optimise_rpn(void); /* optimise rpn from previous call to to_rpn() */
 double execute_rpn(void); /* execute  rpn from a previous call to to_rpn() it & return the resultant value , 0 (and flag false) on error */
+typedef struct s_saved_rpn saved_rpn; /* a compiled expression saved by save_rpn() */
+saved_rpn *save_rpn(void); /* returns a malloc'ed copy of rpn from the last call to to_rpn()/optimise_rpn() (NULL on error) - allows multiple expressions to be used at once. free() when done */
+double execute_saved_rpn(saved_rpn *p); /* execute rpn previously saved by save_rpn() & return the resultant value , 0 (and flag false) on error */
+unsigned int rpn_max_dollar_col(void); /* returns highest n of any $n variable in the last expression compiled by to_rpn(), 0 if none - so only columns 1..n need to be read */
+unsigned int saved_rpn_max_dollar_col(saved_rpn *p); /* as rpn_max_dollar_col() for an expression saved by save_rpn() */
 bool check_function_tab(void); /* returns true if function table is valid, false if not */
 
 bool regex_match(char *regex, char *text); /* regex .^$* as special character (.=any char, ^ start, $ end, *=0+ occurances of previous char + = 1+ occurances */
@@ -126,6 +132,8 @@ unsigned int parsecsv(char *in,char *outfields[],unsigned int maxfields); /* cha
 	 "" inside a string is ignored (so the comma in ".."".,." is ignored) 
 	 \" inside a string is ignored (so the comma in "..\".,." is ignored) 	 
   */
+unsigned int parsecsv_noquotes(char *in,char *outfields[],unsigned int maxfields); /* char *outfields[maxfields] needed */
+  /* as parsecsv() (and gives identical results) but faster for lines that do not contain double quotes */
 unsigned int parsewhitesp(char *in,char *outfields[],unsigned int maxfields); /* char *outfields[maxfields] needed */
   /* parse input line into a number of fields - CHANGES input !!!
 	 field seperator is "whitespace"  , multiple "whitespace" chars are treated as a single seperator
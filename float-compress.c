@@ -0,0 +1,484 @@
+/* float-compress.c
+
+ Compresses an array of floats (the x or y values of a trace) so large traces take less RAM.
+ Values are compressed in blocks of FC_BLOCK_SIZE values, each block can be decoded on its own and has a header holding
+ its first, last, min and max values. Compression is lossless (the exact bit patterns of the floats are kept).
+
+ Two encodings are provided, both work on the bit patterns of the floats (as 32 bit unsigned integers):
+  FC_XOR   : as used by Facebook's "Gorilla" time series database - each value is xor'ed with the previous value, a '0' bit means the
+			 value is the same as the previous one, otherwise '1' followed by the "meaningful" (non-zero) bits of the xor, where the position of
+			 these bits is either the same as the last time ('0') or is given explicitly ('1' + 5 bits nos leading zeros + 5 bits length-1).
+			 Slowly changing values have similar sign, exponent and top bits of mantissa, so their xor's have lots of leading zeros.
+  FC_DELTA : the difference between successive differences of the bit patterns is stored in a variable number of bits ('0' for no change,
+			 '10'+7 bits, '110'+9 bits, '1110'+12 bits or '1111'+32 bits). For x values that increase by (nearly) the same amount each
+			 time this is normally 1 or 2 bits per value.
+ FC_Q16   : each value is stored in 16 bits as offset+q*scale (q=0..65535), where offset and scale (doubles) are stored at the start of the block.
+			 This is used for values read from an ADC (eg 12 or 16 bit readings, possibly scaled) which can be stored exactly this way, and
+			 when fc_compress() is given a non-zero max_err for blocks where every value is within max_err of the value stored (so this is not lossless).
+			 Every value is checked as a block is encoded, so its only used when the result is guaranteed to be exact (or within max_err).
+ Each block is encoded in all the ways possible and the shortest result is kept. Each block starts on a byte boundary.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#include <stdlib.h> /* for malloc() and free() */
+#include <string.h> /* for memcpy() and memmove() */
+#include <math.h> /* for INFINITY, floor() and fabs() */
+#include <float.h> /* for FLT_MAX */
+#include "float-compress.h"
+
+#define FC_XOR 0   /* values of fc_block.mode */
+#define FC_DELTA 1
+#define FC_Q16 2
+#define FC_NOS_MODES 3
+#define FC_Q16_MAX 65535 /* max value of q for FC_Q16 */
+#define FC_Q16_MAX_FRACTION 16 /* max number of fractions of the smallest step between values tried as the scale for FC_Q16 (limits time spent on blocks that cannot be stored this way) */
+
+struct s_fc_array
+	{size_t n;              // number of values
+	 size_t nos_blocks;     // number of blocks
+	 fc_block *blocks;      // header for each block
+	 unsigned char *data;   // encoded values for all blocks
+	 size_t data_len;       // number of bytes in data
+	};
+
+typedef struct
+	{unsigned char *buf;    // output buffer (grows as needed)
+	 size_t len,size;       // bytes used, bytes allocated
+	 uint64_t acc;          // bits not yet written to buf (lowest nbits bits)
+	 int nbits;
+	 int error;             // set to 1 if out of RAM
+	} bit_writer;
+
+typedef struct
+	{const unsigned char *p;// next byte to read
+	 uint64_t acc;          // bits read but not yet used (lowest nbits bits)
+	 int nbits;
+	} bit_reader;
+
+static void put_byte(bit_writer *w,unsigned char c)
+{if(w->len>=w->size)
+	{size_t newsize=w->size*2+4096;
+	 unsigned char *b=(unsigned char *)realloc(w->buf,newsize);
+	 if(b==NULL)
+		{w->error=1;
+		 return;
+		}
+	 w->buf=b;
+	 w->size=newsize;
+	}
+ w->buf[w->len++]=c;
+}
+
+static void put_bits(bit_writer *w,uint32_t v,int nb) /* write the lowest nb (1..32) bits of v */
+{w->acc=(w->acc<<nb) | (v & (uint32_t)(((uint64_t)1<<nb)-1));
+ w->nbits+=nb;
+ while(w->nbits>=8)
+	{w->nbits-=8;
+	 put_byte(w,(unsigned char)(w->acc>>w->nbits));
+	}
+}
+
+static void flush_bits(bit_writer *w) /* pad to a byte boundary */
+{if(w->nbits>0) put_bits(w,0,8-w->nbits);
+}
+
+static uint32_t get_bits(bit_reader *r,int nb) /* read nb (1..32) bits */
+{while(r->nbits<nb)
+	{r->acc=(r->acc<<8) | *r->p++;
+	 r->nbits+=8;
+	}
+ r->nbits-=nb;
+ return (uint32_t)(r->acc>>r->nbits) & (uint32_t)(((uint64_t)1<<nb)-1);
+}
+
+static int nos_leading_zeros(uint32_t x) /* x must not be 0 */
+{int n=0;
+ if((x & 0xffff0000u)==0) {n+=16;x<<=16;}
+ if((x & 0xff000000u)==0) {n+=8;x<<=8;}
+ if((x & 0xf0000000u)==0) {n+=4;x<<=4;}
+ if((x & 0xc0000000u)==0) {n+=2;x<<=2;}
+ if((x & 0x80000000u)==0) {n+=1;}
+ return n;
+}
+
+static int nos_trailing_zeros(uint32_t x) /* x must not be 0 */
+{int n=0;
+ if((x & 0x0000ffffu)==0) {n+=16;x>>=16;}
+ if((x & 0x000000ffu)==0) {n+=8;x>>=8;}
+ if((x & 0x0000000fu)==0) {n+=4;x>>=4;}
+ if((x & 0x00000003u)==0) {n+=2;x>>=2;}
+ if((x & 0x00000001u)==0) {n+=1;}
+ return n;
+}
+
+static uint32_t float_bits(float f)
+{uint32_t u;
+ memcpy(&u,&f,sizeof(u));
+ return u;
+}
+
+static float bits_float(uint32_t u)
+{float f;
+ memcpy(&f,&u,sizeof(f));
+ return f;
+}
+
+static void encode_block_xor(bit_writer *w,const float *v,size_t n)
+{uint32_t prev=float_bits(v[0]);
+ int lead=-1,trail=0; // position of meaningful bits used last time (lead=-1 => none yet)
+ put_bits(w,prev,32);
+ for(size_t i=1;i<n;++i)
+	{uint32_t u=float_bits(v[i]);
+	 uint32_t x=u^prev;
+	 prev=u;
+	 if(x==0)
+		{put_bits(w,0,1); // same as previous value
+		 continue;
+		}
+	 int lz=nos_leading_zeros(x),tz=nos_trailing_zeros(x);
+	 if(lead>=0 && lz>=lead && tz>=trail)
+		{put_bits(w,2,2); // '10' meaningful bits fit in the same position as last time
+		 put_bits(w,x>>trail,32-lead-trail);
+		}
+	 else
+		{int len=32-lz-tz;
+		 put_bits(w,3,2); // '11' + position + meaningful bits
+		 put_bits(w,(uint32_t)lz,5);
+		 put_bits(w,(uint32_t)(len-1),5);
+		 put_bits(w,x>>tz,len);
+		 lead=lz;
+		 trail=tz;
+		}
+	}
+}
+
+static void decode_block_xor(bit_reader *r,float *out,size_t n)
+{uint32_t prev=get_bits(r,32);
+ int lead=0,trail=0;
+ out[0]=bits_float(prev);
+ for(size_t i=1;i<n;++i)
+	{if(get_bits(r,1))
+		{if(get_bits(r,1))
+			{lead=(int)get_bits(r,5);
+			 trail=32-lead-((int)get_bits(r,5)+1);
+			}
+		 prev^=get_bits(r,32-lead-trail)<<trail;
+		}
+	 out[i]=bits_float(prev);
+	}
+}
+
+static void encode_block_delta(bit_writer *w,const float *v,size_t n)
+{uint32_t prev=float_bits(v[0]),delta=0;
+ put_bits(w,prev,32);
+ for(size_t i=1;i<n;++i)
+	{uint32_t u=float_bits(v[i]);
+	 uint32_t d=u-prev; // unsigned arithmetic so any change "wraps" correctly
+	 int32_t dd=(int32_t)(d-delta);
+	 uint32_t z=((uint32_t)dd<<1)^(uint32_t)(dd>>31); // "zigzag" so small -ve values are also small
+	 prev=u;
+	 delta=d;
+	 if(z==0) put_bits(w,0,1);
+	 else if(z<(1u<<7)) {put_bits(w,2,2);put_bits(w,z,7);}
+	 else if(z<(1u<<9)) {put_bits(w,6,3);put_bits(w,z,9);}
+	 else if(z<(1u<<12)) {put_bits(w,14,4);put_bits(w,z,12);}
+	 else {put_bits(w,15,4);put_bits(w,z,32);}
+	}
+}
+
+static void decode_block_delta(bit_reader *r,float *out,size_t n)
+{uint32_t prev=get_bits(r,32),delta=0;
+ out[0]=bits_float(prev);
+ for(size_t i=1;i<n;++i)
+	{uint32_t z;
+	 if(!get_bits(r,1)) z=0;
+	 else if(!get_bits(r,1)) z=get_bits(r,7);
+	 else if(!get_bits(r,1)) z=get_bits(r,9);
+	 else if(!get_bits(r,1)) z=get_bits(r,12);
+	 else z=get_bits(r,32);
+	 delta+=(z>>1)^(0u-(z&1)); // undo zigzag
+	 prev+=delta;
+	 out[i]=bits_float(prev);
+	}
+}
+
+static float q16_value(double offset,double scale,uint32_t q) /* returns value for q in a FC_Q16 block - this is used when encoding and decoding so they always match */
+{return (float)(offset+(double)q*scale);
+}
+
+static uint32_t q16_q(const float v,double offset,double scale) /* returns q to store for v in a FC_Q16 block */
+{double q;
+ if(scale==0) return 0;
+ q=floor(((double)v-offset)/scale+0.5);
+ if(q<0) return 0;
+ if(q>FC_Q16_MAX) return FC_Q16_MAX;
+ return (uint32_t)q;
+}
+
+static int q16_ok(float v,double offset,double scale,float max_err) /* returns 1 if v is stored exactly (max_err=0) or within max_err using offset and scale */
+{float r=q16_value(offset,scale,q16_q(v,offset,scale));
+ if(max_err==0)
+	return float_bits(r)==float_bits(v); // must be an exact match (eg so -0 and +0 are not the same)
+ return fabs((double)r-(double)v)<=max_err;
+}
+
+static int q16_check(const float *v,size_t n,double offset,double scale,float max_err,size_t *fail) /* returns 1 if all values v[] are stored exactly (max_err=0) or within max_err using offset and scale */
+{ // *fail is the index of a value that failed a previous check, its checked first as its likely to fail again (so most scales that do not work are rejected quickly)
+ if(!q16_ok(v[*fail],offset,scale,max_err)) return 0;
+ for(size_t i=0;i<n;++i)
+	{if(!q16_ok(v[i],offset,scale,max_err))
+		{*fail=i;
+		 return 0;
+		}
+	}
+ return 1;
+}
+
+static int cmp_float(const void *a,const void *b) /* compare function for qsort() */
+{float fa=*(const float *)a,fb=*(const float *)b;
+ return fa<fb ? -1 : fa>fb ? 1 : 0;
+}
+
+static int q16_params(const float *v,size_t n,float max_err,double *offset,double *scale) /* find offset and scale so v[] can be stored in a FC_Q16 block, returns 0 if this is not possible */
+{float vmin=v[0],vmax=v[0];
+ float sorted[FC_BLOCK_SIZE];
+ double s0=0,gap=0,range;
+ size_t fail=0;
+ for(size_t i=0;i<n;++i)
+	{if(!(fabs(v[i])<=FLT_MAX)) return 0; // NaN's and infinities cannot be stored
+	 if(v[i]<vmin) vmin=v[i];
+	 if(v[i]>vmax) vmax=v[i];
+	}
+ range=(double)vmax-(double)vmin;
+ if(range==0)
+	{*offset=vmin; // all values the same
+	 *scale=0;
+	 return q16_check(v,n,*offset,0,max_err,&fail);
+	}
+ for(size_t i=0;i<n;++i)
+	{double d=(double)v[i]-(double)vmin; // smallest step from the min value is a whole number of steps of the resolution of the values (eg 1 lsb of an ADC)
+	 if(d>0 && (s0==0 || d<s0)) s0=d;
+	}
+ memcpy(sorted,v,n*sizeof(float));
+ qsort(sorted,n,sizeof(float),cmp_float);
+ for(size_t i=1;i<n;++i)
+	{double d=(double)sorted[i]-(double)sorted[i-1]; // smallest step between any 2 values is close to the resolution, but may be out by rounding errors
+	 if(d>0 && (gap==0 || d<gap)) gap=d;
+	}
+ s0/=floor(s0/gap+0.5); // so s0 is now the resolution, without the rounding errors in gap (dividing s0 by a whole number of steps)
+ for(int k=1;k<=FC_Q16_MAX_FRACTION;++k)
+	{// values may not include the smallest step possible (eg 1 lsb), so try fractions of the smallest step found while there are still few enough steps
+	 double qmax=floor(range/(s0/k)+0.5);
+	 if(qmax>FC_Q16_MAX) break;
+	 double s=range/qmax; // exact steps from min to max value
+	 uint32_t fs=float_bits((float)s);
+	 double scales[4]; // values are often an integer (eg ADC reading) times a float constant, rounding means s may be 1 lsb away from that constant
+	 scales[0]=s;
+	 scales[1]=bits_float(fs);
+	 scales[2]=bits_float(fs+1); // s is >0 so next float up
+	 scales[3]=bits_float(fs-1); // and next float down
+	 for(int j=0;j<8;++j)
+		{*scale=scales[j>>1];
+		 if(j&1) *offset=floor(vmin / *scale+0.5)* *scale; // no offset, so min value is also an integer times scale
+		 else *offset=vmin; // offset added (eg a calibration)
+		 if(*scale>0 && q16_check(v,n,*offset,*scale,0,&fail)) return 1;
+		}
+	}
+ if(max_err>0)
+	{// values cannot be stored exactly, but they may be stored with an error of at most max_err
+	 *offset=vmin;
+	 *scale=range/FC_Q16_MAX;
+	 return q16_check(v,n,*offset,*scale,max_err,&fail);
+	}
+ return 0;
+}
+
+static int encode_block_q16(bit_writer *w,const float *v,size_t n,float max_err) /* returns 0 (with nothing written) if block cannot be encoded this way */
+{double offset,scale;
+ uint32_t ob[2],sb[2];
+ if(!q16_params(v,n,max_err,&offset,&scale)) return 0;
+ memcpy(ob,&offset,sizeof(ob));
+ memcpy(sb,&scale,sizeof(sb));
+ put_bits(w,ob[0],32);
+ put_bits(w,ob[1],32);
+ put_bits(w,sb[0],32);
+ put_bits(w,sb[1],32);
+ for(size_t i=0;i<n;++i)
+	put_bits(w,q16_q(v[i],offset,scale),16);
+ return 1;
+}
+
+static void decode_block_q16(bit_reader *r,float *out,size_t n)
+{double offset,scale;
+ uint32_t ob[2],sb[2];
+ ob[0]=get_bits(r,32);
+ ob[1]=get_bits(r,32);
+ sb[0]=get_bits(r,32);
+ sb[1]=get_bits(r,32);
+ memcpy(&offset,ob,sizeof(offset));
+ memcpy(&scale,sb,sizeof(scale));
+ for(size_t i=0;i<n;++i)
+	out[i]=q16_value(offset,scale,get_bits(r,16));
+}
+
+static void decode_block(const unsigned char *p,int mode,float *out,size_t n) /* decode block encoded using mode starting at p */
+{bit_reader r;
+ r.p=p;
+ r.acc=0;
+ r.nbits=0;
+ switch(mode)
+	{case FC_XOR:
+		decode_block_xor(&r,out,n);
+		break;
+	 case FC_DELTA:
+		decode_block_delta(&r,out,n);
+		break;
+	 case FC_Q16:
+		decode_block_q16(&r,out,n);
+		break;
+	}
+}
+
+static int encode_block(bit_writer *w,int mode,const float *v,size_t n,float max_err) /* encode block using mode, returns 0 if this is not possible */
+{switch(mode)
+	{case FC_XOR:
+		encode_block_xor(w,v,n);
+		return 1;
+	 case FC_DELTA:
+		encode_block_delta(w,v,n);
+		return 1;
+	 case FC_Q16:
+		return encode_block_q16(w,v,n,max_err);
+	}
+ return 0;
+}
+
+fc_array *fc_compress(const float *v,size_t n,float max_err) /* compress n values v[], returns NULL if out of RAM. If max_err>0 values may be changed by up to max_err */
+{fc_array *a=(fc_array *)calloc(1,sizeof(fc_array));
+ float *tmp=NULL; // used to decode a block if values may have been changed
+ bit_writer w;
+ if(a==NULL) return NULL;
+ a->n=n;
+ a->nos_blocks=(n+FC_BLOCK_SIZE-1)/FC_BLOCK_SIZE;
+ if(a->nos_blocks>0)
+	{a->blocks=(fc_block *)malloc(a->nos_blocks*sizeof(fc_block));
+	 if(a->blocks==NULL)
+		{free(a);
+		 return NULL;
+		}
+	}
+ memset(&w,0,sizeof(w));
+ w.size=n/2+16; // initial guess of size needed, grows if required
+ w.buf=(unsigned char *)malloc(w.size);
+ if(max_err>0) tmp=(float *)malloc(FC_BLOCK_SIZE*sizeof(float));
+ if(w.buf==NULL || (max_err>0 && tmp==NULL))
+	{free(w.buf);
+	 free(tmp);
+	 fc_free(a);
+	 return NULL;
+	}
+ for(size_t b=0;b<a->nos_blocks && !w.error;++b)
+	{const float *bv=v+b*FC_BLOCK_SIZE;
+	 size_t bn=n-b*FC_BLOCK_SIZE;
+	 fc_block *h=a->blocks+b;
+	 if(bn>FC_BLOCK_SIZE) bn=FC_BLOCK_SIZE;
+	 h->offset=w.len;
+	 size_t best_len=0;
+	 for(int mode=0;mode<FC_NOS_MODES && !w.error;++mode)
+		{// try each encoding in turn, keeping the shortest one (which is always moved to the start of the block)
+		 size_t start=w.len;
+		 if(!encode_block(&w,mode,bv,bn,max_err)) continue;
+		 flush_bits(&w);
+		 size_t len=w.len-start;
+		 if(start==h->offset || len<best_len)
+			{if(start!=h->offset) memmove(w.buf+h->offset,w.buf+start,len);
+			 best_len=len;
+			 h->mode=mode;
+			}
+		 w.len=h->offset+best_len;
+		}
+	 if(w.error) break;
+	 if(h->mode==FC_Q16 && max_err>0)
+		{// values may have been changed, so header needs to match the values actually stored
+		 decode_block(w.buf+h->offset,h->mode,tmp,bn);
+		 bv=tmp;
+		}
+	 h->first=bv[0];
+	 h->last=bv[bn-1];
+	 h->min=INFINITY;
+	 h->max=-INFINITY;
+	 h->min_i=h->max_i=0;
+	 for(size_t i=0;i<bn;++i)
+		{if(bv[i]<h->min) {h->min=bv[i];h->min_i=(uint32_t)i;} // comparisons with NaN are false so NaN's are ignored
+		 if(bv[i]>h->max) {h->max=bv[i];h->max_i=(uint32_t)i;}
+		}
+	}
+ free(tmp);
+ if(w.error)
+	{free(w.buf);
+	 fc_free(a);
+	 return NULL;
+	}
+ a->data_len=w.len;
+ a->data=(unsigned char *)realloc(w.buf,w.len>0?w.len:1); // release unused space (cannot fail as its getting smaller, but just in case keep original buffer if it does)
+ if(a->data==NULL) a->data=w.buf;
+ return a;
+}
+
+size_t fc_nos_values(const fc_array *a) /* returns number of values in a */
+{return a->n;
+}
+
+size_t fc_bytes(const fc_array *a) /* returns number of bytes of RAM used by a */
+{return sizeof(fc_array)+a->nos_blocks*sizeof(fc_block)+a->data_len;
+}
+
+size_t fc_nos_blocks(const fc_array *a) /* returns number of blocks in a */
+{return a->nos_blocks;
+}
+
+const fc_block *fc_block_info(const fc_array *a,size_t b) /* returns header of block b (0..fc_nos_blocks(a)-1) */
+{return a->blocks+b;
+}
+
+size_t fc_decode_block(const fc_array *a,size_t b,float *out) /* decode block b into out[] (which must have space for FC_BLOCK_SIZE values), returns number of values in block */
+{size_t bn=a->n-b*FC_BLOCK_SIZE;
+ if(bn>FC_BLOCK_SIZE) bn=FC_BLOCK_SIZE;
+ decode_block(a->data+a->blocks[b].offset,a->blocks[b].mode,out,bn);
+ return bn;
+}
+
+void fc_decompress(const fc_array *a,float *out) /* decode all of a into out[] (which must have space for fc_nos_values(a) values) */
+{for(size_t b=0;b<a->nos_blocks;++b)
+	out+=fc_decode_block(a,b,out);
+}
+
+void fc_free(fc_array *a) /* free all RAM used by a. a may be NULL */
+{if(a==NULL) return;
+ free(a->blocks);
+ free(a->data);
+ free(a);
+}
@@ -0,0 +1,67 @@
+/* float-compress.h
+ header file for float-compress.c
+
+ Compresses an array of floats (the x or y values of a trace) so large traces take less RAM.
+ Values are compressed in blocks of FC_BLOCK_SIZE values, each block can be decoded on its own and has a header holding
+ its first, last, min and max values so (for example) a block that is all inside one pixel column of a graph can be drawn without decoding it.
+ Compression is lossless (the exact bit patterns of the floats are kept, including NaN's) unless a maximum error is given, in which case
+ blocks may be stored as 16 bit values (with a scale and offset) if every value in the block is then within the maximum error.
+ Each block is compressed using several different methods and the one that gives the smallest result is kept.
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#ifndef _float_compress_h
+ #define _float_compress_h
+ #include <stdint.h> /* for uint32_t */
+ #include <stddef.h> /* for size_t */
+ #ifdef __cplusplus
+  extern "C" {
+ #endif
+#define FC_BLOCK_SIZE 4096 /* number of values in a block (the last block of an array may have less) */
+
+typedef struct s_fc_array fc_array;
+
+typedef struct
+	{float first,last;      // first and last values in the block
+	 float min,max;         // min and max values in the block (NaN's are ignored, if all values are NaN then min=+inf and max=-inf)
+	 uint32_t min_i,max_i;  // index in block (0..FC_BLOCK_SIZE-1) of the 1st min and max values
+	 size_t offset;         // offset of encoded data for block (for use by float-compress.c only)
+	 int mode;              // how block is encoded (for use by float-compress.c only)
+	} fc_block;
+
+fc_array *fc_compress(const float *v,size_t n,float max_err); /* compress n values v[], returns NULL if out of RAM. If max_err>0 values may be changed by up to max_err */
+size_t fc_nos_values(const fc_array *a); /* returns number of values in a */
+size_t fc_bytes(const fc_array *a); /* returns number of bytes of RAM used by a */
+size_t fc_nos_blocks(const fc_array *a); /* returns number of blocks in a */
+const fc_block *fc_block_info(const fc_array *a,size_t b); /* returns header of block b (0..fc_nos_blocks(a)-1) */
+size_t fc_decode_block(const fc_array *a,size_t b,float *out); /* decode block b into out[] (which must have space for FC_BLOCK_SIZE values), returns number of values in block */
+void fc_decompress(const fc_array *a,float *out); /* decode all of a into out[] (which must have space for fc_nos_values(a) values) */
+void fc_free(fc_array *a); /* free all RAM used by a. a may be NULL */
+
+ #ifdef __cplusplus
+    }
+ #endif
+#endif
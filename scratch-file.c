@@ -0,0 +1,306 @@
+/* scratch-file.c
+
+ Holds an array of floats (the x or y values of a trace) in a memory mapped "scratch" file in a directory chosen by the user, rather than in RAM.
+ This allows the traces loaded to be much bigger than the RAM in the PC. Without this when the RAM is full the values of traces are written to the pagefile,
+ which is slow and makes the whole PC very unresponsive. With scratch files the values already read are written to the file once (sequentially), and the file is then
+ mapped so the operating system can just drop those pages when it needs the RAM and read them back when they are next used.
+ The mapping is read/write so values can be added to a trace in a scratch file (while a file is read, or when a file is being followed), scratch_resize() makes the file
+ bigger when its full. Pages changed in this way are written back to the scratch file (not the pagefile) by the operating system.
+ The user can put the scratch directory on a fast disk (eg an SSD) which need not be the one holding the pagefile.
+
+ Values are normally read sequentially (eg when a trace is drawn), scratch_willneed() tells the operating system which values are about to be read so it can start
+ reading them from the disk in large blocks (PrefetchVirtualMemory() under Windows if available [Windows 8 or later], madvise(MADV_WILLNEED) otherwise).
+ scratch_release() removes the values from RAM (VirtualUnlock() of pages that are not locked under Windows, madvise(MADV_DONTNEED) otherwise), this is used
+ to choose which values are dropped from RAM first (the least recently used traces) rather than leaving this entirely to the operating system.
+
+ Scratch files are deleted when they are closed, and by the operating system if the program exits without closing them (FILE_FLAG_DELETE_ON_CLOSE under Windows,
+ otherwise the file is deleted as soon as it is created and it only exists while its open).
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#include <stdlib.h> /* for malloc() and free() */
+#include <string.h> /* for strcat() */
+#include <stdint.h> /* for uintptr_t */
+#include "scratch-file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#define SCRATCH_WRITE_BLOCK (16*1024*1024) /* max number of bytes written to a scratch file by one call to WriteFile()/write() */
+
+struct s_scratch_file
+	{
+#ifdef _WIN32
+	 HANDLE hFile,hMap;
+#else
+	 int fd;
+#endif
+	 float *base;           // start of mapped file
+	 size_t n;              // number of values in file (the whole file is mapped)
+	};
+
+static wchar_t *scratch_directory=NULL; // directory scratch files are created in (malloc'ed), NULL if scratch files are not being used
+
+#ifndef _WIN32
+static char *to_cfilename(const wchar_t *filename) /* returns malloc'ed multibyte version of filename with space for extra chars at the end, NULL on error */
+{char *cfilename;
+ const size_t extra=16;
+ size_t len=wcstombs(NULL,filename,0);
+ if(len==(size_t)-1 || (cfilename=(char *)malloc(len+1+extra))==NULL)
+	return NULL;
+ wcstombs(cfilename,filename,len+1);
+ return cfilename;
+}
+#endif
+
+bool scratch_set_dir(const wchar_t *dir) /* create scratch files in directory dir from now on (NULL or "" => stop using scratch files), returns false if dir is not a directory */
+{wchar_t *d;
+ if(dir==NULL || *dir==0)
+	{free(scratch_directory); // scratch files already created are still used
+	 scratch_directory=NULL;
+	 return true;
+	}
+#ifdef _WIN32
+ DWORD attr=GetFileAttributesW(dir);
+ if(attr==INVALID_FILE_ATTRIBUTES || !(attr & FILE_ATTRIBUTE_DIRECTORY)) return false;
+#else
+ struct stat st;
+ char *cdir=to_cfilename(dir);
+ if(cdir==NULL) return false;
+ if(stat(cdir,&st)!=0 || !S_ISDIR(st.st_mode))
+	{free(cdir);
+	 return false;
+	}
+ free(cdir);
+#endif
+ d=(wchar_t *)malloc((wcslen(dir)+1)*sizeof(wchar_t));
+ if(d==NULL) return false;
+ wcscpy(d,dir);
+ free(scratch_directory);
+ scratch_directory=d;
+ return true;
+}
+
+const wchar_t *scratch_dir(void) /* returns directory scratch files are created in, NULL if scratch files are not being used */
+{return scratch_directory;
+}
+
+static bool scratch_set_size(scratch_file *s,size_t n) /* set size of file to n values (the file must not be mapped), returns false on error (eg disk full) */
+{
+#ifdef _WIN32
+ LARGE_INTEGER len;
+ len.QuadPart=(LONGLONG)n*(LONGLONG)sizeof(float);
+ return SetFilePointerEx(s->hFile,len,NULL,FILE_BEGIN) && SetEndOfFile(s->hFile); // NTFS allocates the space now, so a full disk is found here rather than when values are written
+#else
+ off_t len=(off_t)(n*sizeof(float));
+ struct stat st;
+ if(fstat(s->fd,&st)!=0) return false;
+ if(len>st.st_size)
+	{int r=posix_fallocate(s->fd,st.st_size,len-st.st_size); // allocate space now, otherwise a full disk is only found (as SIGBUS) when values are written
+	 if(r==0) return true;
+	 if(r!=EINVAL && r!=EOPNOTSUPP) return false; // file system does not support posix_fallocate(), so just set the size
+	}
+ return ftruncate(s->fd,len)==0;
+#endif
+}
+
+static bool scratch_map(scratch_file *s) /* map all s->n values of file (read/write), returns false on error */
+{
+#ifdef _WIN32
+ s->hMap=CreateFileMappingW(s->hFile,NULL,PAGE_READWRITE,0,0,NULL);
+ if(s->hMap!=NULL)
+	s->base=(float *)MapViewOfFile(s->hMap,FILE_MAP_WRITE,0,0,0); // map whole file (FILE_MAP_WRITE allows reads as well), this can fail for big files with a 32 bit program
+#else
+ void *m=mmap(NULL,s->n*sizeof(float),PROT_READ | PROT_WRITE,MAP_SHARED,s->fd,0);
+ if(m!=MAP_FAILED)
+	{madvise(m,s->n*sizeof(float),MADV_SEQUENTIAL); // values are normally read in order
+	 s->base=(float *)m;
+	}
+#endif
+ return s->base!=NULL;
+}
+
+static void scratch_unmap(scratch_file *s) /* unmap file (changed pages are still written back to the file) */
+{
+#ifdef _WIN32
+ if(s->base!=NULL) UnmapViewOfFile((LPCVOID)s->base);
+ if(s->hMap!=NULL) CloseHandle(s->hMap);
+ s->hMap=NULL;
+#else
+ if(s->base!=NULL) munmap((void *)s->base,s->n*sizeof(float));
+#endif
+ s->base=NULL;
+}
+
+scratch_file *scratch_create(const float *v,size_t n,size_t size) /* write n values v[] to a new scratch file with space for size values and map it into memory, returns NULL on error (eg disk full) or if scratch files are not being used */
+{scratch_file *s;
+ const char *p=(const char *)v;
+ size_t left=n*sizeof(float);
+ if(scratch_directory==NULL || n==0) return NULL;
+ if(size<n) size=n;
+ s=(scratch_file *)calloc(1,sizeof(scratch_file));
+ if(s==NULL) return NULL;
+ s->n=size;
+#ifdef _WIN32
+ wchar_t name[MAX_PATH];
+ s->hFile=INVALID_HANDLE_VALUE;
+ if(GetTempFileNameW(scratch_directory,L"csg",0,name)==0) // creates an empty file with a unique name
+	{free(s);
+	 return NULL;
+	}
+ // FILE_FLAG_DELETE_ON_CLOSE means the file is deleted when the last handle to it (including the mapping) is closed, even if csvgraph crashes
+ s->hFile=CreateFileW(name,GENERIC_READ | GENERIC_WRITE,0,NULL,CREATE_ALWAYS,
+					  FILE_ATTRIBUTE_NOT_CONTENT_INDEXED | FILE_FLAG_DELETE_ON_CLOSE | FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+ if(s->hFile==INVALID_HANDLE_VALUE)
+	{DeleteFileW(name);
+	 free(s);
+	 return NULL;
+	}
+ while(left>0)
+	{DWORD len=(DWORD)(left>SCRATCH_WRITE_BLOCK ? SCRATCH_WRITE_BLOCK : left),written;
+	 if(!WriteFile(s->hFile,p,len,&written,NULL) || written!=len)
+		{scratch_close(s); // disk full etc
+		 return NULL;
+		}
+	 p+=len;
+	 left-=len;
+	}
+#else
+ char *cname=to_cfilename(scratch_directory);
+ if(cname==NULL)
+	{free(s);
+	 return NULL;
+	}
+ strcat(cname,"/csgXXXXXX");
+ s->fd=mkstemp(cname);
+ if(s->fd== -1)
+	{free(cname);
+	 free(s);
+	 return NULL;
+	}
+ unlink(cname); // file is deleted when its closed
+ free(cname);
+ while(left>0)
+	{ssize_t written=write(s->fd,p,left>SCRATCH_WRITE_BLOCK ? SCRATCH_WRITE_BLOCK : left);
+	 if(written<0 && errno==EINTR) continue;
+	 if(written<=0)
+		{scratch_close(s); // disk full etc
+		 return NULL;
+		}
+	 p+=written;
+	 left-=(size_t)written;
+	}
+#endif
+ if((size>n && !scratch_set_size(s,size)) || !scratch_map(s)) // space for values to be added later, then map the whole file
+	{scratch_close(s);
+	 return NULL;
+	}
+ return s;
+}
+
+bool scratch_resize(scratch_file *s,size_t size) /* change s so it has space for size values (values that still fit are kept), returns false on error (eg disk full) in which case s is unchanged. scratch_values() may change */
+{size_t old_size=s->n;
+ if(size==0) size=1; // an empty file cannot be mapped
+ if(size==old_size) return true;
+ scratch_unmap(s); // the size of a mapped file cannot be reduced under Windows, and the mapping may need to move to a different address to get bigger
+ if(scratch_set_size(s,size))
+	{s->n=size;
+	 if(scratch_map(s)) return true;
+	 scratch_set_size(s,old_size); // cannot map the bigger file (eg not enough address space for a 32 bit program)
+	 s->n=old_size;
+	}
+ scratch_map(s); // map original file again, this should not fail as it was mapped before (if it does scratch_values() returns NULL)
+ return false;
+}
+
+float *scratch_values(const scratch_file *s) /* returns pointer to the values in s */
+{return s->base;
+}
+
+size_t scratch_bytes(const scratch_file *s) /* returns size of the values in s (in bytes) */
+{return s->n*sizeof(float);
+}
+
+#ifdef _WIN32
+typedef struct {PVOID VirtualAddress; SIZE_T NumberOfBytes;} prefetch_range; // as WIN32_MEMORY_RANGE_ENTRY (which older headers do not define)
+typedef BOOL (WINAPI *prefetch_fn)(HANDLE hProcess,ULONG_PTR NumberOfEntries,prefetch_range *VirtualAddresses,ULONG Flags);
+#endif
+
+void scratch_willneed(scratch_file *s,size_t start,size_t n) /* values start..start+n-1 of s will be read soon (in order), so start reading them from the file now */
+{char *p;
+ size_t len;
+ if(start>=s->n) return;
+ if(n>s->n-start) n=s->n-start;
+ if(n==0) return;
+ p=(char *)(s->base+start);
+ len=n*sizeof(float);
+#ifdef _WIN32
+ static bool init=false;
+ static prefetch_fn prefetch=NULL; // PrefetchVirtualMemory() is only available in Windows 8 or later, on older versions pages are just read as they are used
+ if(!init)
+	{prefetch=(prefetch_fn)(void *)GetProcAddress(GetModuleHandleW(L"kernel32.dll"),"PrefetchVirtualMemory");
+	 init=true;
+	}
+ if(prefetch!=NULL)
+	{prefetch_range r;
+	 r.VirtualAddress=p;
+	 r.NumberOfBytes=len;
+	 prefetch(GetCurrentProcess(),1,&r,0); // this just starts reading, errors can be ignored
+	}
+#else
+ size_t pagesize=(size_t)sysconf(_SC_PAGESIZE);
+ uintptr_t a=(uintptr_t)p & ~(uintptr_t)(pagesize-1); // madvise() needs a page aligned address
+ madvise((void *)a,len+(size_t)((uintptr_t)p-a),MADV_WILLNEED);
+#endif
+}
+
+void scratch_release(scratch_file *s) /* the values in s will not be needed for a while, so remove them from RAM (they are read back from the file when next used) */
+{
+#ifdef _WIN32
+ VirtualUnlock((LPVOID)s->base,s->n*sizeof(float)); // for pages that are not locked this removes them from the working set of the process (and it returns an error which is expected), changed pages are written back to the file
+#else
+ madvise((void *)s->base,s->n*sizeof(float),MADV_DONTNEED); // pages of a shared mapping are just dropped (changed ones are still written back to the file)
+#endif
+}
+
+void scratch_close(scratch_file *s) /* unmap and delete scratch file and free all memory used. s may be NULL */
+{if(s==NULL) return;
+ scratch_unmap(s);
+#ifdef _WIN32
+ if(s->hFile!=INVALID_HANDLE_VALUE) CloseHandle(s->hFile); // file is deleted as it was created with FILE_FLAG_DELETE_ON_CLOSE
+#else
+ close(s->fd);
+#endif
+ free(s);
+}
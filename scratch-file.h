@@ -0,0 +1,56 @@
+/* scratch-file.h
+ header file for scratch-file.c
+
+ Holds an array of floats (the x or y values of a trace) in a memory mapped "scratch" file in a directory chosen by the user, rather than in RAM.
+ The operating system can simply drop the pages from RAM when it needs the space (and read them back from the file when they are next used), pages changed
+ when values are added are written back to the scratch file rather than to the pagefile. Scratch files are deleted when they are closed (or when the program exits).
+
+ Written by Peter Miller 17/10/2026
+
+*/
+/*----------------------------------------------------------------------------
+ * Copyright (c) 2026 Peter Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *--------------------------------------------------------------------------*/
+#ifndef _scratch_file_h
+ #define _scratch_file_h
+ #include <stdbool.h> /* as bool used below */
+ #include <stddef.h> /* for size_t */
+ #include <wchar.h> /* for wchar_t */
+ #ifdef __cplusplus
+  extern "C" {
+ #endif
+typedef struct s_scratch_file scratch_file;
+
+bool scratch_set_dir(const wchar_t *dir); /* create scratch files in directory dir from now on (NULL or "" => stop using scratch files), returns false if dir is not a directory */
+const wchar_t *scratch_dir(void); /* returns directory scratch files are created in, NULL if scratch files are not being used */
+scratch_file *scratch_create(const float *v,size_t n,size_t size); /* write n values v[] to a new scratch file with space for size values and map it into memory, returns NULL on error (eg disk full) or if scratch files are not being used */
+bool scratch_resize(scratch_file *s,size_t size); /* change s so it has space for size values (values that still fit are kept), returns false on error (eg disk full) in which case s is unchanged. scratch_values() may change */
+float *scratch_values(const scratch_file *s); /* returns pointer to the values in s (these can be changed) */
+size_t scratch_bytes(const scratch_file *s); /* returns size of s (in bytes) */
+void scratch_willneed(scratch_file *s,size_t start,size_t n); /* values start..start+n-1 of s will be read soon (in order), so start reading them from the file now */
+void scratch_release(scratch_file *s); /* the values in s will not be needed for a while, so remove them from RAM (they are read back from the file when next used) */
+void scratch_close(scratch_file *s); /* unmap and delete scratch file and free all memory used. s may be NULL */
+
+ #ifdef __cplusplus
+    }
+ #endif
+#endif
@@ -149,6 +149,7 @@ It does not support a multibyte character sequence for the format string.
 #include <ctype.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h> /* for offsetof() */
 // #include <math.h>
 #include <limits.h>
 
@@ -263,6 +264,129 @@ static bool strp_atoi(const char **s, int *result, unsigned int low, unsigned in
     return false; // invalid number found , don't change s        
     }
 
+static bool strp_name(const char **s,const char * const names[],int nos_names,int *result)
+{// match full name or 1st 3 characters of one of names[] (case insensitive), returns true if found
+ for (int i = 0; i < nos_names; ++ i)
+	{
+	 size_t len = strlen(names[i]);
+	 if (!strnicmp(names[i], *s, len)) /* match to full name, strnicmp() does a case insensitive match. strncasecmp() is the equivalent POSIX function  */
+		{
+		 *result = i;
+		 *s += len;
+		 return true;
+		}
+	 else if (!strnicmp(names[i], *s, 3)) /* first 3 characters of name is an allowable abbreviation */
+		{
+		 *result = i;
+		 *s += 3;
+		 return true;
+		}
+	}
+ return false;
+}
+
+static bool strp_fsecs(const char **s)
+{/* fractional seconds (after decimal point) -> store to strp_tz.f_secs and number of digits after dp is stored in strp_tz.f_secs_p10.
+	Will accept as many digits as are present, but double is limited to ~ 15 significant digits */
+ const char *p=*s;
+ if(isdigit(*p))
+	{uint64_t fsec=0;// the mantissa of a double is 53 bits, so 64 bits is plenty to use here [ means overflow detection can be quite simple]
+	 unsigned int power10=0; // count of digits after dp
+	 while(isdigit(*p) && (fsec & UINT64_C(0xf000000000000000)) == 0   )
+		{fsec=fsec*10+(uint64_t)(*p++ -'0');// note leading zeros just change power10, they do not change fsec
+		 power10++; // keep track of decimal point position
+		}
+	 if(isdigit(*p) && *p>='5') fsec++; // round if next digit present
+	 while(isdigit(*p)) ++p; // eat up any more digits that are present (ignore them)
+	 strp_tz.f_secs_p10=(int)power10;// number of digits entered, needed to allow "round loop exact" output (this is limited by the resolution of a double, but that should be OK here)
+	 strp_tz.f_secs=(double)fsec/ipow10(power10);
+	 *s=p;
+	 return true;
+	}
+ return false;
+}
+
+static bool strp_ampm(const char **s,struct tm *tm)
+{// am / pm
+ if (!strnicmp(*s, "am", 2))
+	{ // the hour will be 1 -> 12 maps to 12 am, 1 am .. 11 am, 12 noon 12 pm .. 11 pm
+	 if (tm->tm_hour == 12) // 12 am == 00 hours
+		tm->tm_hour = 0;
+	 *s += 2;
+	 return true;
+	}
+ else if (!strnicmp(*s, "pm", 2))
+	{
+	 if (tm->tm_hour < 12) // 12 pm == 12 hours
+		tm->tm_hour += 12; // 1 pm -> 13 hours, 11 pm -> 23 hours
+	 *s += 2;
+	 return true;
+	}
+ return false;
+}
+
+static bool strp_year(const char **s,int *tm_year)
+{/* The year, including century (for example, 1991) - POSIX limits the year to 4 digits */
+#ifdef POSIX_2008
+ return strp_atoi(s,tm_year, 0, 9999, -1900);// max 4 digits
+#else			/* read in an integer with an optional sign */
+ const char *p=*s;
+ bool valid;
+ bool neg=false;
+ if(*p=='-')
+	{neg=true;
+	 ++p;
+	}
+ else if(*p=='+') ++p;
+ valid=isdigit(*p); /* number must start with a digit (but can be any length) */
+ if(valid)
+	{
+	 int y=(*p++)-'0';/* process 1st digit */
+	 while(isdigit(*p))
+		{/* we have another digit of the number */
+		 if(y*10+(*p-'0')<y) valid=false; // overflow - we don't know the type of time_t so this test should always work
+		 y=y*10+(*p++-'0');
+		}
+	 if(y>391220960) valid=false;	// Apply same limits as we have for %s (+391220960 , -39171945)
+	 else if(neg && y>39171945) valid=false;
+	 if(neg) y= -y;
+	 if(valid) *tm_year=y-1900;
+	}
+ *s=p; // as ya_strptime() returns NULL if not valid there is no need to leave *s unchanged
+ return valid;
+#endif
+}
+
+static bool strp_tzoff(const char **s)
+{/* %z : set strp_tz.tz_off_mins */
+ const char *p=*s;
+ bool valid;
+ bool negative=false;
+ if(*p=='-')
+	{negative=true;
+	 ++p;
+	}
+ else if(*p=='+') ++p; // skip sign
+ valid=isdigit(*p); /* number must start with a digit (but can be any length) */
+ if(valid)
+	{int nos_digits=1;
+	 int t=(*p++)-'0';/* process 1st digit */
+	 while(isdigit(*p))
+		{/* we have another digit of the number */
+		 t=t*10+(*p++-'0');
+		 ++nos_digits;
+		}
+	 valid=nos_digits==4; // we need exactly 4 digits
+	 if(valid)
+		{ t = 60*(t/100)+(t%100) ; // last 2 digits are minutes, first 2 digits are hours (which we multiply by 60 to get to minutes)
+		 if(negative)  strp_tz.tz_off_mins= -t;
+		 else  strp_tz.tz_off_mins=t;
+		}
+	}
+ *s=p;
+ return valid;
+}
+
 char * ya_strptime(const char *s, const char *format, struct tm *tm)
     {
     bool valid = true;
@@ -289,49 +413,13 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
                 {
             case 'a':
             case 'A': /* The weekday name, in abbreviated form or the full name */
-                valid = false;
-                for (size_t i = 0; i < 7; ++ i)
-                    {
-                    size_t len = strlen(strp_weekdays[i]);
-                    if (!strnicmp(strp_weekdays[i], s, len)) /* match to full name, strnicmp() does a case insensitive match. strncasecmp() is the equivalent POSIX function  */
-                        {
-						tm->tm_wday = (int)i;
-                        s += len;
-                        valid = true;
-                        break;
-                        }
-                    else if (!strnicmp(strp_weekdays[i], s, 3)) /* first 3 characters of weekday is an allowable abbreviation */
-                        {
-						tm->tm_wday = (int)i;
-                        s += 3;
-                        valid = true;
-                        break;
-                        }
-                    }
+                valid = strp_name(&s,strp_weekdays,7,&(tm->tm_wday));
                 if(valid) weekday_found=true;
                 break;
             case 'b':
             case 'B':
             case 'h': /* The month name, in abbreviated form or the full name.  */
-                valid = false;
-                for (size_t i = 0; i < 12; ++ i)
-                    {
-                    size_t len = strlen(strp_monthnames[i]);
-                    if (!strnicmp(strp_monthnames[i], s, len)) /* match to full name, strnicmp does a case insensitive match */
-                        {
-						tm->tm_mon =(int) i;
-                        s += len;
-                        valid = true;
-                        break;
-                        }
-                    else if (!strnicmp(strp_monthnames[i], s, 3)) /* first 3 characters of weekday is an allowable abbreviation */
-                        {
-                        tm->tm_mon =(int) i;
-                        s += 3;
-                        valid = true;
-                        break;
-                        }
-                    }
+                valid = strp_name(&s,strp_monthnames,12,&(tm->tm_mon));
                 break;
             case 'c': /* date and time C99 in C locale defines this to be %a %b %e %T %Y */
             	{char *r=ya_strptime(s,"%a %b %e %T %Y", tm);
@@ -382,22 +470,7 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
                 break;
             case 'f': /* fractional seconds (after decimal point) -> store to strp_tz.f_secs and number of digits after dp is stored in strp_tz.f_secs_p10. 
 						 Will accept as many digits as are present, but double is limited to ~ 15 significant digits */
-            	{
-            	 if(isdigit(*s))
-            	 	{uint64_t fsec=0;// the mantissa of a double is 53 bits, so 64 bits is plenty to use here [ means overflow detection can be quite simple]
-            	 	 unsigned int power10=0; // count of digits after dp
-					 valid=true;
-		 			 while(isdigit(*s) && (fsec & UINT64_C(0xf000000000000000)) == 0   )
-						{fsec=fsec*10+(uint64_t)(*s++ -'0');// note leading zeros just change power10, they do not change fsec
-			 			 power10++; // keep track of decimal point position
-						}
-		 			 if(isdigit(*s) && *s>='5') fsec++; // round if next digit present
-		 			 while(isdigit(*s)) ++s; // eat up any more digits that are present (ignore them)
-					 strp_tz.f_secs_p10=(int)power10;// number of digits entered, needed to allow "round loop exact" output (this is limited by the resolution of a double, but that should be OK here)
-		 			 strp_tz.f_secs=(double)fsec/ipow10(power10); 	 			 
-					}
-				 else valid=false;
-            	}
+            	valid = strp_fsecs(&s);
             	break;
             case 'F': /* %F Equivalent to %Y-%m-%d (the iso 8601 date format) */
             	{char *r=ya_strptime(s,"%Y-%m-%d", tm);
@@ -457,20 +530,7 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
                     ++s;
                 break;
             case 'p': // am / pm
-                if (!strnicmp(s, "am", 2))
-                    { // the hour will be 1 -> 12 maps to 12 am, 1 am .. 11 am, 12 noon 12 pm .. 11 pm
-                    if (tm->tm_hour == 12) // 12 am == 00 hours
-                        tm->tm_hour = 0;
-                    s += 2;
-                    }
-                else if (!strnicmp(s, "pm", 2))
-                    {
-                    if (tm->tm_hour < 12) // 12 pm == 12 hours
-                        tm->tm_hour += 12; // 1 pm -> 13 hours, 11 pm -> 23 hours
-                    s += 2;
-                    }
-                else
-                    valid = false;
+                valid = strp_ampm(&s,tm);
                 break;
             case 'r': // 12 hour clock %I:%M:%S %p
             	{char *r=ya_strptime(s,"%I:%M:%S %p", tm);
@@ -564,27 +624,7 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
 #ifdef POSIX_2008                
                  valid = strp_atoi(&s,&(tm->tm_year), 0, 9999, -1900);// max 4 digits
 #else			/* read in an integer with an optional sign */
-				 bool neg=false;
-            	 if(*s=='-')
-            	 	{neg=true;
-            	 	 ++s;
-            	 	}
-            	 else if(*s=='+') ++s;
-				 valid=isdigit(*s); /* number must start with a digit (but can be any length) */
-            	 if(valid)
-            	 	{
-            	 	 int y=(*s++)-'0';/* process 1st digit */
-            	 	 while(isdigit(*s))
-            	 		{/* we have another digit of the number */
-            	 		 if(y*10+(*s-'0')<y) valid=false; // overflow - we don't know the type of time_t so this test should always work
-            	 	 	 y=y*10+(*s++-'0');
-            	 		}
-            	 	 if(y>391220960) valid=false;	// Apply same limits as we have for %s (+391220960 , -39171945)
-            	 	 else if(neg && y>39171945) valid=false; 
-            	 	 if(neg) y= -y;	
-            	 	 // printf("\n%%s: y=%d\n",y);	
-					 if(valid) tm->tm_year=y-1900;				   
-					}
+				 valid = strp_year(&s,&(tm->tm_year));
 #endif                
                  per_C_found=valid;// set flag to say we have a century already
              	}	
@@ -615,29 +655,7 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
                  break;
 			case 'z': // %z Time zone offset from UTC; a leading plus sign stands for east of UTC, a minus sign or west of UTC, followed by 4 digits eg -0500 .
 #if 1			/* set strp_tz.tz_off_mins */
-				 {bool negative=false;
-				 if(*s=='-') 
-				 	{negative=true;
-				 	 ++s;
-				 	}
-				 else if(*s=='+') ++s; // skip sign
-				 valid=isdigit(*s); /* number must start with a digit (but can be any length) */
-            	 if(valid)
-            	 	{int nos_digits=1;
-            	 	 int t=(*s++)-'0';/* process 1st digit */
-            	 	 while(isdigit(*s))
-            	 		{/* we have another digit of the number */
-            	 	 	 t=t*10+(*s++-'0');
-            	 	 	 ++nos_digits;
-            	 		}
-            	 	 valid=nos_digits==4; // we need exactly 4 digits
-					 if(valid)
-					 	{ t = 60*(t/100)+(t%100) ; // last 2 digits are minutes, first 2 digits are hours (which we multiply by 60 to get to minutes)	
-					 	 if(negative)  strp_tz.tz_off_mins= -t;
-					 	 else  strp_tz.tz_off_mins=t;
-					 	}
-            	 	}
-            	 }
+				valid = strp_tzoff(&s);
 				// use  strp_tz.tz_off_mins= -1; 
 #else  			/* Just check - do not do anything with the value. */
 				if(*s=='+' || *s=='-') ++s; // leading sign (required)
@@ -806,3 +824,196 @@ char * ya_strptime(const char *s, const char *format, struct tm *tm)
 #pragma GCC diagnostic pop
 	}
 
+/* Compiled formats.
+   When lots of date/times are read using the same format (eg the x column of a csv file) ya_strptime() spends much of its time interpreting the format string.
+   ya_strptime_compile() does this once, turning the format into a list of simple operations which ya_strptime_exec() then applies to each string.
+   The result is identical to ya_strptime() with the same format (including setting strp_tz), but only the most common conversion specifiers are supported -
+   if the format uses anything else (eg the week based specifiers) ya_strptime_compile() returns NULL and ya_strptime() should be used instead.
+   ya_strptime_mktime() converts the result to seconds like ya_mktime_tm(), but remembers the seconds at the start of the last day seen,
+   so when consecutive lines are on the same day (the normal case) only the time of day has to be added.
+*/
+#define STRP_MAX_OPS 64 /* max number of operations in a compiled format */
+enum strp_op_type {STRP_LIT,STRP_SPACE,STRP_NUM,STRP_E,STRP_YEAR,STRP_Y2,STRP_WDAY,STRP_MON,STRP_FSECS,STRP_AMPM,STRP_TZOFF};
+struct strp_op
+	{unsigned char type; // enum strp_op_type
+	 char c; // character for STRP_LIT
+	 unsigned short field; // offsetof() field in struct tm for STRP_NUM
+	 unsigned int low,high; // limits for STRP_NUM (high also sets the max number of digits)
+	 int offset; // added to value for STRP_NUM
+	};
+
+struct s_strp_compiled
+	{int nos_ops;
+	 struct strp_op ops[STRP_MAX_OPS];
+	 bool day_valid; // true when the values below are valid
+	 int day_year,day_mon,day_mday,day_yday; // date of the last day seen by ya_strptime_mktime()
+	 time_t day_secs; // seconds at the start of that day
+	};
+
+static bool strp_add_op(strp_compiled *c,enum strp_op_type type,char ch,size_t field,unsigned int low,unsigned int high,int offset)
+{struct strp_op *op;
+ if(c->nos_ops>=STRP_MAX_OPS) return false;
+ op=&c->ops[c->nos_ops++];
+ op->type=(unsigned char)type;
+ op->c=ch;
+ op->field=(unsigned short)field;
+ op->low=low;
+ op->high=high;
+ op->offset=offset;
+ return true;
+}
+
+static bool strp_compile_ops(strp_compiled *c,const char *format,bool *per_Y_found,bool *per_y_found,bool *tz_set)
+{// add operations for format to c, returns false if format cannot be compiled
+ // ya_strptime() calls itself recursively for %T etc which re-initialises strp_tz, so these are only expanded in line if that makes no difference
+ for(;*format;++format)
+	{if(*format!='%')
+		{if(isspace((int)*format))
+			{if(!strp_add_op(c,STRP_SPACE,0,0,0,0,0)) return false;
+			}
+		 else if(!strp_add_op(c,STRP_LIT,*format,0,0,0,0)) return false;
+		 continue;
+		}
+	 ++format;
+	 if(*format=='E' || *format=='O') ++format;// ignore E & O modifiers (as in C locale)
+	 bool ok;
+	 const char *sub=NULL; // format to expand in line
+	 switch(*format)
+		{case 'a':
+		 case 'A': ok=strp_add_op(c,STRP_WDAY,0,0,0,0,0); break;
+		 case 'b':
+		 case 'B':
+		 case 'h': ok=strp_add_op(c,STRP_MON,0,0,0,0,0); break;
+		 case 'd': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_mday),1,31,0); break;
+		 case 'e': ok=strp_add_op(c,STRP_E,0,0,0,0,0); break;
+		 case 'f': ok=strp_add_op(c,STRP_FSECS,0,0,0,0,0); *tz_set=true; break;
+		 case 'H': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_hour),0,23,0); break;
+		 case 'I': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_hour),1,12,0); break;
+		 case 'j': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_yday),1,366,-1); break;
+		 case 'm': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_mon),1,12,-1); break;
+		 case 'M': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_min),0,59,0); break;
+		 case 'n':
+		 case 't': ok=strp_add_op(c,STRP_SPACE,0,0,0,0,0); break;
+		 case 'p': ok=strp_add_op(c,STRP_AMPM,0,0,0,0,0); break;
+		 case 'S': ok=strp_add_op(c,STRP_NUM,0,offsetof(struct tm,tm_sec),0,60,0); break;
+		 case 'y': ok=strp_add_op(c,STRP_Y2,0,0,0,0,0); *per_y_found=true; break;
+		 case 'Y': ok=strp_add_op(c,STRP_YEAR,0,0,0,0,0); *per_Y_found=true; break;
+		 case 'z': ok=strp_add_op(c,STRP_TZOFF,0,0,0,0,0); *tz_set=true; break;
+		 case '%': ok=strp_add_op(c,STRP_LIT,'%',0,0,0,0); break;
+		 case 'D':
+		 case 'x': sub="%m/%d/%y"; break;
+		 case 'F': sub="%Y-%m-%d"; break;
+		 case 'r': sub="%I:%M:%S %p"; break;
+		 case 'R': sub="%H:%M"; break;
+		 case 'T':
+		 case 'X': sub="%H:%M:%S"; break;
+		 default: ok=false; // not supported (or format ends in %) - use ya_strptime()
+		}
+	 if(sub!=NULL)
+		{// ya_strptime() resets strp_tz and %C/%Y found for sub
+		 bool sub_Y=false,sub_y=false;
+		 if(*tz_set) return false;
+		 ok=strp_compile_ops(c,sub,&sub_Y,&sub_y,tz_set);
+		 *per_Y_found|=sub_Y;
+		 *per_y_found|=sub_y;
+		}
+	 if(!ok) return false;
+	}
+ return true;
+}
+
+strp_compiled *ya_strptime_compile(const char *format) /* compile format for use by ya_strptime_exec(), returns NULL if format cannot be compiled (then use ya_strptime() ) */
+{strp_compiled *c;
+ bool per_Y_found=false,per_y_found=false,tz_set=false;
+ if(format==NULL) return NULL;
+ c=(strp_compiled *)calloc(1,sizeof(strp_compiled));
+ if(c==NULL) return NULL;
+ if(!strp_compile_ops(c,format,&per_Y_found,&per_y_found,&tz_set) || (per_Y_found && per_y_found))
+	{// %y after %Y depends on the order of the fields, so leave that to ya_strptime()
+	 free(c);
+	 return NULL;
+	}
+ return c;
+}
+
+void ya_strptime_free(strp_compiled *c) /* free memory used by ya_strptime_compile(). c may be NULL */
+{free(c);
+}
+
+char * ya_strptime_exec(strp_compiled *c,const char *s, struct tm *tm) /* as ya_strptime(s,format,tm) where c=ya_strptime_compile(format), but all fields of tm are set to zero first */
+{bool valid;
+ const struct strp_op *op=c->ops,*end=c->ops+c->nos_ops;
+ init_strp_tz(&strp_tz); // as ya_strptime()
+ if(s == NULL || tm == NULL ) return NULL;
+ memset(tm,0,sizeof(struct tm));
+ for(;op<end;++op)
+	{if(*s==0) return NULL; // ran out of input before the end of the format
+	 switch(op->type)
+		{case STRP_LIT:
+			if(*s!=op->c) return NULL;
+			++s;
+			break;
+		 case STRP_SPACE:
+			while (isspace((int)*s))
+				++s;
+			break;
+		 case STRP_NUM:
+			if(!strp_atoi(&s,(int *)((char *)tm+op->field),op->low,op->high,op->offset)) return NULL;
+			break;
+		 case STRP_E:
+			if(isspace(*s))
+				{++s;
+				 valid = strp_atoi(&s, &(tm->tm_mday), 1, 9, 0);
+				}
+			else
+				valid = strp_atoi(&s, &(tm->tm_mday), 1, 31, 0);
+			if(!valid) return NULL;
+			break;
+		 case STRP_YEAR:
+			if(!strp_year(&s,&(tm->tm_year))) return NULL;
+			break;
+		 case STRP_Y2:
+			{int y;
+			 if(!strp_atoi(&s,&y,0,99,0)) return NULL;
+			 if(y<69) y+=100; // 2000-2068, otherwise 1969-1999
+			 tm->tm_year=y;
+			}
+			break;
+		 case STRP_WDAY:
+			if(!strp_name(&s,strp_weekdays,7,&(tm->tm_wday))) return NULL;
+			break;
+		 case STRP_MON:
+			if(!strp_name(&s,strp_monthnames,12,&(tm->tm_mon))) return NULL;
+			break;
+		 case STRP_FSECS:
+			if(!strp_fsecs(&s)) return NULL;
+			break;
+		 case STRP_AMPM:
+			if(!strp_ampm(&s,tm)) return NULL;
+			break;
+		 case STRP_TZOFF:
+			if(!strp_tzoff(&s)) return NULL;
+			break;
+		}
+	}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+ return (char *)s;
+#pragma GCC diagnostic pop
+}
+
+time_t ya_strptime_mktime(strp_compiled *c,const struct tm *tm) /* returns ya_mktime_tm(tm) (tm as set by ya_strptime_exec()), only recalculating the start of the day when the date changes */
+{if(!c->day_valid || tm->tm_mday!=c->day_mday || tm->tm_mon!=c->day_mon || tm->tm_year!=c->day_year || tm->tm_yday!=c->day_yday)
+	{struct tm day=*tm;
+	 day.tm_hour=0;
+	 day.tm_min=0;
+	 day.tm_sec=0;
+	 c->day_secs=ya_mktime_tm(&day);
+	 c->day_year=tm->tm_year;
+	 c->day_mon=tm->tm_mon;
+	 c->day_mday=tm->tm_mday;
+	 c->day_yday=tm->tm_yday;
+	 c->day_valid=true;
+	}
+ return c->day_secs+((time_t)tm->tm_hour*60+tm->tm_min)*60+tm->tm_sec;
+}
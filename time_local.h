@@ -19,6 +19,11 @@
     #endif 
 	
 	char * ya_strptime(const char *s, const char *format, struct tm *tm);// in strptime.c 
+	typedef struct s_strp_compiled strp_compiled; // a format "compiled" by ya_strptime_compile() so it can be used quickly many times
+	strp_compiled *ya_strptime_compile(const char *format); // returns NULL if format cannot be compiled (or no RAM), in which case use ya_strptime()
+	char * ya_strptime_exec(strp_compiled *c,const char *s, struct tm *tm); // same result as ya_strptime() with the format used to create c, but sets all of tm to zero first
+	time_t ya_strptime_mktime(strp_compiled *c,const struct tm *tm); // same as ya_mktime_tm(tm), but caches the start of the day so is faster when consecutive dates are the same
+	void ya_strptime_free(strp_compiled *c); // free c (which may be NULL)
 	size_t ya_strftime(char *s, size_t maxsize, const char *format, const struct tm *timeptr); // in strftime.c
 	
 	struct strp_tz_struct